@@ -0,0 +1,135 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   blend.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "blend.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ALPHA_MASK (0xffu << RrDefaultAlphaOffset)
+
+static inline RrPixel32 blend_pixel(RrPixel32 d, RrPixel32 s, gint alpha)
+{
+    guchar a, r, g, b, bgr, bgg, bgb;
+
+    /* apply the rgba's opacity as well */
+    a = ((s >> RrDefaultAlphaOffset) * alpha) >> 8;
+    r = s >> RrDefaultRedOffset;
+    g = s >> RrDefaultGreenOffset;
+    b = s >> RrDefaultBlueOffset;
+
+    /* background color */
+    bgr = d >> RrDefaultRedOffset;
+    bgg = d >> RrDefaultGreenOffset;
+    bgb = d >> RrDefaultBlueOffset;
+
+    r = bgr + (((r - bgr) * a) >> 8);
+    g = bgg + (((g - bgg) * a) >> 8);
+    b = bgb + (((b - bgb) * a) >> 8);
+
+    return ((r << RrDefaultRedOffset) |
+            (g << RrDefaultGreenOffset) |
+            (b << RrDefaultBlueOffset));
+}
+
+void RrBlendRowScalar(RrPixel32 *target, const RrPixel32 *source, gint n,
+                      gint alpha)
+{
+    for (; n > 0; --n, ++target, ++source)
+        *target = blend_pixel(*target, *source, alpha);
+}
+
+#if defined(__SSE2__) && RrDefaultAlphaOffset == 24
+
+/*! Blend two pixels which have been unpacked into 16 bit lanes.  The
+  difference between the source and target is multiplied in 32 bit lanes,
+  since it can be negative and does not fit in 16 bits, and the arithmetic
+  shift rounds it down the same as the scalar code does. */
+static inline __m128i blend_two(__m128i s, __m128i d, __m128i alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a, m, lo, hi;
+
+    /* copy each pixel's alpha into all four of its lanes */
+    a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    /* apply the opacity, this is at most 255 * 255 */
+    a = _mm_srli_epi16(_mm_mullo_epi16(a, alpha), 8);
+
+    /* s * a - d * a for each channel of the first pixel, then the second */
+    m = _mm_unpacklo_epi16(a, _mm_sub_epi16(zero, a));
+    lo = _mm_madd_epi16(_mm_unpacklo_epi16(s, d), m);
+    m = _mm_unpackhi_epi16(a, _mm_sub_epi16(zero, a));
+    hi = _mm_madd_epi16(_mm_unpackhi_epi16(s, d), m);
+
+    /* d + ((s - d) * a >> 8) */
+    lo = _mm_add_epi32(_mm_srai_epi32(lo, 8), _mm_unpacklo_epi16(d, zero));
+    hi = _mm_add_epi32(_mm_srai_epi32(hi, 8), _mm_unpackhi_epi16(d, zero));
+    return _mm_packs_epi32(lo, hi);
+}
+
+void RrBlendRow(RrPixel32 *target, const RrPixel32 *source, gint n,
+                gint alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32(ALPHA_MASK);
+    const __m128i valpha = _mm_set1_epi16(alpha);
+
+    /* four pixels at a time */
+    for (; n >= 4; n -= 4, target += 4, source += 4) {
+        __m128i s, d, r;
+
+        s = _mm_loadu_si128((const __m128i*)source);
+        d = _mm_loadu_si128((const __m128i*)target);
+
+        /* fully transparent pixels leave the target's color as it is, so
+           runs of them (like the empty rows and edges around most icons)
+           only need the alpha cleared */
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask),
+                                              zero)) == 0xffff)
+            r = d;
+        else
+            r = _mm_packus_epi16(blend_two(_mm_unpacklo_epi8(s, zero),
+                                           _mm_unpacklo_epi8(d, zero),
+                                           valpha),
+                                 blend_two(_mm_unpackhi_epi8(s, zero),
+                                           _mm_unpackhi_epi8(d, zero),
+                                           valpha));
+
+        /* the alpha channel is cleared */
+        _mm_storeu_si128((__m128i*)target, _mm_andnot_si128(amask, r));
+    }
+
+    RrBlendRowScalar(target, source, n, alpha);
+}
+
+#else
+
+void RrBlendRow(RrPixel32 *target, const RrPixel32 *source, gint n,
+                gint alpha)
+{
+    for (; n > 0; --n, ++target, ++source) {
+        /* transparent pixels only clear the alpha channel */
+        if (!(*source & ALPHA_MASK))
+            *target &= ~ALPHA_MASK;
+        else
+            *target = blend_pixel(*target, *source, alpha);
+    }
+}
+
+#endif
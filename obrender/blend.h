@@ -0,0 +1,34 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   blend.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __blend_h
+#define __blend_h
+
+#include "render.h"
+
+/*! Blend a row of n source pixels over the target pixels, using the source's
+  alpha channel multiplied by the given alpha (0-255).  The target's alpha
+  channel is cleared.  This uses vector instructions where they are
+  available, and always gives the same results as RrBlendRowScalar. */
+void RrBlendRow(RrPixel32 *target, const RrPixel32 *source, gint n,
+                gint alpha);
+
+/*! The plain C version of RrBlendRow, one pixel at a time */
+void RrBlendRowScalar(RrPixel32 *target, const RrPixel32 *source, gint n,
+                      gint alpha);
+
+#endif
@@ -0,0 +1,212 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   blendtest.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Checks that RrBlendRow and RrBlendRowScalar give exactly the same pixels
+   as the loop that DrawRGBA used before them.  Run it as "blendtest bench" to
+   also time them both on icon sized images.
+*/
+
+#include "blend.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAXW 67
+
+static guint failures = 0;
+
+/*! The blending loop from DrawRGBA, as it was before RrBlendRow */
+static void blend_original(RrPixel32 *dest, const RrPixel32 *source,
+                           gint num_pixels, gint alpha)
+{
+    while (num_pixels-- > 0) {
+        guchar a, r, g, b, bgr, bgg, bgb;
+
+        /* apply the rgba's opacity as well */
+        a = ((*source >> RrDefaultAlphaOffset) * alpha) >> 8;
+        r = *source >> RrDefaultRedOffset;
+        g = *source >> RrDefaultGreenOffset;
+        b = *source >> RrDefaultBlueOffset;
+
+        /* background color */
+        bgr = *dest >> RrDefaultRedOffset;
+        bgg = *dest >> RrDefaultGreenOffset;
+        bgb = *dest >> RrDefaultBlueOffset;
+
+        r = bgr + (((r - bgr) * a) >> 8);
+        g = bgg + (((g - bgg) * a) >> 8);
+        b = bgb + (((b - bgb) * a) >> 8);
+
+        *dest = ((r << RrDefaultRedOffset) |
+                 (g << RrDefaultGreenOffset) |
+                 (b << RrDefaultBlueOffset));
+
+        dest++;
+        source++;
+    }
+}
+
+static void check_one(const gchar *name,
+                      void (*blend)(RrPixel32*, const RrPixel32*, gint, gint),
+                      const RrPixel32 *source, const RrPixel32 *target,
+                      const RrPixel32 *expected, gint n, gint alpha)
+{
+    RrPixel32 b[MAXW];
+    gint i;
+
+    memcpy(b, target, n * sizeof(RrPixel32));
+    blend(b, source, n, alpha);
+
+    if (memcmp(expected, b, n * sizeof(RrPixel32))) {
+        for (i = 0; expected[i] == b[i]; ++i);
+        if (++failures <= 10)
+            fprintf(stderr, "%s mismatch with %d pixels, alpha %d at pixel "
+                    "%d: source 0x%08x target 0x%08x expected 0x%08x "
+                    "got 0x%08x\n", name,
+                    n, alpha, i, source[i], target[i], expected[i], b[i]);
+    }
+}
+
+static void check_row(const RrPixel32 *source, const RrPixel32 *target,
+                      gint n, gint alpha)
+{
+    RrPixel32 a[MAXW];
+
+    memcpy(a, target, n * sizeof(RrPixel32));
+    blend_original(a, source, n, alpha);
+
+    check_one("scalar", RrBlendRowScalar, source, target, a, n, alpha);
+    check_one("vector", RrBlendRow, source, target, a, n, alpha);
+}
+
+/*! Every combination of source alpha, opacity and channel value, in every
+  position of a vector */
+static void test_exhaustive(void)
+{
+    RrPixel32 source[8], target[8];
+    gint sa, alpha, c, i;
+
+    for (alpha = 0; alpha <= 255; ++alpha)
+        for (sa = 0; sa <= 255; ++sa)
+            for (c = 0; c <= 255; ++c) {
+                for (i = 0; i < 8; ++i) {
+                    source[i] = (sa << RrDefaultAlphaOffset) |
+                        (c << RrDefaultRedOffset) |
+                        ((255 - c) << RrDefaultGreenOffset) |
+                        (((c + i * 37) & 0xff) << RrDefaultBlueOffset);
+                    target[i] = (i << RrDefaultAlphaOffset) |
+                        (((255 - c + i) & 0xff) << RrDefaultRedOffset) |
+                        (c << RrDefaultGreenOffset) |
+                        (((c * 7) & 0xff) << RrDefaultBlueOffset);
+                }
+                check_row(source, target, 8, alpha);
+            }
+}
+
+/*! Random rows of every length, with runs of transparent and opaque pixels
+  like an icon has, at every alignment */
+static void test_random(GRand *r)
+{
+    RrPixel32 source[MAXW + 4], target[MAXW + 4];
+    gint n, round, i;
+
+    for (round = 0; round < 2000; ++round)
+        for (n = 0; n < MAXW; ++n) {
+            gint off = g_rand_int_range(r, 0, 4);
+            gint alpha = g_rand_boolean(r) ? 255 : g_rand_int_range(r, 0, 256);
+
+            for (i = 0; i < n + off; ++i) {
+                RrPixel32 a;
+
+                switch (g_rand_int_range(r, 0, 3)) {
+                case 0: a = 0; break;
+                case 1: a = 0xff; break;
+                default: a = g_rand_int_range(r, 0, 256); break;
+                }
+                source[i] = (g_rand_int(r) & ~(0xffu << RrDefaultAlphaOffset))
+                    | (a << RrDefaultAlphaOffset);
+                target[i] = g_rand_int(r);
+            }
+            check_row(source + off, target + off, n, alpha);
+        }
+}
+
+static void bench(const gchar *name, gint opaque,
+                  void (*blend)(RrPixel32*, const RrPixel32*, gint, gint))
+{
+    const gint w = 48, h = 48, loops = 20000;
+    RrPixel32 *source, *target;
+    GTimer *timer;
+    gint i, x, y;
+    gdouble secs;
+
+    source = g_new(RrPixel32, w * h);
+    target = g_new(RrPixel32, w * h);
+
+    /* a round icon, opaque in the middle with a soft edge */
+    for (y = 0; y < h; ++y)
+        for (x = 0; x < w; ++x) {
+            gint dx = x - w / 2, dy = y - h / 2;
+            gint d = dx * dx + dy * dy;
+            RrPixel32 a = d < 400 ? 255 : (d < 576 ? 576 - d : 0);
+
+            if (!opaque) a /= 2;
+            source[y * w + x] = (a << RrDefaultAlphaOffset) |
+                (x * 5 << RrDefaultRedOffset) |
+                (y * 5 << RrDefaultGreenOffset) | 0x40;
+        }
+
+    timer = g_timer_new();
+    for (i = 0; i < loops; ++i) {
+        for (y = 0; y < w * h; ++y)
+            target[y] = 0x00808080;
+        for (y = 0; y < h; ++y)
+            blend(target + y * w, source + y * w, w, 255);
+    }
+    secs = g_timer_elapsed(timer, NULL);
+    printf("%-8s %-11s %8.1f Mpixels/s\n", name,
+           opaque ? "opaque icon" : "translucent",
+           (gdouble)w * h * loops / secs / 1e6);
+
+    g_timer_destroy(timer);
+    g_free(source);
+    g_free(target);
+}
+
+gint main(gint argc, gchar **argv)
+{
+    GRand *r = g_rand_new_with_seed(1);
+
+    test_exhaustive();
+    test_random(r);
+    g_rand_free(r);
+
+    if (failures) {
+        printf("FAILED: %u rows did not match\n", failures);
+        return 1;
+    }
+    printf("OK: blended rows match the original blending\n");
+
+    if (argc > 1 && !strcmp(argv[1], "bench")) {
+        bench("scalar", TRUE, RrBlendRowScalar);
+        bench("vector", TRUE, RrBlendRow);
+        bench("scalar", FALSE, RrBlendRowScalar);
+        bench("vector", FALSE, RrBlendRow);
+    }
+    return 0;
+}
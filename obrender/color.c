@@ -21,6 +21,7 @@
 #include "render.h"
 #include "color.h"
 #include "instance.h"
+#include "xrender.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -117,12 +118,28 @@ void RrColorFree(RrColor *c)
             if (c->pixel) XFreeColors(RrDisplay(c->inst), RrColormap(c->inst),
                                       &c->pixel, 1, 0);
             if (c->gc) XFreeGC(RrDisplay(c->inst), c->gc);
+#ifdef USE_XRENDER
+            RrXRenderForget(c);
+#endif
             g_slice_free(RrColor, c);
         }
     }
 }
 
-void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
+/*! Returns TRUE if the pixels are already in the image's format, so that
+  RrReduceDepth points the image at them instead of writing into its data */
+gboolean RrReduceDepthInPlace(const RrInstance *inst, const XImage *im)
+{
+    return im->bits_per_pixel == 32 &&
+        RrRedOffset(inst) == RrDefaultRedOffset &&
+        RrGreenOffset(inst) == RrDefaultGreenOffset &&
+        RrBlueOffset(inst) == RrDefaultBlueOffset;
+}
+
+/*! Converts the pixels into the image.  The rows of data are stride pixels
+  long, only the image's width of each is used. */
+void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, gint stride,
+                   XImage *im)
 {
     gint r, g, b;
     gint x,y;
@@ -137,9 +154,7 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
     RrPixel8  *p8  = (RrPixel8 *)  im->data;
     switch (im->bits_per_pixel) {
     case 32:
-        if ((ro != RrDefaultRedOffset) ||
-            (bo != RrDefaultBlueOffset) ||
-            (go != RrDefaultGreenOffset)) {
+        if (!RrReduceDepthInPlace(inst, im)) {
             for (y = 0; y < im->height; y++) {
                 for (x = 0; x < im->width; x++) {
                     r = (data[x] >> RrDefaultRedOffset) & 0xFF;
@@ -147,10 +162,14 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
                     b = (data[x] >> RrDefaultBlueOffset) & 0xFF;
                     p32[x] = (r << ro) + (g << go) + (b << bo);
                 }
-                data += im->width;
-                p32 += im->width;
+                data += stride;
+                p32 += im->bytes_per_line/4;
             }
-        } else im->data = (gchar*) data;
+        } else {
+            /* send the rows straight from the pixel data */
+            im->data = (gchar*) data;
+            im->bytes_per_line = stride * 4;
+        }
         break;
     case 24:
     {
@@ -169,7 +188,7 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
                 p8[outx+goff] = g;
                 p8[outx+boff] = b;
             }
-            data += im->width;
+            data += stride;
             p8 += im->bytes_per_line;
         }
         break;
@@ -185,7 +204,7 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
                 b = b >> bs;
                 p16[x] = (r << ro) + (g << go) + (b << bo);
             }
-            data += im->width;
+            data += stride;
             p16 += im->bytes_per_line/2;
         }
         break;
@@ -201,7 +220,7 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
                     b = b >> bs;
                     p8[x] = (r << ro) + (g << go) + (b << bo);
                 }
-                data += im->width;
+                data += stride;
                 p8 += im->bytes_per_line;
             }
         } else {
@@ -212,7 +231,7 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
                                         data[x] >> RrDefaultGreenOffset,
                                         data[x] >> RrDefaultBlueOffset)->pixel;
                 }
-                data += im->width;
+                data += stride;
                 p8 += im->bytes_per_line;
             }
         }
@@ -45,7 +45,9 @@ struct _RrColor {
 
 void RrColorAllocateGC(RrColor *in);
 XColor *RrPickColor(const RrInstance *inst, gint r, gint g, gint b);
-void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im);
+gboolean RrReduceDepthInPlace(const RrInstance *inst, const XImage *im);
+void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, gint stride,
+                   XImage *im);
 void RrIncreaseDepth(const RrInstance *inst, RrPixel32 *data, XImage *im);
 
 #endif /* __color_h */
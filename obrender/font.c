@@ -31,6 +31,121 @@
 #include <stdlib.h>
 #include <locale.h>
 
+/*! How many laid out strings to keep for each font.  The label appearances
+  are shared by every frame, so this holds the titles of the windows that are
+  being redrawn as the focus moves around, rather than just the last one. */
+#define FONT_LAYOUT_CACHE 64
+
+typedef struct _RrFontLayout RrFontLayout;
+
+/*! A string laid out in a font.  The text, width, ellipsizing and shortcut
+  are what pango shapes the string with, so any of them changing needs a new
+  layout.  The colors are only given when it is drawn. */
+struct _RrFontLayout {
+    gchar *text;
+    gint width;              /* in pango units, -1 for no limit */
+    PangoEllipsizeMode ell;
+    gboolean flow;
+    gint shortcut;           /* the byte to underline, or -1 */
+    PangoLayout *layout;
+    GList *link;             /* in the font's layouts_lru */
+};
+
+static guint layouts_shaped = 0;
+static guint layouts_reused = 0;
+
+static guint layout_hash(gconstpointer k)
+{
+    const RrFontLayout *l = k;
+
+    return g_str_hash(l->text) ^ ((guint)l->width * 31) ^
+        ((guint)l->shortcut << 8) ^ (l->ell << 2) ^ l->flow;
+}
+
+static gboolean layout_equal(gconstpointer a, gconstpointer b)
+{
+    const RrFontLayout *la = a, *lb = b;
+
+    return (la->width == lb->width && la->ell == lb->ell &&
+            la->flow == lb->flow && la->shortcut == lb->shortcut &&
+            !strcmp(la->text, lb->text));
+}
+
+static void layout_free(gpointer data)
+{
+    RrFontLayout *l = data;
+
+    g_object_unref(l->layout);
+    g_free(l->text);
+    g_slice_free(RrFontLayout, l);
+}
+
+/*! Get the string laid out in the font with the given options, reusing the
+  one from the last time it was asked for if it is still cached */
+static PangoLayout *font_layout(const RrFont *f, const gchar *str, gint width,
+                                PangoEllipsizeMode ell, gboolean flow,
+                                gint shortcut)
+{
+    RrFontLayout key, *l;
+
+    /* without a width the ellipsizing does nothing */
+    if (width < 0) {
+        width = -1;
+        ell = PANGO_ELLIPSIZE_NONE;
+    }
+
+    key.text = (gchar*)str;
+    key.width = width;
+    key.ell = ell;
+    key.flow = flow;
+    key.shortcut = shortcut;
+
+    if ((l = g_hash_table_lookup(f->layouts, &key))) {
+        /* move it to the front */
+        g_queue_unlink(f->layouts_lru, l->link);
+        g_queue_push_head_link(f->layouts_lru, l->link);
+        ++layouts_reused;
+        return l->layout;
+    }
+
+    if (g_queue_get_length(f->layouts_lru) >= FONT_LAYOUT_CACHE)
+        g_hash_table_remove(f->layouts, g_queue_pop_tail(f->layouts_lru));
+
+    l = g_slice_new(RrFontLayout);
+    *l = key;
+    l->text = g_strdup(str);
+    l->layout = pango_layout_new(f->inst->pango);
+    pango_layout_set_font_description(l->layout, f->font_desc);
+    pango_layout_set_wrap(l->layout, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_text(l->layout, str, -1);
+    pango_layout_set_width(l->layout, width);
+    pango_layout_set_ellipsize(l->layout, ell);
+    pango_layout_set_single_paragraph_mode(l->layout, !flow);
+
+    if (shortcut >= 0) {
+        const gchar *s = str + shortcut;
+        PangoAttrList *attrlist;
+        PangoAttribute *underline;
+
+        underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
+        underline->start_index = shortcut;
+        underline->end_index = shortcut + (g_utf8_next_char(s) - s);
+
+        attrlist = pango_attr_list_new();
+        /* the underline is owned by the attrlist */
+        pango_attr_list_insert(attrlist, underline);
+        /* the attributes are owned by the layout */
+        pango_layout_set_attributes(l->layout, attrlist);
+        pango_attr_list_unref(attrlist);
+    }
+
+    g_queue_push_head(f->layouts_lru, l);
+    l->link = g_queue_peek_head_link(f->layouts_lru);
+    g_hash_table_insert(f->layouts, l, l);
+    ++layouts_shaped;
+    return l->layout;
+}
+
 static void measure_font(const RrInstance *inst, RrFont *f)
 {
     PangoFontMetrics *metrics;
@@ -66,23 +181,14 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     RrFont *out;
     PangoWeight pweight;
     PangoStyle pstyle;
-    PangoAttrList *attrlist;
 
     out = g_slice_new(RrFont);
     out->inst = inst;
     out->ref = 1;
     out->font_desc = pango_font_description_new();
-    out->layout = pango_layout_new(inst->pango);
-    out->shortcut_underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
-    out->shortcut_underline->start_index = 0;
-    out->shortcut_underline->end_index = 0;
-
-    attrlist = pango_attr_list_new();
-    /* shortcut_underline is owned by the attrlist */
-    pango_attr_list_insert(attrlist, out->shortcut_underline);
-    /* the attributes are owned by the layout */
-    pango_layout_set_attributes(out->layout, attrlist);
-    pango_attr_list_unref(attrlist);
+    out->layouts = g_hash_table_new_full(layout_hash, layout_equal,
+                                         NULL, layout_free);
+    out->layouts_lru = g_queue_new();
 
     switch (weight) {
     case RR_FONTWEIGHT_LIGHT:     pweight = PANGO_WEIGHT_LIGHT;     break;
@@ -106,10 +212,6 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     pango_font_description_set_style(out->font_desc, pstyle);
     pango_font_description_set_size(out->font_desc, size * PANGO_SCALE);
 
-    /* setup the layout */
-    pango_layout_set_font_description(out->layout, out->font_desc);
-    pango_layout_set_wrap(out->layout, PANGO_WRAP_WORD_CHAR);
-
     /* get the ascent and descent */
     measure_font(inst, out);
 
@@ -131,7 +233,8 @@ void RrFontClose(RrFont *f)
 {
     if (f) {
         if (--f->ref < 1) {
-            g_object_unref(f->layout);
+            g_hash_table_destroy(f->layouts);
+            g_queue_free(f->layouts_lru);
             pango_font_description_free(f->font_desc);
             g_slice_free(RrFont, f);
         }
@@ -143,23 +246,18 @@ static void font_measure_full(const RrFont *f, const gchar *str,
                               gboolean flow, gint maxwidth)
 {
     PangoRectangle rect;
+    PangoLayout *layout;
 
-    pango_layout_set_text(f->layout, str, -1);
-    if (flow) {
-        pango_layout_set_single_paragraph_mode(f->layout, FALSE);
-        pango_layout_set_width(f->layout, maxwidth * PANGO_SCALE);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_NONE);
-    }
-    else {
+    if (flow)
+        layout = font_layout(f, str, maxwidth * PANGO_SCALE,
+                             PANGO_ELLIPSIZE_NONE, TRUE, -1);
+    else
         /* single line mode */
-        pango_layout_set_single_paragraph_mode(f->layout, TRUE);
-        pango_layout_set_width(f->layout, -1);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_MIDDLE);
-    }
+        layout = font_layout(f, str, -1, PANGO_ELLIPSIZE_NONE, FALSE, -1);
 
     /* pango_layout_get_pixel_extents lies! this is the right way to get the
        size of the text's area */
-    pango_layout_get_extents(f->layout, NULL, &rect);
+    pango_layout_get_extents(layout, NULL, &rect);
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
     /* pass the logical rect as the ink rect, this is on purpose so we get the
@@ -187,6 +285,12 @@ RrSize *RrFontMeasureString(const RrFont *f, const gchar *str,
     return size;
 }
 
+void RrFontLayoutStats(guint *shaped, guint *reused)
+{
+    *shaped = layouts_shaped;
+    *reused = layouts_reused;
+}
+
 gint RrFontHeight(const RrFont *f, gint shadow_y)
 {
     return (f->ascent + f->descent) / PANGO_SCALE + ABS(shadow_y);
@@ -221,7 +325,7 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     XftColor c;
     gint mw;
     PangoRectangle rect;
-    PangoAttrList *attrlist;
+    PangoLayout *layout, *shadow;
     PangoEllipsizeMode ell;
 
     g_assert(!t->flow || t->maxwidth > 0);
@@ -263,14 +367,12 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
         }
     }
 
-    pango_layout_set_text(t->font->layout, t->string, -1);
-    pango_layout_set_width(t->font->layout, w * PANGO_SCALE);
-    pango_layout_set_ellipsize(t->font->layout, ell);
-    pango_layout_set_single_paragraph_mode(t->font->layout, !t->flow);
-
-    /* * * end of setting up the layout * * */
+    /* the same string in the same space is only shaped once, and redrawing
+       it in different colors reuses that */
+    layout = font_layout(t->font, t->string, w * PANGO_SCALE, ell, t->flow,
+                         t->shortcut ? (gint)t->shortcut_pos : -1);
 
-    pango_layout_get_pixel_extents(t->font->layout, NULL, &rect);
+    pango_layout_get_pixel_extents(layout, NULL, &rect);
     mw = rect.width;
 
     /* pango_layout_set_alignment doesn't work with
@@ -306,21 +408,30 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
         c.color.alpha = 0xffff * t->shadow_alpha / 255;
         c.pixel = t->shadow_color->pixel;
 
+        /* the shadow doesn't get the shortcut's underline, so it needs a
+           layout of its own.  it is cached like the text's, and the text's
+           one just went to the front so it can't be pushed out by it */
+        if (t->shortcut)
+            shadow = font_layout(t->font, t->string, w * PANGO_SCALE, ell,
+                                 t->flow, -1);
+        else
+            shadow = layout;
+
         /* see below... */
         if (!t->flow) {
             pango_xft_render_layout_line
                 (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-                 pango_layout_get_line_readonly(t->font->layout, 0),
+                 pango_layout_get_line_readonly(shadow, 0),
 #else
-                 pango_layout_get_line(t->font->layout, 0),
+                 pango_layout_get_line(shadow, 0),
 #endif
                  (x + t->shadow_offset_x) * PANGO_SCALE,
                  (y + t->shadow_offset_y) * PANGO_SCALE);
         }
         else {
-            pango_xft_render_layout(d, &c, t->font->layout,
+            pango_xft_render_layout(d, &c, shadow,
                                     (x + t->shadow_offset_x) * PANGO_SCALE,
                                     (y + t->shadow_offset_y) * PANGO_SCALE);
         }
@@ -332,22 +443,6 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     c.color.alpha = 0xff | 0xff << 8; /* fully opaque text */
     c.pixel = t->color->pixel;
 
-    if (t->shortcut) {
-        const gchar *s = t->string + t->shortcut_pos;
-
-        t->font->shortcut_underline->start_index = t->shortcut_pos;
-        t->font->shortcut_underline->end_index = t->shortcut_pos +
-            (g_utf8_next_char(s) - s);
-
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
-
     /* layout_line() uses y to specify the baseline
        The line doesn't need to be freed, it's a part of the layout */
     if (!t->flow) {
@@ -355,28 +450,16 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
             (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-             pango_layout_get_line_readonly(t->font->layout, 0),
+             pango_layout_get_line_readonly(layout, 0),
 #else
-             pango_layout_get_line(t->font->layout, 0),
+             pango_layout_get_line(layout, 0),
 #endif
              x * PANGO_SCALE,
              y * PANGO_SCALE);
     }
     else {
-        pango_xft_render_layout(d, &c, t->font->layout,
+        pango_xft_render_layout(d, &c, layout,
                                 x * PANGO_SCALE,
                                 y * PANGO_SCALE);
     }
-
-    if (t->shortcut) {
-        t->font->shortcut_underline->start_index = 0;
-        t->font->shortcut_underline->end_index = 0;
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
 }
@@ -27,8 +27,8 @@ struct _RrFont {
     const RrInstance *inst;
     gint ref;
     PangoFontDescription *font_desc;
-    PangoLayout *layout; /*!< Used for measuring and rendering strings */
-    PangoAttribute *shortcut_underline; /*< For underlining the shortcut key */
+    GHashTable *layouts; /*!< Shaped strings, RrFontLayout by their key */
+    GQueue *layouts_lru; /*!< The cached layouts, most recently used first */
     gint ascent; /*!< The font's ascent in pango-units */
     gint descent; /*!< The font's descent in pango-units */
 };
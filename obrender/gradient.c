@@ -265,28 +265,62 @@ static inline void repeat_pixel(RrPixel32 *start, gint w)
     }
 }
 
+/*! Returns TRUE if the parent relative surface is drawn with its parent's
+  settings instead of copying the parent's pixels */
+static gboolean parentrelative_rerender(const RrAppearance *a, gint w, gint h)
+{
+    /* This is a little hack. When a texture is parentrelative, and the same
+       area as the parent, and has a bevel, it will draw its bevel on top
+       of the parent's, amplifying it. So instead, rerender the child with
+       the parent's settings, but the child's bevel and interlace */
+    return (a->surface.relief != RR_RELIEF_FLAT &&
+            (a->surface.parent->surface.relief != RR_RELIEF_FLAT ||
+             a->surface.parent->surface.border) &&
+            !a->surface.parentx && !a->surface.parenty &&
+            a->surface.parent->w == w && a->surface.parent->h == h);
+}
+
+gboolean RrParentRelativePlain(const RrAppearance *a, gint w, gint h)
+{
+    /* the child's own interlace, border and bevel are drawn on top of the
+       parent's pixels */
+    return !parentrelative_rerender(a, w, h) &&
+        a->surface.relief == RR_RELIEF_FLAT &&
+        !a->surface.border &&
+        !a->surface.interlaced;
+}
+
+RrPixel32* RrParentRelativePixels(const RrAppearance *a, gint *stride,
+                                  gint *x, gint *w, gint *h)
+{
+    const RrAppearance *p = a;
+    gint y = 0;
+
+    *x = 0;
+    do {
+        *x += p->surface.parentx;
+        y += p->surface.parenty;
+        p = p->surface.parent;
+        g_assert(p && p->w);
+
+        *w = MIN(*w, p->w - *x);
+        *h = MIN(*h, p->h - y);
+    } while (p->surface.parent_view);
+
+    *stride = p->w;
+    return p->surface.pixel_data + p->w * y;
+}
+
 static void gradient_parentrelative(RrAppearance *a, gint w, gint h)
 {
     RrPixel32 *source, *dest;
-    gint sw, sh, partial_w, partial_h;
+    gint stride, x, partial_w, partial_h;
     register gint i;
 
     g_assert (a->surface.parent);
     g_assert (a->surface.parent->w);
 
-    sw = a->surface.parent->w;
-    sh = a->surface.parent->h;
-
-    /* This is a little hack. When a texture is parentrelative, and the same
-       area as the parent, and has a bevel, it will draw its bevel on top
-       of the parent's, amplifying it. So instead, rerender the child with
-       the parent's settings, but the child's bevel and interlace */
-    if (a->surface.relief != RR_RELIEF_FLAT &&
-        (a->surface.parent->surface.relief != RR_RELIEF_FLAT ||
-         a->surface.parent->surface.border) &&
-        !a->surface.parentx && !a->surface.parenty &&
-        sw == w && sh == h)
-    {
+    if (parentrelative_rerender(a, w, h)) {
         RrSurface old = a->surface;
         a->surface = a->surface.parent->surface;
 
@@ -299,21 +333,16 @@ static void gradient_parentrelative(RrAppearance *a, gint w, gint h)
         RrRender(a, w, h);
         a->surface = old;
     } else {
-        source = (a->surface.parent->surface.pixel_data +
-                  a->surface.parentx + sw * a->surface.parenty);
+        partial_w = w;
+        partial_h = h;
+        source = RrParentRelativePixels(a, &stride, &x,
+                                        &partial_w, &partial_h) + x;
         dest = a->surface.pixel_data;
 
-        if (a->surface.parentx + w > sw) {
-            partial_w = sw - a->surface.parentx;
-        } else partial_w = w;
-
-        if (a->surface.parenty + h > sh) {
-            partial_h = sh - a->surface.parenty;
-        } else partial_h = h;
-
-        for (i = 0; i < partial_h; i++, source += sw, dest += w) {
-            memcpy(dest, source, partial_w * sizeof(RrPixel32));
-        }
+        if (partial_w > 0)
+            for (i = 0; i < partial_h; i++, source += stride, dest += w) {
+                memcpy(dest, source, partial_w * sizeof(RrPixel32));
+            }
     }
 }
 
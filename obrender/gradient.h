@@ -24,4 +24,19 @@
 
 void RrRender(RrAppearance *a, gint w, gint h);
 
+/*! Returns TRUE if a parent relative surface of the given size shows just
+  its parent's pixels, and doesn't draw anything of its own */
+gboolean RrParentRelativePlain(const RrAppearance *a, gint w, gint h);
+
+/*! Find the pixels in a buffer which a parent relative surface shows.  This
+  looks through parents whose pixel_data was never filled in.
+  @param stride Returns the width of the buffer's rows
+  @param x Returns where the pixels start in the first row
+  @param w The width to show, it is reduced to what the buffer has
+  @param h The height to show, it is reduced to what the buffer has
+  @return The start of the first row of the pixels
+*/
+RrPixel32* RrParentRelativePixels(const RrAppearance *a, gint *stride,
+                                  gint *x, gint *w, gint *h);
+
 #endif /* __gradient_h */
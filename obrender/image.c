@@ -19,8 +19,10 @@
 
 #include "geom.h"
 #include "image.h"
+#include "blend.h"
 #include "color.h"
 #include "imagecache.h"
+#include "xrender.h"
 #ifdef USE_IMLIB2
 #include <Imlib2.h>
 #endif
@@ -81,9 +83,12 @@ static RrImagePic* RrImagePicNew(gint w, gint h, RrPixel32 *data)
 /*! Destroy an RrImagePic.
   This frees the RrImagePic object and everything inside it.
 */
-static void RrImagePicFree(RrImagePic *pic)
+void RrImagePicFree(RrImagePic *pic)
 {
     if (pic) {
+#ifdef USE_XRENDER
+        RrXRenderForget(pic);
+#endif
         g_free(pic->data);
         g_slice_free(RrImagePic, pic);
     }
@@ -817,7 +822,7 @@ void DrawRGBA(RrPixel32 *target, gint target_w, gint target_h,
               gint alpha, RrRect *area)
 {
     RrPixel32 *dest;
-    gint col, num_pixels;
+    gint row;
     gint dw, dh;
 
     g_assert(source_w <= area->width && source_h <= area->height);
@@ -834,39 +839,12 @@ void DrawRGBA(RrPixel32 *target, gint target_w, gint target_h,
 
     /* copy source -> dest, and apply the alpha channel.
        center the image if it is smaller than the area */
-    col = 0;
-    num_pixels = dw * dh;
     dest = target + area->x + (area->width - dw) / 2 +
         (target_w * (area->y + (area->height - dh) / 2));
-    while (num_pixels-- > 0) {
-        guchar a, r, g, b, bgr, bgg, bgb;
-
-        /* apply the rgba's opacity as well */
-        a = ((*source >> RrDefaultAlphaOffset) * alpha) >> 8;
-        r = *source >> RrDefaultRedOffset;
-        g = *source >> RrDefaultGreenOffset;
-        b = *source >> RrDefaultBlueOffset;
-
-        /* background color */
-        bgr = *dest >> RrDefaultRedOffset;
-        bgg = *dest >> RrDefaultGreenOffset;
-        bgb = *dest >> RrDefaultBlueOffset;
-
-        r = bgr + (((r - bgr) * a) >> 8);
-        g = bgg + (((g - bgg) * a) >> 8);
-        b = bgb + (((b - bgb) * a) >> 8);
-
-        *dest = ((r << RrDefaultRedOffset) |
-                 (g << RrDefaultGreenOffset) |
-                 (b << RrDefaultBlueOffset));
-
-        dest++;
-        source++;
-
-        if (++col >= dw) {
-            col = 0;
-            dest += target_w - dw;
-        }
+    for (row = 0; row < dh; ++row) {
+        RrBlendRow(dest, source, dw, alpha);
+        dest += target_w;
+        source += dw;
     }
 }
 
@@ -896,6 +874,19 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
                  rgba->alpha, area);
 }
 
+/*! Make a picture of an RGBA texture which fits into the given area.  The
+  returned picture must be freed with RrImagePicFree. */
+RrImagePic* RrImagePicForRGBA(RrTextureRGBA *rgba, RrRect *area)
+{
+    RrImagePic *scaled;
+
+    scaled = ResizeImage(rgba->data, rgba->width, rgba->height,
+                         area->width, area->height);
+    if (!scaled)
+        scaled = RrImagePicNew(rgba->width, rgba->height, rgba->data);
+    return scaled;
+}
+
 /*! Draw an RrImage texture into a target pixel buffer.  If the RrImage does
   not contain a picture of the appropriate size, then one of its "original"
   pictures will be resized and used (and stored in the RrImage as a "resized"
@@ -904,17 +895,37 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
 void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                       gint target_w, gint target_h,
                       RrRect *area)
+{
+    RrImagePic *pic;
+    gboolean free_pic;
+
+    pic = RrImagePicForArea(img, area, &free_pic);
+
+    DrawRGBA(target, target_w, target_h,
+             pic->data, pic->width, pic->height,
+             img->alpha, area);
+    if (free_pic)
+        RrImagePicFree(pic);
+}
+
+/*! Find the picture in an RrImage texture's set to draw into the given area.
+  If there is no picture of the right size, one of the "original" pictures is
+  resized and saved in the set as a "resized" picture.  If free_pic is set to
+  TRUE, then the picture was not saved and must be freed with RrImagePicFree
+  by the caller.
+*/
+RrImagePic* RrImagePicForArea(RrTextureImage *img, RrRect *area,
+                              gboolean *free_pic)
 {
     gint i, min_diff, min_i, min_aspect_diff, min_aspect_i;
     RrImage *self;
     RrImageSet *set;
     RrImagePic *pic;
-    gboolean free_pic;
 
     self = img->image;
     set = self->set;
     pic = NULL;
-    free_pic = FALSE;
+    *free_pic = FALSE;
 
     /* is there an original of this size? (only the larger of
        w or h has to be right cuz we maintain aspect ratios) */
@@ -1006,7 +1017,7 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                apparently the same image !  then next time we won't have to do
                this resizing, we will use the cache_set's pic instead. */
             set = RrImageSetMergeSets(set, cache_set);
-            free_pic = TRUE;
+            *free_pic = TRUE;
         }
         else {
             /* add the resized image to the image, as the first in the resized
@@ -1019,7 +1030,7 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                 /* add it to the resized list */
                 RrImageSetAddPicture(set, pic, FALSE);
             else
-                free_pic = TRUE; /* don't leak mem! */
+                *free_pic = TRUE; /* don't leak mem! */
         }
     }
 
@@ -1029,9 +1040,5 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
 
     g_assert(pic != NULL);
 
-    DrawRGBA(target, target_w, target_h,
-             pic->data, pic->width, pic->height,
-             img->alpha, area);
-    if (free_pic)
-        RrImagePicFree(pic);
+    return pic;
 }
@@ -29,4 +29,9 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
                      gint target_w, gint target_h,
                      RrRect *area);
 
+RrImagePic* RrImagePicForArea(RrTextureImage *img, RrRect *area,
+                              gboolean *free_pic);
+RrImagePic* RrImagePicForRGBA(RrTextureRGBA *rgba, RrRect *area);
+void RrImagePicFree(RrImagePic *pic);
+
 #endif
@@ -19,6 +19,8 @@
 
 #include "render.h"
 #include "instance.h"
+#include "xrender.h"
+#include "xshm.h"
 
 static RrInstance *definst = NULL;
 
@@ -86,6 +88,13 @@ RrInstance* RrInstanceNew (Display *display, gint screen)
         g_free (definst);
         return definst = NULL;
     }
+
+#ifdef USE_XRENDER
+    RrXRenderStartup(definst);
+#endif
+#ifdef USE_XSHM
+    RrXShmStartup(definst);
+#endif
     return definst;
 }
 
@@ -209,6 +218,12 @@ void RrInstanceFree (RrInstance *inst)
 {
     if (inst) {
         if (inst == definst) definst = NULL;
+#ifdef USE_XRENDER
+        RrXRenderShutdown(inst);
+#endif
+#ifdef USE_XSHM
+        RrXShmShutdown(inst);
+#endif
         g_free(inst->pseudo_colors);
         g_hash_table_destroy(inst->color_hash);
         g_object_unref(inst->pango);
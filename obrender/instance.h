@@ -22,6 +22,9 @@
 #include <X11/Xlib.h>
 #include <glib.h>
 #include <pango/pangoxft.h>
+#ifdef USE_XRENDER
+#include <X11/extensions/Xrender.h>
+#endif
 
 struct _RrInstance {
     Display *display;
@@ -48,6 +51,14 @@ struct _RrInstance {
     XColor *pseudo_colors;
 
     GHashTable *color_hash;
+
+#ifdef USE_XRENDER
+    /* the formats used for compositing, xrender_format is NULL if the RENDER
+       extension is not being used */
+    XRenderPictFormat *xrender_format;
+    XRenderPictFormat *xrender_format_a1;
+    XRenderPictFormat *xrender_format_argb32;
+#endif
 };
 
 guint       RrPseudoBPC    (const RrInstance *inst);
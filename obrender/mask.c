@@ -20,6 +20,7 @@
 #include "render.h"
 #include "color.h"
 #include "mask.h"
+#include "xrender.h"
 
 RrPixmapMask *RrPixmapMaskNew(const RrInstance *inst,
                               gint w, gint h, const gchar *data)
@@ -38,6 +39,10 @@ RrPixmapMask *RrPixmapMaskNew(const RrInstance *inst,
 void RrPixmapMaskFree(RrPixmapMask *m)
 {
     if (m) {
+#ifdef USE_XRENDER
+        /* free the picture before the pixmap it was made for */
+        RrXRenderForget(m);
+#endif
         XFreePixmap(RrDisplay(m->inst), m->mask);
         g_free(m->data);
         g_slice_free(RrPixmapMask, m);
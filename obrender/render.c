@@ -25,6 +25,8 @@
 #include "color.h"
 #include "image.h"
 #include "theme.h"
+#include "xrender.h"
+#include "xshm.h"
 
 #include <glib.h>
 #include <X11/Xlib.h>
@@ -37,6 +39,13 @@
 
 static void pixel_data_to_pixmap(RrAppearance *l,
                                  gint x, gint y, gint w, gint h);
+static void pixels_to_pixmap(RrAppearance *l, RrPixel32 *data, gint stride,
+                             gint sx, gint x, gint y, gint w, gint h);
+static gboolean draws_pixels(RrAppearance *a);
+#ifdef USE_XRENDER
+static void paint_background(RrAppearance *a, gint w, gint h,
+                             gboolean resized);
+#endif
 
 Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
 {
@@ -44,6 +53,9 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
     Pixmap oldp = None;
     RrRect tarea; /* area in which to draw textures */
     gboolean resized;
+#ifdef USE_XRENDER
+    Picture picture = None;
+#endif
 
     if (w <= 0 || h <= 0) return None;
 
@@ -80,8 +92,35 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
         g_free(a->surface.pixel_data);
         a->surface.pixel_data = g_new(RrPixel32, w * h);
     }
+    a->surface.parent_view = FALSE;
 
-    RrRender(a, w, h);
+#ifdef USE_XRENDER
+    if (RrXRenderEnabled(a->inst)) {
+        /* textures are composited on the server, on top of the surface,
+           so the surface can go to the pixmap right away */
+        paint_background(a, w, h, resized);
+        transferred = 1;
+        picture = RrXRenderPixmapPicture(a->inst, a->pixmap);
+    }
+    else
+#endif
+    if (a->surface.grad == RR_SURFACE_PARENTREL &&
+        RrParentRelativePlain(a, w, h) && !draws_pixels(a))
+    {
+        RrPixel32 *data;
+        gint stride, sx, pw = w, ph = h;
+
+        /* nothing will be drawn on top of the parent's pixels here, so
+           send them to the pixmap from the parent's buffer, instead of
+           copying them into this one first */
+        data = RrParentRelativePixels(a, &stride, &sx, &pw, &ph);
+        if (pw > 0 && ph > 0)
+            pixels_to_pixmap(a, data, stride, sx, 0, 0, pw, ph);
+        a->surface.parent_view = TRUE;
+        transferred = 1;
+    }
+    else
+        RrRender(a, w, h);
 
     {
         gint l, t, r, b;
@@ -128,10 +167,16 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
                     || (a->surface.interlaced))
                     pixel_data_to_pixmap(a, 0, 0, w, h);
             }
-            RrPixmapMaskDraw(a->pixmap, &a->texture[i].data.mask, &tarea);
+#ifdef USE_XRENDER
+            if (picture)
+                RrXRenderDrawMask(a->inst, picture,
+                                  &a->texture[i].data.mask, &tarea);
+            else
+#endif
+                RrPixmapMaskDraw(a->pixmap, &a->texture[i].data.mask,
+                                 &tarea);
             break;
         case RR_TEXTURE_IMAGE:
-            g_assert(!transferred);
             {
                 RrRect narea = tarea;
                 RrTextureImage *img = &a->texture[i].data.image;
@@ -143,6 +188,13 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
                     narea.width = MIN(narea.width, img->twidth);
                 if (img->theight)
                     narea.height = MIN(narea.height, img->theight);
+#ifdef USE_XRENDER
+                if (picture) {
+                    RrXRenderDrawImage(a->inst, picture, img, &narea);
+                    break;
+                }
+#endif
+                g_assert(!transferred);
                 RrImageDrawImage(a->surface.pixel_data,
                                  &a->texture[i].data.image,
                                  a->w, a->h,
@@ -151,7 +203,6 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
             force_transfer = 1;
             break;
         case RR_TEXTURE_RGBA:
-            g_assert(!transferred);
             {
                 RrRect narea = tarea;
                 RrTextureRGBA *rgb = &a->texture[i].data.rgba;
@@ -163,6 +214,13 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
                     narea.width = MIN(narea.width, rgb->twidth);
                 if (rgb->theight)
                     narea.height = MIN(narea.height, rgb->theight);
+#ifdef USE_XRENDER
+                if (picture) {
+                    RrXRenderDrawRGBA(a->inst, picture, rgb, &narea);
+                    break;
+                }
+#endif
+                g_assert(!transferred);
                 RrImageDrawRGBA(a->surface.pixel_data,
                                 &a->texture[i].data.rgba,
                                 a->w, a->h,
@@ -184,13 +242,89 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
         }
     }
 
+#ifdef USE_XRENDER
+    if (picture)
+        XRenderFreePicture(RrDisplay(a->inst), picture);
+#endif
+
     return oldp;
 }
 
+#ifdef USE_XRENDER
+/*! Put the appearance's surface into its pixmap.  Surfaces which have to be
+  rendered in software are kept on the server after they are sent, and
+  reused until the appearance is painted at a different size.  This is only
+  done for appearances that are painted in a single window. */
+static void paint_background(RrAppearance *a, gint w, gint h,
+                             gboolean resized)
+{
+    Display *d = RrDisplay(a->inst);
+    GC gc = DefaultGC(d, RrScreen(a->inst));
+
+    if ((resized || a->shared) && a->background) {
+        XFreePixmap(d, a->background);
+        a->background = None;
+    }
+
+    if (a->background) {
+        XCopyArea(d, a->background, a->pixmap, gc, 0, 0, w, h, 0, 0);
+        return;
+    }
+
+    if (a->surface.grad == RR_SURFACE_PARENTREL &&
+        RrParentRelativePlain(a, w, h))
+    {
+        const RrAppearance *p = a->surface.parent;
+        gint pw = MIN(w, p->w - a->surface.parentx);
+        gint ph = MIN(h, p->h - a->surface.parenty);
+
+        /* use what the parent already has on the server, rather than
+           copying its pixels here and sending them again */
+        if (p->surface.grad == RR_SURFACE_SOLID && !p->surface.interlaced &&
+            p->surface.relief == RR_RELIEF_FLAT && !p->surface.border)
+        {
+            /* the parent is only its color, so fill with that.  a bevel or
+               border would be in its pixel_data, and needs copying */
+            XFillRectangle(d, a->pixmap, RrColorGC(p->surface.primary),
+                           0, 0, pw, ph);
+            a->surface.parent_view = TRUE;
+            return;
+        }
+        else if (p->background) {
+            XCopyArea(d, p->background, a->pixmap, gc,
+                      a->surface.parentx, a->surface.parenty, pw, ph, 0, 0);
+            a->surface.parent_view = TRUE;
+            return;
+        }
+    }
+
+    RrRender(a, w, h);
+
+    /* solid surfaces are drawn straight into the pixmap by RrRender */
+    if (a->surface.grad != RR_SURFACE_SOLID || a->surface.interlaced) {
+        pixel_data_to_pixmap(a, 0, 0, w, h);
+
+        /* parent relative surfaces change with their position in the
+           parent, so they can't be reused */
+        if (a->surface.grad != RR_SURFACE_PARENTREL && !a->shared) {
+            a->background = XCreatePixmap(d, RrRootWindow(a->inst),
+                                          w, h, RrDepth(a->inst));
+            XCopyArea(d, a->pixmap, a->background, gc, 0, 0, w, h, 0, 0);
+        }
+    }
+}
+#endif
+
 void RrPaint(RrAppearance *a, Window win, gint w, gint h)
 {
     Pixmap oldp;
 
+    if (a->painted != win) {
+        if (a->painted != None)
+            a->shared = TRUE;
+        a->painted = win;
+    }
+
     oldp = RrPaintPixmap(a, w, h);
     XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, a->pixmap);
     XClearWindow(RrDisplay(a->inst), win);
@@ -308,11 +442,15 @@ RrAppearance *RrAppearanceCopy(RrAppearance *orig)
     spc->parent = NULL;
     spc->parentx = spc->parenty = 0;
     spc->pixel_data = NULL;
+    spc->parent_view = FALSE;
 
     copy->textures = orig->textures;
     copy->texture = g_memdup(orig->texture,
                              orig->textures * sizeof(RrTexture));
     copy->pixmap = None;
+    copy->background = None;
+    copy->painted = None;
+    copy->shared = FALSE;
     copy->xftdraw = NULL;
     copy->w = copy->h = 0;
     return copy;
@@ -324,6 +462,8 @@ void RrAppearanceFree(RrAppearance *a)
     if (a) {
         RrSurface *p;
         if (a->pixmap != None) XFreePixmap(RrDisplay(a->inst), a->pixmap);
+        if (a->background != None)
+            XFreePixmap(RrDisplay(a->inst), a->background);
         if (a->xftdraw != NULL) XftDrawDestroy(a->xftdraw);
         if (a->textures)
             g_free(a->texture);
@@ -345,23 +485,29 @@ void RrAppearanceFree(RrAppearance *a)
 static void pixel_data_to_pixmap(RrAppearance *l,
                                  gint x, gint y, gint w, gint h)
 {
-    RrPixel32 *in, *scratch;
-    Pixmap out;
+    pixels_to_pixmap(l, l->surface.pixel_data, w, 0, x, y, w, h);
+}
+
+/*! Put an area of a pixel buffer into the appearance's pixmap at x, y.  The
+  buffer's rows are stride pixels long, and the area starts at sx in the
+  first row. */
+static void pixels_to_pixmap(RrAppearance *l, RrPixel32 *data, gint stride,
+                             gint sx, gint x, gint y, gint w, gint h)
+{
+    gchar *scratch = NULL;
     XImage *im = NULL;
     im = XCreateImage(RrDisplay(l->inst), RrVisual(l->inst), RrDepth(l->inst),
                       ZPixmap, 0, NULL, w, h, 32, 0);
     g_assert(im != NULL);
 
-    in = l->surface.pixel_data;
-    out = l->pixmap;
-
-/* this malloc is a complete waste of time on normal 32bpp
-   as reduce_depth just sets im->data = data and returns
-*/
-    scratch = g_new(RrPixel32, im->width * im->height);
-    im->data = (gchar*) scratch;
-    RrReduceDepth(l->inst, in, im);
-    XPutImage(RrDisplay(l->inst), out,
+    /* only convert the area being sent.  on normal 32bpp the image just
+       points at the pixels, so there is nothing to convert them into */
+    if (!RrReduceDepthInPlace(l->inst, im)) {
+        scratch = g_malloc(im->bytes_per_line * im->height);
+        im->data = scratch;
+    }
+    RrReduceDepth(l->inst, data + sx, stride, im);
+    XPutImage(RrDisplay(l->inst), l->pixmap,
               DefaultGC(RrDisplay(l->inst), RrScreen(l->inst)),
               im, 0, 0, x, y, w, h);
     im->data = NULL;
@@ -369,6 +515,19 @@ static void pixel_data_to_pixmap(RrAppearance *l,
     g_free(scratch);
 }
 
+/*! Returns TRUE if any of the appearance's textures are drawn into its
+  pixel_data, instead of onto its pixmap */
+static gboolean draws_pixels(RrAppearance *a)
+{
+    gint i;
+
+    for (i = 0; i < a->textures; ++i)
+        if (a->texture[i].type == RR_TEXTURE_IMAGE ||
+            a->texture[i].type == RR_TEXTURE_RGBA)
+            return TRUE;
+    return FALSE;
+}
+
 void RrMargins (RrAppearance *a, gint *l, gint *t, gint *r, gint *b)
 {
     *l = *t = *r = *b = 0;
@@ -509,50 +668,76 @@ static void reverse_bits(gchar *c, gint n)
                (*c * 0x8020UL & 0x88440UL)) * 0x10101UL) >> 16;
 }
 
+/*! Read the contents of a pixmap, through shared memory when it can be.  The
+  image must be freed with free_image. */
+static XImage* get_image(const RrInstance *inst, Pixmap p,
+                         guint w, guint h, guint depth)
+{
+    XImage *im = NULL;
+
+#ifdef USE_XSHM
+    im = RrXShmGetImage(inst, p, w, h, depth);
+#endif
+    if (!im)
+        im = XGetImage(RrDisplay(inst), p, 0, 0, w, h, 0xffffffff, ZPixmap);
+    return im;
+}
+
+static void free_image(XImage *im)
+{
+#ifdef USE_XSHM
+    if (im->obdata) {
+        /* it was read through shared memory */
+        RrXShmImageFree(im);
+        return;
+    }
+#endif
+    XDestroyImage(im);
+}
+
 gboolean RrPixmapToRGBA(const RrInstance *inst,
                         Pixmap pmap, Pixmap mask,
                         gint *w, gint *h, RrPixel32 **data)
 {
     Window xr;
     gint xx, xy;
-    guint pw, ph, mw, mh, xb, xd, i, x, y, di;
-    XImage *xi, *xm = NULL;
+    guint pw, ph, mw, mh, xb, pd, md, i, x, y, di;
+    XImage *xi, *xm;
 
     if (!XGetGeometry(RrDisplay(inst), pmap,
-                      &xr, &xx, &xy, &pw, &ph, &xb, &xd))
+                      &xr, &xx, &xy, &pw, &ph, &xb, &pd))
         return FALSE;
 
     if (mask) {
         if (!XGetGeometry(RrDisplay(inst), mask,
-                          &xr, &xx, &xy, &mw, &mh, &xb, &xd))
+                          &xr, &xx, &xy, &mw, &mh, &xb, &md))
             return FALSE;
-        if (pw != mw || ph != mh || xd != 1)
+        if (pw != mw || ph != mh || md != 1)
             return FALSE;
     }
 
-    xi = XGetImage(RrDisplay(inst), pmap,
-                   0, 0, pw, ph, 0xffffffff, ZPixmap);
+    xi = get_image(inst, pmap, pw, ph, pd);
     if (!xi)
         return FALSE;
 
-    if (mask) {
-        xm = XGetImage(RrDisplay(inst), mask,
-                       0, 0, mw, mh, 0xffffffff, ZPixmap);
-        if (!xm) {
-            XDestroyImage(xi);
-            return FALSE;
-        }
-        if ((xm->bits_per_pixel == 1) && (xm->bitmap_bit_order != LSBFirst))
-            reverse_bits(xm->data, xm->bytes_per_line * xm->height);
-    }
-
     if ((xi->bits_per_pixel == 1) && (xi->bitmap_bit_order != LSBFirst))
         reverse_bits(xi->data, xi->bytes_per_line * xi->height);
 
     *data = g_new(RrPixel32, pw * ph);
     RrIncreaseDepth(inst, *data, xi);
+    free_image(xi);
 
     if (mask) {
+        /* this is read after the pixmap is converted, since they may both
+           be read into the same shared memory */
+        xm = get_image(inst, mask, mw, mh, md);
+        if (!xm) {
+            g_free(*data);
+            return FALSE;
+        }
+        if ((xm->bits_per_pixel == 1) && (xm->bitmap_bit_order != LSBFirst))
+            reverse_bits(xm->data, xm->bytes_per_line * xm->height);
+
         /* apply transparency from the mask */
         di = 0;
         for (i = 0, y = 0; y < ph; ++y) {
@@ -562,14 +747,11 @@ gboolean RrPixmapToRGBA(const RrInstance *inst,
             }
             di += xm->bytes_per_line;
         }
+        free_image(xm);
     }
 
     *w = pw;
     *h = ph;
 
-    XDestroyImage(xi);
-    if (mask)
-        XDestroyImage(xm);
-
     return TRUE;
 }
@@ -138,6 +138,9 @@ struct _RrSurface {
     gint parentx;
     gint parenty;
     RrPixel32 *pixel_data;
+    /* TRUE when pixel_data was not filled in when the surface was last
+       painted, because its pixels are the parent's at parentx, parenty */
+    gboolean parent_view;
     gint bevel_dark_adjust;  /* 0-255, default is 64 */
     gint bevel_light_adjust; /* 0-255, default is 128 */
     RrColor *split_primary;
@@ -231,6 +234,16 @@ struct _RrAppearance {
 
     /* cached for internal use */
     gint w, h;
+    /* a copy of the rendered surface kept on the X server, so it doesn't
+       need to be rendered and sent again when painting at the same size */
+    Pixmap background;
+    /* the window that the appearance was last painted in */
+    Window painted;
+    /* TRUE once the appearance has been painted in more than one window,
+       like the theme's appearances that every frame paints with.  the
+       windows can have different sizes and would keep replacing each
+       other's background, so it isn't kept for these */
+    gboolean shared;
 };
 
 /*! Holds a RGBA image picture */
@@ -397,6 +410,9 @@ RrSize *RrFontMeasureString (const RrFont *f, const gchar *str,
                              gboolean flow, gint maxwidth);
 gint    RrFontHeight        (const RrFont *f, gint shadow_offset_y);
 gint    RrFontMaxCharWidth  (const RrFont *f);
+/*! Counts how many strings were laid out and shaped by pango, and how many
+  times a cached layout was used instead */
+void    RrFontLayoutStats   (guint *shaped, guint *reused);
 
 /* Paint into the appearance. The old pixmap is returned (if there was one). It
    is the responsibility of the caller to call XFreePixmap on the return when
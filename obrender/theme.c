@@ -53,7 +53,8 @@ static gboolean read_int(XrmDatabase db, const gchar *rname, gint *value);
 static gboolean read_string(XrmDatabase db, const gchar *rname, gchar **value);
 static gboolean read_color(XrmDatabase db, const RrInstance *inst,
                            const gchar *rname, RrColor **value);
-static gboolean read_mask(const RrInstance *inst, const gchar *path,
+static GHashTable* decode_masks(const gchar *path);
+static gboolean read_mask(const RrInstance *inst, GHashTable *masks,
                           const gchar *maskname, RrPixmapMask **value);
 static gboolean read_appearance(XrmDatabase db, const RrInstance *inst,
                                 const gchar *rname, RrAppearance *value,
@@ -62,13 +63,15 @@ static int parse_inline_number(const char *p);
 static RrPixel32* read_c_image(gint width, gint height, const guint8 *data);
 static void set_default_appearance(RrAppearance *a);
 static void read_button_styles(XrmDatabase db, const RrInstance *inst, 
-                               gchar *path,
+                               GHashTable *masks,
                                const RrTheme *theme, RrButton *btn, 
                                const gchar *btnname,
                                struct fallbacks *fbs,
                                guchar *normal_mask,
                                guchar *toggled_mask);
 
+static void render_buttons(RrTheme *theme);
+static void free_button_pixmap(gpointer key, gpointer value, gpointer data);
 static RrFont *get_font(RrFont *target, RrFont **default_font,
                         const RrInstance *inst)
 {
@@ -101,7 +104,7 @@ static RrFont *get_font(RrFont *target, RrFont **default_font,
         x_var = x_def;
 
 #define READ_MASK_COPY(x_file, x_var, x_copysrc) \
-    if (!read_mask(inst, path, x_file, & x_var)) \
+    if (!read_mask(inst, masks, x_file, & x_var)) \
         x_var = RrPixmapMaskCopy(x_copysrc);
 
 #define READ_APPEARANCE(x_resstr, x_var, x_parrel) \
@@ -140,6 +143,8 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     gchar *path;
     gint menu_overlap = 0;
     struct fallbacks fbs;
+    GHashTable *masks;
+    GTimer *timer;
 
     if (name) {
         db = loaddb(name, &path);
@@ -163,6 +168,15 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
             return NULL;
     }
 
+    /* read the theme's bitmaps from disk in the background, and then create
+       the X resources for everything on this thread */
+    timer = g_timer_new();
+    masks = decode_masks(path);
+    g_debug("Theme %s: decoded %u masks in %.1f ms",
+            name ? name : DEFAULT_THEME, g_hash_table_size(masks),
+            g_timer_elapsed(timer, NULL) * 1000.0);
+    g_timer_start(timer);
+
     /* initialize temp reading textures */
     fbs.focused_disabled = RrAppearanceNew(inst, 1);
     fbs.unfocused_disabled = RrAppearanceNew(inst, 1);
@@ -487,14 +501,14 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     {
         guchar normal_mask[] =  { 0x3f, 0x3f, 0x21, 0x21, 0x21, 0x3f };
         guchar toggled_mask[] = { 0x3e, 0x22, 0x2f, 0x29, 0x39, 0x0f };
-        read_button_styles(db, inst, path, theme, theme->btn_max, "max",
+        read_button_styles(db, inst, masks, theme, theme->btn_max, "max",
                            &fbs, normal_mask, toggled_mask);
     }
 
     /* close button */
     {
         guchar normal_mask[] = { 0x33, 0x3f, 0x1e, 0x1e, 0x3f, 0x33 };
-        read_button_styles(db, inst, path, theme, theme->btn_close, "close",
+        read_button_styles(db, inst, masks, theme, theme->btn_close, "close",
                            &fbs, normal_mask, NULL);
     }
 
@@ -502,26 +516,26 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     {
         guchar normal_mask[] =  { 0x33, 0x33, 0x00, 0x00, 0x33, 0x33 };
         guchar toggled_mask[] = { 0x00, 0x1e, 0x1a, 0x16, 0x1e, 0x00 };
-        read_button_styles(db, inst, path, theme, theme->btn_desk, "desk",
+        read_button_styles(db, inst, masks, theme, theme->btn_desk, "desk",
                            &fbs, normal_mask, toggled_mask);
     }
 
     /* shade button */
     {
         guchar normal_mask[] = { 0x3f, 0x3f, 0x00, 0x00, 0x00, 0x00 };
-        read_button_styles(db, inst, path, theme, theme->btn_shade, "shade",
+        read_button_styles(db, inst, masks, theme, theme->btn_shade, "shade",
                            &fbs, normal_mask, normal_mask);
     }
 
     /* iconify button */
     {
         guchar normal_mask[] = { 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f };
-        read_button_styles(db, inst, path, theme, theme->btn_iconify, "iconify",
+        read_button_styles(db, inst, masks, theme, theme->btn_iconify, "iconify",
                            &fbs, normal_mask, NULL);
     }
 
     /* submenu bullet mask */
-    if (!read_mask(inst, path, "bullet.xbm", &theme->menu_bullet_mask))
+    if (!read_mask(inst, masks, "bullet.xbm", &theme->menu_bullet_mask))
     {
         guchar data[] = { 0x01, 0x03, 0x07, 0x0f, 0x07, 0x03, 0x01 };
         theme->menu_bullet_mask = RrPixmapMaskNew(inst, 4, 7, (gchar*)data);
@@ -940,6 +954,7 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     theme->a_menu_bullet_selected->texture[0].data.mask.color =
         theme->menu_bullet_selected_color;
 
+    g_hash_table_destroy(masks);
     g_free(path);
     XrmDestroyDatabase(db);
 
@@ -985,6 +1000,8 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     theme->button_size = theme->label_height - 2;
     theme->grip_width = 25;
 
+    render_buttons(theme);
+
     RrAppearanceFree(fbs.focused_disabled);
     RrAppearanceFree(fbs.unfocused_disabled);
     RrAppearanceFree(fbs.focused_hover);
@@ -1000,6 +1017,10 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *name,
     RrAppearanceFree(fbs.unfocused_unpressed_toggled);
     RrAppearanceFree(fbs.unfocused_pressed_toggled);
 
+    g_debug("Theme %s: created fonts and appearances in %.1f ms",
+            theme->name, g_timer_elapsed(timer, NULL) * 1000.0);
+    g_timer_destroy(timer);
+
     return theme;
 }
 
@@ -1008,6 +1029,10 @@ void RrThemeFree(RrTheme *theme)
     if (theme) {
         g_free(theme->name);
 
+        g_hash_table_foreach(theme->button_pixmaps, free_button_pixmap,
+                             theme);
+        g_hash_table_destroy(theme->button_pixmaps);
+
         RrButtonFree(theme->btn_max);
         RrButtonFree(theme->btn_close);
         RrButtonFree(theme->btn_desk);
@@ -1112,6 +1137,126 @@ void RrThemeFree(RrTheme *theme)
     }
 }
 
+/*! Returns TRUE if the button looks the same on every frame, so that it
+  can be drawn once for the theme */
+static gboolean button_is_static(const RrTheme *theme, const RrAppearance *a,
+                                 const RrAppearance *title)
+{
+    if (a->texture[0].type != RR_TEXTURE_MASK ||
+        !a->texture[0].data.mask.mask)
+        return FALSE; /* this state is not used by the button */
+
+    if (a->surface.grad != RR_SURFACE_PARENTREL)
+        return TRUE;
+
+    /* a parent relative button shows the part of the title behind it, which
+       is only the same for every button position if the title does not
+       change from left to right */
+    switch (title->surface.grad) {
+    case RR_SURFACE_SOLID:
+    case RR_SURFACE_VERTICAL:
+    case RR_SURFACE_SPLIT_VERTICAL:
+        break;
+    default:
+        return FALSE;
+    }
+
+    /* except for its bevel.  a double bevel reaches into the second column,
+       which is where the buttons go when there is no padding */
+    if (title->surface.relief != RR_RELIEF_FLAT &&
+        title->surface.bevel == RR_BEVEL_2 && theme->paddingx < 1)
+        return FALSE;
+
+    return TRUE;
+}
+
+static void render_button(RrTheme *theme, RrAppearance *a,
+                          RrAppearance *title)
+{
+    Display *d = RrDisplay(theme->inst);
+    Pixmap oldp, p;
+    gint bs = theme->button_size;
+
+    if (!button_is_static(theme, a, title))
+        return;
+
+    /* draw it away from the title's edges, the same as it would be placed
+       in a frame */
+    a->surface.parent = title;
+    a->surface.parentx = 2;
+    a->surface.parenty = theme->paddingy + 1;
+
+    oldp = RrPaintPixmap(a, bs, bs);
+    if (oldp) XFreePixmap(d, oldp);
+    if (!a->pixmap)
+        return;
+
+    p = XCreatePixmap(d, RrRootWindow(theme->inst), bs, bs,
+                      RrDepth(theme->inst));
+    XCopyArea(d, a->pixmap, p, DefaultGC(d, RrScreen(theme->inst)),
+              0, 0, bs, bs, 0, 0);
+    g_hash_table_insert(theme->button_pixmaps, a, GUINT_TO_POINTER(p));
+}
+
+static void render_button_states(RrTheme *theme, RrButton *b)
+{
+    RrAppearance *ft = theme->a_focused_title;
+    RrAppearance *ut = theme->a_unfocused_title;
+
+    render_button(theme, b->a_focused_unpressed, ft);
+    render_button(theme, b->a_unfocused_unpressed, ut);
+    render_button(theme, b->a_focused_pressed, ft);
+    render_button(theme, b->a_unfocused_pressed, ut);
+    render_button(theme, b->a_focused_disabled, ft);
+    render_button(theme, b->a_unfocused_disabled, ut);
+    render_button(theme, b->a_focused_hover, ft);
+    render_button(theme, b->a_unfocused_hover, ut);
+    render_button(theme, b->a_focused_unpressed_toggled, ft);
+    render_button(theme, b->a_unfocused_unpressed_toggled, ut);
+    render_button(theme, b->a_focused_pressed_toggled, ft);
+    render_button(theme, b->a_unfocused_pressed_toggled, ut);
+    render_button(theme, b->a_focused_hover_toggled, ft);
+    render_button(theme, b->a_unfocused_hover_toggled, ut);
+}
+
+/*! Draw every state of the titlebar buttons once, so that frames can use
+  them as they are instead of drawing the button masks for each frame */
+static void render_buttons(RrTheme *theme)
+{
+    Pixmap oldp;
+
+    theme->button_pixmaps = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    if (theme->button_size < 1 || theme->title_height < 1)
+        return;
+
+    /* the titles for parent relative buttons to be drawn on */
+    oldp = RrPaintPixmap(theme->a_focused_title,
+                         theme->button_size + 4, theme->title_height);
+    if (oldp) XFreePixmap(RrDisplay(theme->inst), oldp);
+    oldp = RrPaintPixmap(theme->a_unfocused_title,
+                         theme->button_size + 4, theme->title_height);
+    if (oldp) XFreePixmap(RrDisplay(theme->inst), oldp);
+
+    render_button_states(theme, theme->btn_max);
+    render_button_states(theme, theme->btn_close);
+    render_button_states(theme, theme->btn_desk);
+    render_button_states(theme, theme->btn_shade);
+    render_button_states(theme, theme->btn_iconify);
+}
+
+static void free_button_pixmap(gpointer key, gpointer value, gpointer data)
+{
+    RrTheme *theme = data;
+
+    XFreePixmap(RrDisplay(theme->inst), GPOINTER_TO_UINT(value));
+}
+
+Pixmap RrThemeButtonPixmap(const RrTheme *theme, const RrAppearance *a)
+{
+    return GPOINTER_TO_UINT(g_hash_table_lookup(theme->button_pixmaps, a));
+}
+
 static XrmDatabase loaddb(const gchar *name, gchar **path)
 {
     GSList *it;
@@ -1234,24 +1379,108 @@ static gboolean read_color(XrmDatabase db, const RrInstance *inst,
     return ret;
 }
 
-static gboolean read_mask(const RrInstance *inst, const gchar *path,
-                          const gchar *maskname, RrPixmapMask **value)
+/*! The contents of an xbm file in the theme, as read from disk */
+typedef struct _MaskFile {
+    gchar *filename;
+    gboolean ok;
+    guint w, h;
+    guchar *data;
+} MaskFile;
+
+static const gchar *const button_masks[] = {
+    "max", "close", "desk", "shade", "iconify", NULL
+};
+
+static const gchar *const button_mask_states[] = {
+    "", "_toggled", "_pressed", "_disabled", "_hover", "_pressed_toggled",
+    "_hover_toggled", NULL
+};
+
+static void mask_file_read(MaskFile *f)
 {
-    gboolean ret = FALSE;
-    gchar *s;
     gint hx, hy; /* ignored */
-    guint w, h;
-    guchar *b;
 
-    s = g_build_filename(path, maskname, NULL);
-    if (XReadBitmapFileData(s, &w, &h, &b, &hx, &hy) == BitmapSuccess) {
-        ret = TRUE;
-        *value = RrPixmapMaskNew(inst, w, h, (gchar*)b);
-        XFree(b);
+    /* this doesn't touch the display so it is safe to run on any thread */
+    f->ok = XReadBitmapFileData(f->filename, &f->w, &f->h, &f->data,
+                                &hx, &hy) == BitmapSuccess;
+}
+
+static void mask_file_thread(gpointer data, gpointer user_data)
+{
+    mask_file_read(data);
+}
+
+static void mask_file_free(gpointer data)
+{
+    MaskFile *f = data;
+
+    if (f->ok) XFree(f->data);
+    g_free(f->filename);
+    g_slice_free(MaskFile, f);
+}
+
+static void mask_file_add(GHashTable *masks, const gchar *path,
+                          gchar *maskname)
+{
+    MaskFile *f;
+
+    f = g_slice_new0(MaskFile);
+    f->filename = g_build_filename(path, maskname, NULL);
+    g_hash_table_insert(masks, maskname, f);
+}
+
+/*! Read every xbm file that the theme may use, with a few threads, so that
+  the time spent waiting on the disk overlaps.  Returns a table of MaskFile
+  structures, keyed by the file's name inside the theme directory. */
+static GHashTable* decode_masks(const gchar *path)
+{
+    GHashTable *masks;
+    GThreadPool *pool = NULL;
+    GHashTableIter it;
+    gpointer f;
+    gint i, j;
+
+    masks = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                  g_free, mask_file_free);
+
+    for (i = 0; button_masks[i]; ++i)
+        for (j = 0; button_mask_states[j]; ++j)
+            mask_file_add(masks, path, g_strconcat(button_masks[i],
+                                                   button_mask_states[j],
+                                                   ".xbm", NULL));
+    mask_file_add(masks, path, g_strdup("bullet.xbm"));
+
+#if !GLIB_CHECK_VERSION(2,32,0)
+    if (g_thread_supported())
+#endif
+        pool = g_thread_pool_new(mask_file_thread, NULL, 4, FALSE, NULL);
+
+    g_hash_table_iter_init(&it, masks);
+    while (g_hash_table_iter_next(&it, NULL, &f)) {
+        if (pool)
+            g_thread_pool_push(pool, f, NULL);
+        else
+            mask_file_read(f);
     }
-    g_free(s);
 
-    return ret;
+    /* wait for all of the files to be read */
+    if (pool)
+        g_thread_pool_free(pool, FALSE, TRUE);
+
+    return masks;
+}
+
+static gboolean read_mask(const RrInstance *inst, GHashTable *masks,
+                          const gchar *maskname, RrPixmapMask **value)
+{
+    MaskFile *f;
+
+    f = g_hash_table_lookup(masks, maskname);
+    g_assert(f != NULL);
+
+    if (f->ok)
+        *value = RrPixmapMaskNew(inst, f->w, f->h, (gchar*)f->data);
+    return f->ok;
 }
 
 static void parse_appearance(gchar *tex, RrSurfaceColorType *grad,
@@ -1462,7 +1691,7 @@ static RrPixel32* read_c_image(gint width, gint height, const guint8 *data)
 }
 
 static void read_button_styles(XrmDatabase db, const RrInstance *inst, 
-                               gchar *path,
+                               GHashTable *masks,
                                const RrTheme *theme, RrButton *btn, 
                                const gchar *btnname,
                                struct fallbacks *fbs,
@@ -1473,13 +1702,13 @@ static void read_button_styles(XrmDatabase db, const RrInstance *inst,
     gboolean userdef = TRUE;
 
     g_snprintf(name, 128, "%s.xbm", btnname);
-    if (!read_mask(inst, path, name, &btn->unpressed_mask) && normal_mask)
+    if (!read_mask(inst, masks, name, &btn->unpressed_mask) && normal_mask)
     {
         btn->unpressed_mask = RrPixmapMaskNew(inst, 6, 6, (gchar*)normal_mask);
         userdef = FALSE;
     }
     g_snprintf(name, 128, "%s_toggled.xbm", btnname);
-    if (toggled_mask && !read_mask(inst, path, name, &btn->unpressed_toggled_mask))
+    if (toggled_mask && !read_mask(inst, masks, name, &btn->unpressed_toggled_mask))
     {
         if (userdef)
             btn->unpressed_toggled_mask = RrPixmapMaskCopy(btn->unpressed_mask);
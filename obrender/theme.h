@@ -173,6 +173,10 @@ struct _RrTheme {
     RrAppearance *osd_unpressed_button;
     RrAppearance *osd_focused_button;
 
+    /* the titlebar button appearances which were drawn when the theme was
+       loaded, mapped to their Pixmap */
+    GHashTable *button_pixmaps;
+
     gchar *name;
 };
 
@@ -185,6 +189,12 @@ RrTheme* RrThemeNew(const RrInstance *inst, const gchar *theme,
                     RrFont *active_osd_font, RrFont *inactive_osd_font);
 void RrThemeFree(RrTheme *theme);
 
+/*! Returns the pixmap drawn for a titlebar button appearance when the theme
+  was loaded, or None if the button has to be drawn for each frame, because
+  its look depends on where it is placed in the titlebar.  The pixmap belongs
+  to the theme. */
+Pixmap RrThemeButtonPixmap(const RrTheme *theme, const RrAppearance *a);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,275 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   xrender.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "xrender.h"
+#include "instance.h"
+#include "color.h"
+#include "image.h"
+
+#ifdef USE_XRENDER
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+/*! A Picture which was uploaded to the X server for some texture data */
+typedef struct _RrXRenderUpload {
+    const RrInstance *inst;
+    Picture picture;
+} RrXRenderUpload;
+
+/*! Maps RrPixmapMask, RrImagePic and RrColor pointers to the Picture that
+  was uploaded for them.  These are kept around until the object is freed,
+  so that drawing a texture again costs only a composite on the server. */
+static GHashTable *uploads = NULL;
+
+static void upload_free(gpointer data)
+{
+    RrXRenderUpload *up = data;
+
+    XRenderFreePicture(RrDisplay(up->inst), up->picture);
+    g_slice_free(RrXRenderUpload, up);
+}
+
+static void upload_add(const RrInstance *inst, gconstpointer key,
+                       Picture picture)
+{
+    RrXRenderUpload *up;
+
+    up = g_slice_new(RrXRenderUpload);
+    up->inst = inst;
+    up->picture = picture;
+    g_hash_table_insert(uploads, (gpointer)key, up);
+}
+
+static Picture upload_find(gconstpointer key)
+{
+    RrXRenderUpload *up;
+
+    up = g_hash_table_lookup(uploads, key);
+    return up ? up->picture : None;
+}
+
+void RrXRenderStartup(RrInstance *inst)
+{
+    gint event_base, error_base;
+
+    inst->xrender_format = NULL;
+    inst->xrender_format_a1 = NULL;
+    inst->xrender_format_argb32 = NULL;
+
+    if (!XRenderQueryExtension(inst->display, &event_base, &error_base))
+        return;
+
+    inst->xrender_format_a1 =
+        XRenderFindStandardFormat(inst->display, PictStandardA1);
+    inst->xrender_format_argb32 =
+        XRenderFindStandardFormat(inst->display, PictStandardARGB32);
+    /* only use the extension if all of the formats are available */
+    if (inst->xrender_format_a1 && inst->xrender_format_argb32)
+        inst->xrender_format = XRenderFindVisualFormat(inst->display,
+                                                       inst->visual);
+
+    if (inst->xrender_format && !uploads)
+        uploads = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                        NULL, upload_free);
+}
+
+void RrXRenderShutdown(RrInstance *inst)
+{
+    if (inst->xrender_format && uploads) {
+        g_hash_table_destroy(uploads);
+        uploads = NULL;
+    }
+    inst->xrender_format = NULL;
+}
+
+gboolean RrXRenderEnabled(const RrInstance *inst)
+{
+    return inst->xrender_format != NULL;
+}
+
+Picture RrXRenderPixmapPicture(const RrInstance *inst, Pixmap p)
+{
+    return XRenderCreatePicture(RrDisplay(inst), p, inst->xrender_format,
+                                0, NULL);
+}
+
+void RrXRenderForget(gconstpointer key)
+{
+    if (uploads)
+        g_hash_table_remove(uploads, key);
+}
+
+/*! Returns a Picture filled with the color, to use as the source when
+  compositing masks */
+static Picture color_picture(const RrInstance *inst, RrColor *c)
+{
+    Picture p;
+
+    if (!(p = upload_find(c))) {
+        XRenderColor xc;
+
+        xc.red = (c->r << 8) | c->r;
+        xc.green = (c->g << 8) | c->g;
+        xc.blue = (c->b << 8) | c->b;
+        xc.alpha = 0xffff;
+        p = XRenderCreateSolidFill(RrDisplay(inst), &xc);
+        upload_add(inst, c, p);
+    }
+    return p;
+}
+
+/*! Returns an A1 Picture for the mask's bitmap */
+static Picture mask_picture(const RrInstance *inst, RrPixmapMask *m)
+{
+    Picture p;
+
+    if (!(p = upload_find(m))) {
+        p = XRenderCreatePicture(RrDisplay(inst), m->mask,
+                                 inst->xrender_format_a1, 0, NULL);
+        upload_add(inst, m, p);
+    }
+    return p;
+}
+
+/*! Returns an ARGB32 Picture with the contents of an RrImagePic.  The pixels
+  are premultiplied by their alpha on the way, as XRender expects them. */
+static Picture pic_picture(const RrInstance *inst, RrImagePic *pic)
+{
+    Picture p;
+
+    if (!(p = upload_find(pic))) {
+        Pixmap pixmap;
+        XImage *im;
+        GC gc;
+        RrPixel32 *data, *s, *d;
+        gint i;
+
+        data = g_new(RrPixel32, pic->width * pic->height);
+        s = pic->data;
+        d = data;
+        for (i = pic->width * pic->height; i > 0; --i, ++s, ++d) {
+            guint a, r, g, b, t;
+
+            a = (*s >> RrDefaultAlphaOffset) & 0xff;
+            r = (*s >> RrDefaultRedOffset) & 0xff;
+            g = (*s >> RrDefaultGreenOffset) & 0xff;
+            b = (*s >> RrDefaultBlueOffset) & 0xff;
+
+            /* divide by 255 with rounding */
+#define PREMUL(c) (t = (c) * a + 0x80, ((t >> 8) + t) >> 8)
+            *d = ((a << 24) |
+                  (PREMUL(r) << 16) |
+                  (PREMUL(g) << 8) |
+                  PREMUL(b));
+#undef PREMUL
+        }
+
+        pixmap = XCreatePixmap(RrDisplay(inst), RrRootWindow(inst),
+                               pic->width, pic->height, 32);
+        gc = XCreateGC(RrDisplay(inst), pixmap, 0, NULL);
+        im = XCreateImage(RrDisplay(inst), NULL, 32, ZPixmap, 0,
+                          (gchar*)data, pic->width, pic->height, 32, 0);
+        XPutImage(RrDisplay(inst), pixmap, gc, im, 0, 0, 0, 0,
+                  pic->width, pic->height);
+        im->data = NULL;
+        XDestroyImage(im);
+        XFreeGC(RrDisplay(inst), gc);
+        g_free(data);
+
+        p = XRenderCreatePicture(RrDisplay(inst), pixmap,
+                                 inst->xrender_format_argb32, 0, NULL);
+        /* the picture keeps the pixmap alive */
+        XFreePixmap(RrDisplay(inst), pixmap);
+        upload_add(inst, pic, p);
+    }
+    return p;
+}
+
+/*! Composite the picture centered in the area, with the given opacity */
+static void draw_pic(const RrInstance *inst, Picture dest, RrImagePic *pic,
+                     gint alpha, const RrRect *area)
+{
+    Picture mask = None;
+    gint x, y;
+
+    if (alpha < 255) {
+        XRenderColor xc;
+
+        xc.red = xc.green = xc.blue = 0;
+        xc.alpha = (alpha << 8) | alpha;
+        mask = XRenderCreateSolidFill(RrDisplay(inst), &xc);
+    }
+
+    x = area->x + (area->width - pic->width) / 2;
+    y = area->y + (area->height - pic->height) / 2;
+
+    XRenderComposite(RrDisplay(inst), PictOpOver,
+                     pic_picture(inst, pic), mask, dest,
+                     0, 0, 0, 0, x, y, pic->width, pic->height);
+
+    if (mask) XRenderFreePicture(RrDisplay(inst), mask);
+}
+
+void RrXRenderDrawMask(const RrInstance *inst, Picture dest,
+                       const RrTextureMask *m, const RrRect *area)
+{
+    gint x, y;
+
+    if (m->mask == NULL) return; /* no mask given */
+
+    x = area->x + (area->width - m->mask->width) / 2;
+    y = area->y + (area->height - m->mask->height) / 2;
+
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+
+    XRenderComposite(RrDisplay(inst), PictOpOver,
+                     color_picture(inst, m->color),
+                     mask_picture(inst, m->mask), dest,
+                     0, 0, 0, 0, x, y, m->mask->width, m->mask->height);
+}
+
+void RrXRenderDrawImage(const RrInstance *inst, Picture dest,
+                        RrTextureImage *img, RrRect *area)
+{
+    RrImagePic *pic;
+    gboolean free_pic;
+
+    if (area->width <= 0 || area->height <= 0) return;
+
+    pic = RrImagePicForArea(img, area, &free_pic);
+    draw_pic(inst, dest, pic, img->alpha, area);
+    if (free_pic)
+        RrImagePicFree(pic);
+}
+
+void RrXRenderDrawRGBA(const RrInstance *inst, Picture dest,
+                       RrTextureRGBA *rgba, RrRect *area)
+{
+    RrImagePic *pic;
+
+    if (area->width <= 0 || area->height <= 0) return;
+
+    /* RGBA textures don't own their data, so it can't be kept on the server
+       between draws */
+    pic = RrImagePicForRGBA(rgba, area);
+    draw_pic(inst, dest, pic, rgba->alpha, area);
+    RrImagePicFree(pic);
+}
+
+#endif
@@ -0,0 +1,54 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   xrender.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __xrender_h
+#define __xrender_h
+
+#include "render.h"
+#include "geom.h"
+
+#ifdef USE_XRENDER
+
+#include <X11/extensions/Xrender.h>
+
+/*! Look for the RENDER extension and the picture formats used for
+  compositing textures.  If it is not found, the XRender backend stays off
+  and everything is drawn in software. */
+void RrXRenderStartup(RrInstance *inst);
+void RrXRenderShutdown(RrInstance *inst);
+
+/*! Returns TRUE if textures should be composited on the X server */
+gboolean RrXRenderEnabled(const RrInstance *inst);
+
+/*! Create a Picture to composite onto a pixmap in the instance's visual.  It
+  must be freed with XRenderFreePicture. */
+Picture RrXRenderPixmapPicture(const RrInstance *inst, Pixmap p);
+
+/*! Drop the server-side copy of a mask, picture or color, if one was
+  uploaded.  This must be called before the object is freed. */
+void RrXRenderForget(gconstpointer key);
+
+void RrXRenderDrawMask(const RrInstance *inst, Picture dest,
+                       const RrTextureMask *m, const RrRect *area);
+void RrXRenderDrawImage(const RrInstance *inst, Picture dest,
+                        RrTextureImage *img, RrRect *area);
+void RrXRenderDrawRGBA(const RrInstance *inst, Picture dest,
+                       RrTextureRGBA *rgba, RrRect *area);
+
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   xshm.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "xshm.h"
+#include "instance.h"
+
+#ifdef USE_XSHM
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <string.h>
+
+/*! The size of the shared segment.  This fits a 256x256 icon, bigger images
+  are read with XGetImage. */
+#define SHM_SIZE (256 * 256 * 4)
+
+/*! The instance which can use the extension, or NULL if it can't be used */
+static const RrInstance *shm_inst = NULL;
+static XShmSegmentInfo shm_info;
+static gboolean shm_attached = FALSE;
+/*! Set when the server refuses to attach to the segment */
+static gboolean shm_error = FALSE;
+
+void RrXShmStartup(RrInstance *inst)
+{
+    const gchar *name = DisplayString(inst->display);
+
+    /* the server can only see our memory if it is on the same machine */
+    if (name[0] != ':' && strncmp(name, "unix:", 5))
+        return;
+    if (!XShmQueryExtension(inst->display))
+        return;
+
+    shm_inst = inst;
+    shm_attached = FALSE;
+}
+
+void RrXShmShutdown(RrInstance *inst)
+{
+    if (inst != shm_inst) return;
+
+    if (shm_attached) {
+        XShmDetach(inst->display, &shm_info);
+        XSync(inst->display, FALSE);
+        shmdt(shm_info.shmaddr);
+        shm_attached = FALSE;
+    }
+    shm_inst = NULL;
+}
+
+static int attach_error(Display *d, XErrorEvent *e)
+{
+    shm_error = TRUE;
+    return 0;
+}
+
+/*! Make the shared segment and attach the server to it */
+static gboolean attach(void)
+{
+    int (*old_handler)(Display*, XErrorEvent*);
+    gboolean ok;
+
+    shm_info.shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
+    if (shm_info.shmid < 0) {
+        shm_inst = NULL; /* don't try again */
+        return FALSE;
+    }
+
+    shm_info.shmaddr = shmat(shm_info.shmid, NULL, 0);
+    shm_info.readOnly = FALSE;
+    if (shm_info.shmaddr == (gchar*)-1) {
+        shmctl(shm_info.shmid, IPC_RMID, NULL);
+        shm_inst = NULL;
+        return FALSE;
+    }
+
+    /* the server only reports that it couldn't attach, such as when it
+       can't see our memory after all, as an error later on.  so wait for
+       it here, and catch it, so that it doesn't go to the application's
+       error handler */
+    XSync(shm_inst->display, FALSE);
+    shm_error = FALSE;
+    old_handler = XSetErrorHandler(attach_error);
+    ok = XShmAttach(shm_inst->display, &shm_info);
+    XSync(shm_inst->display, FALSE);
+    XSetErrorHandler(old_handler);
+
+    /* it goes away once both sides have detached from it */
+    shmctl(shm_info.shmid, IPC_RMID, NULL);
+
+    if (!ok || shm_error) {
+        /* don't try again for the rest of the session */
+        shmdt(shm_info.shmaddr);
+        shm_inst = NULL;
+        return FALSE;
+    }
+    shm_attached = TRUE;
+    return TRUE;
+}
+
+XImage* RrXShmGetImage(const RrInstance *inst, Drawable d,
+                       gint w, gint h, gint depth)
+{
+    XImage *im;
+
+    if (inst != shm_inst) return NULL;
+    if (!shm_attached && !attach()) return NULL;
+
+    im = XShmCreateImage(inst->display,
+                         depth == inst->depth ? inst->visual : NULL,
+                         depth, ZPixmap, NULL, &shm_info, w, h);
+    if (!im) return NULL;
+    if (im->bytes_per_line * im->height > SHM_SIZE) {
+        XDestroyImage(im);
+        return NULL;
+    }
+    im->data = shm_info.shmaddr;
+
+    if (!XShmGetImage(inst->display, d, im, 0, 0, AllPlanes)) {
+        RrXShmImageFree(im);
+        return NULL;
+    }
+    return im;
+}
+
+void RrXShmImageFree(XImage *im)
+{
+    im->data = NULL; /* it belongs to the shared segment */
+    XDestroyImage(im);
+}
+
+#endif
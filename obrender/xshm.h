@@ -0,0 +1,42 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   xshm.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __xshm_h
+#define __xshm_h
+
+#include "render.h"
+
+#ifdef USE_XSHM
+
+#include <X11/extensions/XShm.h>
+
+/*! Look for the MIT-SHM extension.  The shared memory segment is only made
+  the first time it is used. */
+void RrXShmStartup(RrInstance *inst);
+void RrXShmShutdown(RrInstance *inst);
+
+/*! Read the contents of a drawable through shared memory, in ZPixmap
+  format.  Returns NULL if it can't be done that way, and XGetImage should be
+  used instead.  The image's data is only valid until the next call, and the
+  image must be freed with RrXShmImageFree. */
+XImage* RrXShmGetImage(const RrInstance *inst, Drawable d,
+                       gint w, gint h, gint depth);
+void RrXShmImageFree(XImage *im);
+
+#endif
+
+#endif
@@ -21,6 +21,9 @@
 
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
 
 struct _ObtIC
 {
@@ -41,7 +44,22 @@ struct _ObtIC
 /* Get the bitflag for the n'th modifier mask */
 #define nth_mask(n) (1 << n)
 
+/* The parts of a key event's state that change what the key translates to,
+   the modifier masks and the XKB group */
+#define TRANSLATE_MASKS (ALL_MASKS | 0x6000)
+
+typedef struct _ObtKeyTrans ObtKeyTrans;
+
+/*! What a keycode translates to with some modifier state */
+struct _ObtKeyTrans
+{
+    KeySym sym;
+    gunichar unikey; /* the character it types, or 0 if it does not */
+    gboolean use_im; /* if the input method has to work out what it types */
+};
+
 static void set_modkey_mask(guchar mask, KeySym sym);
+static void key_trans_free(gpointer data);
 static void xim_init(void);
 void obt_keyboard_shutdown();
 void obt_keyboard_context_renew(ObtIC *ic);
@@ -51,6 +69,13 @@ static KeySym *keymap;
 static gint min_keycode, max_keycode, keysyms_per_keycode;
 /*! This is a bitmask of the different masks for each modifier key */
 static guchar modkeys_keys[OBT_KEYBOARD_NUM_MODKEYS];
+/*! The first modifier mask that each keycode is bound to */
+static guchar keycode_masks[256];
+/*! The ObtKeyTrans for each keycode and state that has been translated since
+  the keyboard mapping last changed, keyed by the keycode | the state << 8 */
+static GHashTable *key_trans;
+/*! The zero-terminated KeyCodes that generate each KeySym */
+static GHashTable *keysym_codes;
 
 static gboolean alt_l = FALSE;
 static gboolean meta_l = FALSE;
@@ -75,6 +100,8 @@ void obt_keyboard_reload(void)
     /* reset the keys to not be bound to any masks */
     for (i = 0; i < OBT_KEYBOARD_NUM_MODKEYS; ++i)
         modkeys_keys[i] = 0;
+    for (i = 0; i < 256; ++i)
+        keycode_masks[i] = 0;
 
     modmap = XGetModifierMapping(obt_display);
     /* note: modmap->max_keypermod can be 0 when there is no valid key layout
@@ -95,6 +122,9 @@ void obt_keyboard_reload(void)
             /* get a keycode that is bound to the mask (i) */
             KeyCode keycode = modmap->modifiermap[i*modmap->max_keypermod + j];
             if (keycode) {
+                if (!keycode_masks[keycode])
+                    keycode_masks[keycode] = nth_mask(i);
+
                 /* go through each keysym bound to the given keycode */
                 for (k = 0; k < keysyms_per_keycode; ++k) {
                     sym = keymap[(keycode-min_keycode) * keysyms_per_keycode +
@@ -112,6 +142,19 @@ void obt_keyboard_reload(void)
     modkeys_keys[OBT_KEYBOARD_MODKEY_CAPSLOCK] = LockMask;
     modkeys_keys[OBT_KEYBOARD_MODKEY_SHIFT] = ShiftMask;
     modkeys_keys[OBT_KEYBOARD_MODKEY_CONTROL] = ControlMask;
+
+    key_trans = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                      NULL, key_trans_free);
+}
+
+void obt_keyboard_mapping_changed(XMappingEvent *e)
+{
+    /* this updates the mapping that XLookupString uses */
+    XRefreshKeyboardMapping(e);
+
+    /* the keys may translate to something else now */
+    if (key_trans)
+        g_hash_table_remove_all(key_trans);
 }
 
 void obt_keyboard_shutdown(void)
@@ -122,6 +165,12 @@ void obt_keyboard_shutdown(void)
     modmap = NULL;
     XFree(keymap);
     keymap = NULL;
+    g_hash_table_destroy(key_trans);
+    key_trans = NULL;
+    if (keysym_codes) {
+        g_hash_table_destroy(keysym_codes);
+        keysym_codes = NULL;
+    }
     for (it = xic_all; it; it = g_slist_next(it)) {
         ObtIC* ic = it->data;
         if (ic->xic) {
@@ -192,18 +241,10 @@ void xim_init(void)
 
 guint obt_keyboard_keyevent_to_modmask(XEvent *e)
 {
-    gint i, masknum;
-
     g_return_val_if_fail(e->type == KeyPress || e->type == KeyRelease,
                          OBT_KEYBOARD_MODKEY_NONE);
 
-    for (masknum = 0; masknum < NUM_MASKS; ++masknum)
-        for (i = 0; i < modmap->max_keypermod; ++i) {
-            KeyCode c = modmap->modifiermap[masknum*modmap->max_keypermod + i];
-            if (c == e->xkey.keycode)
-                return 1<<masknum;
-        }
-    return 0;
+    return keycode_masks[e->xkey.keycode];
 }
 
 guint obt_keyboard_only_modmasks(guint mask)
@@ -266,29 +307,111 @@ static void set_modkey_mask(guchar mask, KeySym sym)
     /* CapsLock, Shift, and Control are special and hard-coded */
 }
 
-KeyCode* obt_keyboard_keysym_to_keycode(KeySym sym)
+static void keysym_codes_build(void)
 {
-    KeyCode *ret;
-    gint i, j, n;
-
-    ret = g_new(KeyCode, 1);
-    n = 0;
-    ret[n] = 0;
+    GHashTable *lists;
+    GHashTableIter iter;
+    gpointer key, val;
+    gint i, j;
 
-    /* go through each keycode and look for the keysym */
+    /* find the keycodes for every keysym in one pass over the keymap */
+    lists = g_hash_table_new(g_direct_hash, g_direct_equal);
     for (i = min_keycode; i <= max_keycode; ++i)
-        for (j = 0; j < keysyms_per_keycode; ++j)
-            if (sym == keymap[(i-min_keycode) * keysyms_per_keycode + j]) {
-                ret = g_renew(KeyCode, ret, ++n + 1);
-                ret[n-1] = i;
-                ret[n] = 0;
+        for (j = 0; j < keysyms_per_keycode; ++j) {
+            KeySym sym = keymap[(i-min_keycode) * keysyms_per_keycode + j];
+            GArray *codes;
+            KeyCode c = i;
+
+            if (sym == NoSymbol) continue;
+
+            codes = g_hash_table_lookup(lists, GUINT_TO_POINTER(sym));
+            if (!codes) {
+                codes = g_array_new(TRUE, TRUE, sizeof(KeyCode));
+                g_hash_table_insert(lists, GUINT_TO_POINTER(sym), codes);
             }
+            g_array_append_val(codes, c);
+        }
+
+    keysym_codes = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         NULL, g_free);
+    g_hash_table_iter_init(&iter, lists);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        g_hash_table_insert(keysym_codes, key,
+                            g_array_free(val, FALSE));
+    g_hash_table_destroy(lists);
+}
+
+KeyCode* obt_keyboard_keysym_to_keycode(KeySym sym)
+{
+    KeyCode *codes, *ret;
+    gint n;
+
+    if (!keysym_codes)
+        keysym_codes_build();
+
+    codes = g_hash_table_lookup(keysym_codes, GUINT_TO_POINTER(sym));
+    if (!codes)
+        return g_new0(KeyCode, 1);
+
+    for (n = 0; codes[n]; ++n);
+    ret = g_new(KeyCode, n + 1);
+    memcpy(ret, codes, (n + 1) * sizeof(KeyCode));
     return ret;
 }
 
+static void key_trans_free(gpointer data)
+{
+    g_slice_free(ObtKeyTrans, data);
+}
+
+/*! Translate a key event, using what it translated to last time when the
+  same key was pressed with the same modifiers */
+static const ObtKeyTrans* key_translate(XKeyEvent *ev)
+{
+    const guint state = ev->state & TRANSLATE_MASKS;
+    const gpointer key = GUINT_TO_POINTER(ev->keycode | state << 8);
+    ObtKeyTrans *t;
+
+    if (!(t = g_hash_table_lookup(key_trans, key))) {
+        XKeyEvent k = *ev;
+        gchar buf[4];
+        gint len;
+
+        k.state = state;
+        t = g_slice_new(ObtKeyTrans);
+        t->unikey = 0;
+        t->use_im = FALSE;
+        len = XLookupString(&k, buf, sizeof(buf), &t->sym, NULL);
+
+        if (((t->sym & 0xffffff00) == 0xfe00 && t->sym >= XK_dead_grave) ||
+            t->sym == XK_Multi_key)
+            /* dead keys and compose sequences are put together by the
+               input method */
+            t->use_im = TRUE;
+        else if ((t->sym & 0xff000000) == 0x01000000)
+            /* a unicode keysym, whatever string XLookupString gave for it,
+               which may be a Latin-1 stand-in */
+            t->unikey = t->sym & 0x00ffffff;
+        else if (len == 1) {
+            /* this is Latin-1, which is the same as the first 256
+               unicode characters */
+            if ((guchar)buf[0] >= 32) /* not an ascii control character */
+                t->unikey = (guchar)buf[0];
+        }
+        else if (t->sym != NoSymbol && t->sym < 0xfd00)
+            /* it types something that isn't in Latin-1, which only the
+               input method knows how to turn into unicode */
+            t->use_im = TRUE;
+
+        g_hash_table_insert(key_trans, key, t);
+    }
+    return t;
+}
+
 gunichar obt_keyboard_keypress_to_unichar(ObtIC *ic, XEvent *ev)
 {
     gunichar unikey = 0;
+    const ObtKeyTrans *t;
     KeySym sym;
     Status status;
     gchar *buf, fixbuf[4]; /* 4 is enough for a utf8 char */
@@ -297,6 +420,12 @@ gunichar obt_keyboard_keypress_to_unichar(ObtIC *ic, XEvent *ev)
 
     g_return_val_if_fail(ev->type == KeyPress, 0);
 
+    /* the input method is only needed for keys that don't type the same
+       thing every time */
+    t = key_translate(&ev->xkey);
+    if (!t->use_im)
+        return t->unikey;
+
     if (!ic)
         g_warning("Using obt_keyboard_keypress_to_unichar() without an "
                   "Input Context.  No i18n support!");
@@ -368,13 +497,9 @@ gunichar obt_keyboard_keypress_to_unichar(ObtIC *ic, XEvent *ev)
 
 KeySym obt_keyboard_keypress_to_keysym(XEvent *ev)
 {
-    KeySym sym;
-
     g_return_val_if_fail(ev->type == KeyPress, None);
 
-    sym = None;
-    XLookupString(&ev->xkey, NULL, 0, &sym, NULL);
-    return sym;
+    return key_translate(&ev->xkey)->sym;
 }
 
 void obt_keyboard_context_renew(ObtIC *ic)
@@ -46,6 +46,10 @@ typedef struct _ObtIC ObtIC;
 
 void obt_keyboard_reload(void);
 
+/*! Call this for MappingNotify events, so that the keys are translated with
+  the new keyboard mapping */
+void obt_keyboard_mapping_changed(XMappingEvent *e);
+
 /*! Get the modifier mask(s) for a keyboard event.
   (eg. a keycode bound to Alt_L could return a mask of (Mod1Mask | Mask3Mask))
 */
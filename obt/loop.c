@@ -0,0 +1,385 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/loop.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "obt/loop.h"
+
+#ifdef USE_EPOLL
+
+#include <sys/epoll.h>
+#ifdef HAVE_ERRNO_H
+#  include <errno.h>
+#endif
+#ifdef HAVE_STRING_H
+#  include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+typedef struct _ObtLoopWatch ObtLoopWatch;
+
+/*! An fd that the GMainContext is waiting on */
+struct _ObtLoopWatch {
+    /*! The epoll events asked for */
+    guint32 events;
+    /*! epoll refused the fd, so it is waited on with poll() instead */
+    gboolean polled;
+};
+
+static gint epfd = -1;
+/*! The fds being waited on, mapped to an ObtLoopWatch */
+static GHashTable *watched = NULL;
+/*! The fds given to obt_loop_add() since the last iteration.  They may
+  have been closed and opened again with the same number, which epoll can't
+  see, so they are registered again. */
+static GHashTable *reopened = NULL;
+/*! How many of the watched fds are waited on with poll() */
+static guint n_polled = 0;
+/*! The GPollFDs from the last iteration, to find out what has changed */
+static GPollFD *last_fds = NULL;
+static guint n_last_fds = 0;
+static struct epoll_event *ready = NULL;
+static guint n_ready = 0;
+/*! The GPollFDs given to poll() when some fds can't be in the epoll set */
+static GPollFD *polled_fds = NULL;
+static guint n_polled_fds = 0;
+static GPollFunc old_poll = NULL;
+
+static guint32 poll_to_epoll(gushort events)
+{
+    guint32 e = 0;
+
+    if (events & G_IO_IN)  e |= EPOLLIN;
+    if (events & G_IO_OUT) e |= EPOLLOUT;
+    if (events & G_IO_PRI) e |= EPOLLPRI;
+    /* EPOLLERR and EPOLLHUP are always reported */
+    return e;
+}
+
+static gushort epoll_to_poll(guint32 e)
+{
+    gushort events = 0;
+
+    if (e & EPOLLIN)  events |= G_IO_IN;
+    if (e & EPOLLOUT) events |= G_IO_OUT;
+    if (e & EPOLLPRI) events |= G_IO_PRI;
+    if (e & EPOLLERR) events |= G_IO_ERR;
+    if (e & EPOLLHUP) events |= G_IO_HUP;
+    return events;
+}
+
+static gboolean fds_changed(GPollFD *fds, guint nfds)
+{
+    guint i;
+
+    if (nfds != n_last_fds) return TRUE;
+    for (i = 0; i < nfds; ++i)
+        if (fds[i].fd != last_fds[i].fd || fds[i].events != last_fds[i].events)
+            return TRUE;
+    return FALSE;
+}
+
+static void watch_free(gpointer w)
+{
+    g_slice_free(ObtLoopWatch, w);
+}
+
+/*! Put the fd in the epoll set, or in the poll() set if epoll won't take it.
+  Any registration for a file the fd was open for before is dropped. */
+static void watch_add(gint fd, ObtLoopWatch *w)
+{
+    struct epoll_event ev;
+
+    if (w->polled)
+        --n_polled;
+    else
+        /* this fails if the fd was closed in between, which is fine */
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+
+    ev.events = w->events;
+    ev.data.fd = fd;
+    /* regular files and some devices can't be used with epoll, they give
+       EPERM */
+    w->polled = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0;
+    if (w->polled)
+        ++n_polled;
+}
+
+/*! Stop watching an fd */
+static void watch_remove(gint fd, ObtLoopWatch *w)
+{
+    if (w->polled)
+        --n_polled;
+    else
+        /* this fails if the fd was already closed, which is fine */
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+/*! Register the fds given to obt_loop_add() again, as they may be open for
+  another file than when they were registered */
+static void update_reopened(void)
+{
+    GHashTableIter it;
+    gpointer key;
+    ObtLoopWatch *w;
+
+    g_hash_table_iter_init(&it, reopened);
+    while (g_hash_table_iter_next(&it, &key, NULL))
+        if ((w = g_hash_table_lookup(watched, key)))
+            watch_add(GPOINTER_TO_INT(key), w);
+    g_hash_table_remove_all(reopened);
+}
+
+/*! Bring the epoll set in line with the fds that the GMainContext wants to
+  wait on.  When they are the same as last time, which is nearly always,
+  there is nothing to do. */
+static void update_watched(GPollFD *fds, guint nfds)
+{
+    GHashTable *want;
+    GHashTableIter it;
+    gpointer key, val, old;
+    guint i;
+
+    /* an fd that was closed and opened again with the same events leaves
+       the GPollFDs the same */
+    if (g_hash_table_size(reopened))
+        update_reopened();
+
+    if (!fds_changed(fds, nfds))
+        return;
+
+    /* more than one source may watch the same fd */
+    want = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (i = 0; i < nfds; ++i) {
+        guint32 e;
+
+        if (fds[i].fd < 0) continue;
+
+        e = poll_to_epoll(fds[i].events);
+        if (g_hash_table_lookup_extended(want, GINT_TO_POINTER(fds[i].fd),
+                                         NULL, &old))
+            e |= GPOINTER_TO_UINT(old);
+        g_hash_table_insert(want, GINT_TO_POINTER(fds[i].fd),
+                            GUINT_TO_POINTER(e));
+    }
+
+    /* stop watching the fds that are gone */
+    g_hash_table_iter_init(&it, watched);
+    while (g_hash_table_iter_next(&it, &key, &val))
+        if (!g_hash_table_lookup_extended(want, key, NULL, NULL)) {
+            watch_remove(GPOINTER_TO_INT(key), val);
+            g_hash_table_iter_remove(&it);
+        }
+
+    /* add the new ones, and update the ones that want other events now */
+    g_hash_table_iter_init(&it, want);
+    while (g_hash_table_iter_next(&it, &key, &val)) {
+        ObtLoopWatch *w;
+        gint fd = GPOINTER_TO_INT(key);
+
+        if (!(w = g_hash_table_lookup(watched, key))) {
+            w = g_slice_new0(ObtLoopWatch);
+            w->events = GPOINTER_TO_UINT(val);
+            g_hash_table_insert(watched, key, w);
+            watch_add(fd, w);
+        }
+        else if (w->events != GPOINTER_TO_UINT(val)) {
+            w->events = GPOINTER_TO_UINT(val);
+            if (!w->polled) {
+                struct epoll_event ev;
+
+                ev.events = w->events;
+                ev.data.fd = fd;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+            }
+        }
+    }
+
+    n_ready = MAX(g_hash_table_size(want), 1);
+    ready = g_renew(struct epoll_event, ready, n_ready);
+
+    g_hash_table_destroy(want);
+
+    last_fds = g_renew(GPollFD, last_fds, nfds);
+    memcpy(last_fds, fds, sizeof(GPollFD) * nfds);
+    n_last_fds = nfds;
+}
+
+/*! Wait on the fds that epoll refused with poll(), along with the epoll fd
+  itself.  Returns the number of polled fds with events, or -1 on error, and
+  sets wait_epoll if there is something to read from the epoll set. */
+static gint poll_refused(GPollFD *fds, guint nfds, gint timeout,
+                         gboolean *wait_epoll)
+{
+    ObtLoopWatch *w;
+    gint n, nset;
+    guint i, j;
+
+    if (n_polled_fds < nfds + 1) {
+        n_polled_fds = nfds + 1;
+        polled_fds = g_renew(GPollFD, polled_fds, n_polled_fds);
+    }
+
+    polled_fds[0].fd = epfd;
+    polled_fds[0].events = G_IO_IN;
+    polled_fds[0].revents = 0;
+    for (i = 0, j = 1; i < nfds; ++i)
+        if (fds[i].fd >= 0 &&
+            (w = g_hash_table_lookup(watched, GINT_TO_POINTER(fds[i].fd))) &&
+            w->polled)
+        {
+            polled_fds[j] = fds[i];
+            polled_fds[j++].revents = 0;
+        }
+
+    n = old_poll(polled_fds, j, timeout);
+    if (n < 0) return n;
+
+    *wait_epoll = polled_fds[0].revents != 0;
+
+    /* copy the results back, the polled fds are in the same order */
+    nset = 0;
+    for (i = 0, j = 1; i < nfds; ++i)
+        if (fds[i].fd >= 0 &&
+            (w = g_hash_table_lookup(watched, GINT_TO_POINTER(fds[i].fd))) &&
+            w->polled)
+        {
+            fds[i].revents = polled_fds[j++].revents;
+            if (fds[i].revents) ++nset;
+        }
+    return nset;
+}
+
+static gint epoll_poll(GPollFD *fds, guint nfds, gint timeout)
+{
+    gint n, i, nset;
+    guint j;
+    gboolean wait_epoll = TRUE;
+
+    update_watched(fds, nfds);
+
+    for (j = 0; j < nfds; ++j)
+        fds[j].revents = 0;
+
+    nset = 0;
+    if (n_polled) {
+        nset = poll_refused(fds, nfds, timeout, &wait_epoll);
+        if (nset < 0) return nset; /* errno is set by poll() */
+        /* the waiting is done already */
+        timeout = 0;
+    }
+    if (!wait_epoll) return nset;
+
+    n = epoll_wait(epfd, ready, n_ready, timeout);
+    if (n < 0) return n; /* errno is set, like for poll() */
+
+    for (i = 0; i < n; ++i) {
+        gushort events = epoll_to_poll(ready[i].events);
+
+        for (j = 0; j < nfds; ++j)
+            if (fds[j].fd == ready[i].data.fd) {
+                /* only report what this GPollFD asked for, and errors */
+                fds[j].revents = events & (fds[j].events |
+                                           G_IO_ERR | G_IO_HUP | G_IO_NVAL);
+                if (fds[j].revents) ++nset;
+            }
+    }
+    return nset;
+}
+
+void obt_loop_startup(void)
+{
+    g_return_if_fail(epfd < 0);
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        g_message("Unable to create an epoll instance, using poll()");
+        return;
+    }
+
+    watched = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                    NULL, watch_free);
+    reopened = g_hash_table_new(g_direct_hash, g_direct_equal);
+    n_ready = 1;
+    ready = g_new(struct epoll_event, n_ready);
+    old_poll = g_main_context_get_poll_func(NULL);
+    g_main_context_set_poll_func(NULL, epoll_poll);
+}
+
+void obt_loop_shutdown(void)
+{
+    if (epfd < 0) return;
+
+    g_main_context_set_poll_func(NULL, old_poll);
+    old_poll = NULL;
+
+    g_hash_table_destroy(watched);
+    watched = NULL;
+    g_hash_table_destroy(reopened);
+    reopened = NULL;
+    n_polled = 0;
+    g_free(polled_fds);
+    polled_fds = NULL;
+    n_polled_fds = 0;
+    g_free(last_fds);
+    last_fds = NULL;
+    n_last_fds = 0;
+    g_free(ready);
+    ready = NULL;
+    n_ready = 0;
+
+    close(epfd);
+    epfd = -1;
+}
+
+gboolean obt_loop_epoll(void)
+{
+    return epfd >= 0;
+}
+
+#else
+
+void obt_loop_startup(void)
+{
+}
+
+void obt_loop_shutdown(void)
+{
+}
+
+gboolean obt_loop_epoll(void)
+{
+    return FALSE;
+}
+
+#endif
+
+guint obt_loop_add(gint fd, GIOCondition cond, GIOFunc func, gpointer data)
+{
+    GIOChannel *ch;
+    guint id;
+
+#ifdef USE_EPOLL
+    if (epfd >= 0)
+        g_hash_table_insert(reopened, GINT_TO_POINTER(fd), NULL);
+#endif
+
+    ch = g_io_channel_unix_new(fd);
+    id = g_io_add_watch(ch, cond, func, data);
+    g_io_channel_unref(ch);
+    return id;
+}
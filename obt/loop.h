@@ -0,0 +1,51 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   obt/loop.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __obt_loop_h
+#define __obt_loop_h
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*! Make the default GMainContext wait for events with epoll instead of
+  poll().  The file descriptors stay registered with the kernel between
+  iterations, and only the ones which were added or removed since the last
+  iteration are updated.  fds that epoll refuses, like regular files, are
+  still waited on with poll().  Sources, timeouts and watches are used the
+  same way as without it, except that fds which may be reused should be
+  watched with obt_loop_add().  This does nothing if obt was built without
+  epoll support.
+*/
+void obt_loop_startup(void);
+/*! Go back to waiting with poll() */
+void obt_loop_shutdown(void);
+
+/*! Returns TRUE if the default GMainContext is waiting with epoll */
+gboolean obt_loop_epoll(void);
+
+/*! Watch an fd in the default GMainContext, like g_io_add_watch().  Use
+  this for fds which may be closed and opened again with the same number,
+  so that epoll learns about the new file.  Remove the watch with
+  g_source_remove().
+  @return The id of the source
+*/
+guint obt_loop_add(gint fd, GIOCondition cond, GIOFunc func, gpointer data);
+
+G_END_DECLS
+
+#endif
@@ -28,13 +28,19 @@
 Atom prop_atoms[OBT_PROP_NUM_ATOMS];
 gboolean prop_started = FALSE;
 
-#define CREATE_NAME(var, name) (prop_atoms[OBT_PROP_##var] = \
-                                XInternAtom((obt_display), (name), FALSE))
+/* the names are collected and then all interned together, so that starting
+   up waits for one reply from the server instead of one for every atom */
+#define CREATE_NAME(var, name) (which[n] = OBT_PROP_##var, names[n++] = (name))
 #define CREATE(var) CREATE_NAME(var, #var)
 #define CREATE_(var) CREATE_NAME(var, "_" #var)
 
 void obt_prop_startup(void)
 {
+    gchar *names[OBT_PROP_NUM_ATOMS];
+    ObtPropAtom which[OBT_PROP_NUM_ATOMS];
+    Atom atoms[OBT_PROP_NUM_ATOMS];
+    guint n = 0, i;
+
     if (prop_started) return;
     prop_started = TRUE;
 
@@ -181,9 +187,9 @@ void obt_prop_startup(void)
     CREATE_(KDE_WM_CHANGE_STATE);
     CREATE_(KDE_NET_WM_WINDOW_TYPE_OVERRIDE);
 
+    CREATE_NAME(ROOTPMAPID, "_XROOTPMAP_ID");
 /*
-    CREATE_NAME(ROOTPMAPId, "_XROOTPMAP_ID");
-    CREATE_NAME(ESETROOTId, "ESETROOT_PMAP_ID");
+    CREATE_NAME(ESETROOTID, "ESETROOT_PMAP_ID");
 */
 
     CREATE_(OPENBOX_PID);
@@ -200,6 +206,11 @@ void obt_prop_startup(void)
     CREATE_(OB_APP_GROUP_NAME);
     CREATE_(OB_APP_GROUP_CLASS);
     CREATE_(OB_APP_TYPE);
+
+    g_assert(n <= OBT_PROP_NUM_ATOMS);
+    XInternAtoms(obt_display, names, n, FALSE, atoms);
+    for (i = 0; i < n; ++i)
+        prop_atoms[which[i]] = atoms[i];
 }
 
 Atom obt_prop_atom(ObtPropAtom a)
@@ -209,6 +220,37 @@ Atom obt_prop_atom(ObtPropAtom a)
     return prop_atoms[a];
 }
 
+/*! Copy num items of the size from the format that Xlib gives them in,
+  where 32-bit items are in longs, into an array of items of the size */
+static void narrow(const guchar *xdata, gint size, guchar *data, gulong num)
+{
+    gulong i;
+
+    switch (size) {
+    case 8:
+        memcpy(data, xdata, num);
+        break;
+    case 16:
+        if (sizeof(gushort) == sizeof(guint16))
+            memcpy(data, xdata, num * sizeof(guint16));
+        else
+            for (i = 0; i < num; ++i)
+                ((guint16*)data)[i] = ((const gushort*)xdata)[i];
+        break;
+    case 32:
+        if (sizeof(gulong) == sizeof(guint32))
+            memcpy(data, xdata, num * sizeof(guint32));
+        else
+            /* a loop with nothing else in it, which the compiler can
+               vectorize */
+            for (i = 0; i < num; ++i)
+                ((guint32*)data)[i] = ((const gulong*)xdata)[i];
+        break;
+    default:
+        g_assert_not_reached(); /* unhandled size */
+    }
+}
+
 static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
                              guchar *data, gulong num)
 {
@@ -225,21 +267,7 @@ static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
                              &ret_items, &bytes_left, &xdata);
     if (res == Success && ret_items && xdata) {
         if (ret_size == size && ret_items >= num) {
-            guint i;
-            for (i = 0; i < num; ++i)
-                switch (size) {
-                case 8:
-                    data[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
+            narrow(xdata, size, data, num);
             ret = TRUE;
         }
         XFree(xdata);
@@ -262,23 +290,8 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
                              &ret_items, &bytes_left, &xdata);
     if (res == Success) {
         if (ret_size == size && ret_items > 0) {
-            guint i;
-
             *data = g_malloc(ret_items * (size / 8));
-            for (i = 0; i < ret_items; ++i)
-                switch (size) {
-                case 8:
-                    (*data)[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)*data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)*data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
+            narrow(xdata, size, *data, ret_items);
             *num = ret_items;
             ret = TRUE;
         }
@@ -481,6 +494,43 @@ gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
     return get_all(win, prop, type, 32, (guchar**)ret, nret);
 }
 
+gboolean obt_prop_get_view32(Window win, Atom prop, Atom type,
+                             ObtPropView32 *view)
+{
+    gint res;
+    guchar *xdata = NULL;
+    Atom ret_type;
+    gint ret_size;
+    gulong ret_items, bytes_left;
+
+    res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
+                             FALSE, type, &ret_type, &ret_size,
+                             &ret_items, &bytes_left, &xdata);
+    if (res == Success && ret_size == 32 && ret_items > 0) {
+        /* Xlib's buffer is used as it is */
+        view->data = (gulong*)xdata;
+        view->num = ret_items;
+        return TRUE;
+    }
+    if (xdata) XFree(xdata);
+    return FALSE;
+}
+
+void obt_prop_view_free(ObtPropView32 *view)
+{
+    XFree(view->data);
+    view->data = NULL;
+    view->num = 0;
+}
+
+void obt_prop_view_narrow32(const ObtPropView32 *view, guint first,
+                            guint num, guint32 *out)
+{
+    g_assert(first + num <= view->num);
+
+    narrow((const guchar*)(view->data + first), 32, (guchar*)out, num);
+}
+
 gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
                            gchar **ret_string)
 {
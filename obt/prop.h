@@ -201,8 +201,8 @@ typedef enum {
     OBT_PROP_KDE_NET_WM_FRAME_STRUT,
     OBT_PROP_KDE_NET_WM_WINDOW_TYPE_OVERRIDE,
 
-/*
     OBT_PROP_ROOTPMAPID,
+/*
     OBT_PROP_ESETROOTID,
 */
 
@@ -246,10 +246,29 @@ typedef enum {
     OBT_PROP_TEXT_UTF8_STRING = 5,
 } ObtPropTextType;
 
+/*! An array property of 32-bit values, in the buffer that Xlib read it
+  into, so that it is not copied.  Xlib gives each value as a long. */
+typedef struct _ObtPropView32 ObtPropView32;
+
+struct _ObtPropView32 {
+    gulong *data;
+    guint num;
+};
+
 gboolean obt_prop_get32(Window win, Atom prop, Atom type, guint32 *ret);
 gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
                               guint *nret);
 
+/*! Read an array property of 32-bit values without copying it.  If this
+  returns TRUE, then free the view with obt_prop_view_free(). */
+gboolean obt_prop_get_view32(Window win, Atom prop, Atom type,
+                             ObtPropView32 *view);
+void obt_prop_view_free(ObtPropView32 *view);
+/*! Copy num values from the view, starting at first, into an array of
+  32-bit values */
+void obt_prop_view_narrow32(const ObtPropView32 *view, guint first,
+                            guint num, guint32 *out);
+
 gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
                            gchar **ret);
 gboolean obt_prop_get_array_text(Window win, Atom prop,
@@ -278,6 +297,8 @@ void obt_prop_message_to(Window to, Window about, Atom messagetype,
 #define OBT_PROP_GETA32(win, prop, type, ret, nret) \
     (obt_prop_get_array32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), \
                           ret, nret))
+#define OBT_PROP_GETV32(win, prop, type, view) \
+    (obt_prop_get_view32(win, OBT_PROP_ATOM(prop), OBT_PROP_ATOM(type), view))
 #define OBT_PROP_GETS(win, prop, ret) \
     (obt_prop_get_text(win, OBT_PROP_ATOM(prop), 0, ret))
 #define OBT_PROP_GETSS(win, prop, ret) \
@@ -0,0 +1,158 @@
+#/*
+#!/bin/sh
+#*/
+#if 0
+gcc -O0 -o ./desktoptest `pkg-config --cflags --libs glib-2.0 x11` \
+    desktoptest.c && \
+./desktoptest "$@"
+exit
+#endif
+
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   desktoptest.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Measures how long the running window manager takes to switch desktops.
+   Run it as "desktoptest [windows] [switches]", once with
+   <desktops><containers> turned off and once with it on.
+
+   The windows are opened on the first desktop and half of them are sent to
+   the second, then it switches between the two.  A switch is counted as done
+   once the root's _NET_CURRENT_DESKTOP has changed.  The window manager
+   sets it after it has sent everything else for the switch, so the server
+   has done all of that by then.  Windows don't change WM_STATE when
+   switching with containers, so it can't be waited for.
+*/
+
+#include <X11/Xlib.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static Display *d;
+static Atom wm_state, net_wm_desktop, net_current_desktop;
+
+static void send_message(Window w, Atom type, glong data)
+{
+    XEvent ce;
+
+    ce.xclient.type = ClientMessage;
+    ce.xclient.message_type = type;
+    ce.xclient.display = d;
+    ce.xclient.window = w;
+    ce.xclient.format = 32;
+    ce.xclient.data.l[0] = data;
+    ce.xclient.data.l[1] = CurrentTime;
+    ce.xclient.data.l[2] = 0;
+    ce.xclient.data.l[3] = 0;
+    ce.xclient.data.l[4] = 0;
+    XSendEvent(d, DefaultRootWindow(d), False,
+               SubstructureNotifyMask | SubstructureRedirectMask, &ce);
+    XFlush(d);
+}
+
+static void switch_desktop(glong desktop)
+{
+    send_message(DefaultRootWindow(d), net_current_desktop, desktop);
+}
+
+/* wait for a change to the property on n different windows */
+static void wait_props(GHashTable *seen, Atom prop, gint n)
+{
+    XEvent e;
+
+    g_hash_table_remove_all(seen);
+    while ((gint)g_hash_table_size(seen) < n) {
+        XNextEvent(d, &e);
+        if (e.type == PropertyNotify && e.xproperty.atom == prop)
+            g_hash_table_insert(seen, GUINT_TO_POINTER(e.xproperty.window),
+                                GUINT_TO_POINTER(1));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gint nwins = 500, nswitch = 20, i;
+    Window *wins;
+    GHashTable *seen;
+    GTimer *timer;
+    gdouble total = 0, min = G_MAXDOUBLE, max = 0;
+
+    if (argc > 1) nwins = MAX(atoi(argv[1]), 2);
+    if (argc > 2) nswitch = MAX(atoi(argv[2]), 1);
+
+    d = XOpenDisplay(NULL);
+    if (!d) {
+        fprintf(stderr, "couldn't open the display\n");
+        return 1;
+    }
+    wm_state = XInternAtom(d, "WM_STATE", False);
+    net_wm_desktop = XInternAtom(d, "_NET_WM_DESKTOP", False);
+    net_current_desktop = XInternAtom(d, "_NET_CURRENT_DESKTOP", False);
+
+    seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    XSelectInput(d, DefaultRootWindow(d), PropertyChangeMask);
+
+    /* start on the first desktop */
+    switch_desktop(0);
+
+    wins = g_new(Window, nwins);
+    for (i = 0; i < nwins; ++i) {
+        XSetWindowAttributes attrib;
+
+        attrib.event_mask = PropertyChangeMask;
+        wins[i] = XCreateWindow(d, DefaultRootWindow(d),
+                                (i * 7) % 600, (i * 5) % 400, 200, 150, 0,
+                                CopyFromParent, InputOutput, CopyFromParent,
+                                CWEventMask, &attrib);
+        XMapWindow(d, wins[i]);
+    }
+    XFlush(d);
+
+    /* wait for them all to be managed */
+    wait_props(seen, wm_state, nwins);
+
+    /* then send half of them to the second desktop */
+    for (i = 1; i < nwins; i += 2)
+        send_message(wins[i], net_wm_desktop, 1);
+    wait_props(seen, net_wm_desktop, nwins / 2);
+    printf("%d windows managed, switching %d times\n", nwins, nswitch);
+
+    timer = g_timer_new();
+    for (i = 0; i < nswitch; ++i) {
+        gdouble t;
+
+        g_timer_start(timer);
+        switch_desktop((i + 1) % 2);
+        wait_props(seen, net_current_desktop, 1);
+        t = g_timer_elapsed(timer, NULL) * 1000;
+
+        total += t;
+        min = MIN(min, t);
+        max = MAX(max, t);
+    }
+    printf("switch: avg %.2fms  min %.2fms  max %.2fms\n",
+           total / nswitch, min, max);
+
+    g_timer_destroy(timer);
+    g_hash_table_destroy(seen);
+    for (i = 0; i < nwins; ++i)
+        XDestroyWindow(d, wins[i]);
+    g_free(wins);
+    XCloseDisplay(d);
+    return 0;
+}
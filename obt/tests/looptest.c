@@ -0,0 +1,141 @@
+#/*
+#!/bin/sh
+#*/
+#if 0
+gcc -O0 -o ./looptest `pkg-config --cflags --libs obt-3.5 gthread-2.0` \
+    looptest.c && \
+./looptest "$@"
+exit
+#endif
+
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   looptest.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Measures the main loop.  Run it as "looptest" to use poll(), or as
+   "looptest epoll" to use obt_loop.
+
+   - wakeup: another thread writes a timestamp into a pipe, and the time until
+     the GIOChannel watch for it is dispatched is measured.
+   - idle: the loop runs for a few seconds with only the kind of timers that
+     a window manager keeps around, and the cpu time it used is reported.
+*/
+
+#include "obt/loop.h"
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define WAKEUPS 20000
+#define IDLE_SECONDS 5
+#define IDLE_TIMERS 8
+
+static gint wake_pipe[2], ack_pipe[2];
+static GMainLoop *loop;
+static guint wakeups = 0;
+static gint64 total_latency = 0, max_latency = 0;
+
+static gpointer writer(gpointer data)
+{
+    guint i;
+    gchar c;
+
+    for (i = 0; i < WAKEUPS; ++i) {
+        gint64 now = g_get_monotonic_time();
+        if (write(wake_pipe[1], &now, sizeof(now)) != sizeof(now)) break;
+        if (read(ack_pipe[0], &c, 1) != 1) break;
+    }
+    return NULL;
+}
+
+static gboolean wakeup(GIOChannel *ch, GIOCondition cond, gpointer data)
+{
+    gint64 sent, latency;
+    gchar c = 0;
+
+    if (read(wake_pipe[0], &sent, sizeof(sent)) != sizeof(sent))
+        return FALSE;
+
+    latency = g_get_monotonic_time() - sent;
+    total_latency += latency;
+    max_latency = MAX(max_latency, latency);
+
+    if (++wakeups == WAKEUPS)
+        g_main_loop_quit(loop);
+    if (write(ack_pipe[1], &c, 1) != 1)
+        return FALSE;
+    return TRUE;
+}
+
+static gboolean tick(gpointer data)
+{
+    return TRUE; /* repeat */
+}
+
+static gboolean stop(gpointer data)
+{
+    g_main_loop_quit(loop);
+    return FALSE;
+}
+
+static gdouble cpu_seconds(void)
+{
+    struct rusage r;
+
+    getrusage(RUSAGE_SELF, &r);
+    return (r.ru_utime.tv_sec + r.ru_stime.tv_sec) +
+        (r.ru_utime.tv_usec + r.ru_stime.tv_usec) / 1e6;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    GThread *thread;
+    gdouble cpu;
+    guint i;
+
+    if (argc > 1 && !strcmp(argv[1], "epoll"))
+        obt_loop_startup();
+    g_print("waiting with %s\n", obt_loop_epoll() ? "epoll" : "poll()");
+
+    loop = g_main_loop_new(NULL, FALSE);
+
+    /* the timers a window manager keeps around, which mostly never fire */
+    for (i = 0; i < IDLE_TIMERS; ++i)
+        g_timeout_add(100 + i * 250, tick, NULL);
+
+    if (pipe(wake_pipe) < 0 || pipe(ack_pipe) < 0)
+        return 1;
+    obt_loop_add(wake_pipe[0], G_IO_IN, wakeup, NULL);
+
+    thread = g_thread_new("writer", writer, NULL);
+    g_main_loop_run(loop);
+    g_thread_join(thread);
+
+    g_print("wakeup to dispatch: %.2f us average, %" G_GINT64_FORMAT
+            " us max, over %u wakeups\n",
+            (gdouble)total_latency / wakeups, max_latency, wakeups);
+
+    cpu = cpu_seconds();
+    g_timeout_add_seconds(IDLE_SECONDS, stop, NULL);
+    g_main_loop_run(loop);
+    g_print("cpu per idle second: %.3f ms\n",
+            (cpu_seconds() - cpu) * 1000.0 / IDLE_SECONDS);
+
+    g_main_loop_unref(loop);
+    obt_loop_shutdown();
+    return 0;
+}
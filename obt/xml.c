@@ -20,6 +20,7 @@
 #include "obt/paths.h"
 
 #include <libxml/xinclude.h>
+#include <libxml/xmlreader.h>
 #include <glib.h>
 
 #ifdef HAVE_STDLIB_H
@@ -38,6 +39,8 @@
 struct Callback {
     gchar *tag;
     ObtXmlCallback func;
+    ObtXmlOpenCallback open; /* for containers, instead of func */
+    ObtXmlCallback close;
     gpointer data;
 };
 
@@ -118,6 +121,29 @@ void obt_xml_register(ObtXmlInst *i, const gchar *tag,
     c = g_slice_new(struct Callback);
     c->tag = g_strdup(tag);
     c->func = func;
+    c->open = NULL;
+    c->close = NULL;
+    c->data = data;
+    g_hash_table_insert(i->callbacks, c->tag, c);
+}
+
+void obt_xml_register_container(ObtXmlInst *i, const gchar *tag,
+                                ObtXmlOpenCallback open,
+                                ObtXmlCallback close,
+                                gpointer data)
+{
+    struct Callback *c;
+
+    if (g_hash_table_lookup(i->callbacks, tag)) {
+        g_error("Tag '%s' already registered", tag);
+        return;
+    }
+
+    c = g_slice_new(struct Callback);
+    c->tag = g_strdup(tag);
+    c->func = NULL;
+    c->open = open;
+    c->close = close;
     c->data = data;
     g_hash_table_insert(i->callbacks, c->tag, c);
 }
@@ -304,6 +330,198 @@ gboolean obt_xml_load_mem(ObtXmlInst *i,
     return r;
 }
 
+/*! Run the callbacks for the document in the reader, as it is read.
+  Returns FALSE if the document is empty or its root node is wrong, in which
+  case no callbacks have been run. */
+static gboolean stream_reader(ObtXmlInst *i, xmlTextReaderPtr reader,
+                              const gchar *name, const gchar *root_node)
+{
+    GSList *open = NULL; /* the containers we are inside, innermost first */
+    gboolean root = FALSE;
+    gint ret;
+
+    ret = xmlTextReaderRead(reader);
+    while (ret == 1) {
+        gboolean skip = FALSE;
+
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
+            const xmlChar *tag = xmlTextReaderConstName(reader);
+
+            if (!root) {
+                if (xmlStrcmp(tag, (const xmlChar*)root_node)) {
+                    g_message("XML document %s is of wrong type. Root "
+                              "node is not '%s'", name, root_node);
+                    break;
+                }
+                root = TRUE;
+            }
+            else {
+                struct Callback *c = g_hash_table_lookup(i->callbacks, tag);
+
+                /* anything without a callback is skipped, along with its
+                   children, the same as obt_xml_tree() does */
+                skip = TRUE;
+
+                if (c && c->func) {
+                    xmlNodePtr node = xmlTextReaderExpand(reader);
+                    if (node) c->func(node, c->data);
+                }
+                else if (c) {
+                    xmlNodePtr node;
+
+                    node = xmlCopyNode(xmlTextReaderCurrentNode(reader), 2);
+                    if (c->open(node, c->data) &&
+                        !xmlTextReaderIsEmptyElement(reader))
+                    {
+                        /* read into the children, and close it when we
+                           reach its end */
+                        open = g_slist_prepend(open, node);
+                        skip = FALSE;
+                    }
+                    else {
+                        c->close(node, c->data);
+                        xmlFreeNode(node);
+                    }
+                }
+            }
+        }
+        else if (xmlTextReaderNodeType(reader) ==
+                 XML_READER_TYPE_END_ELEMENT && open)
+        {
+            /* the only elements that we walk into are containers, so this
+               is the end of the innermost one */
+            xmlNodePtr node = open->data;
+            struct Callback *c = g_hash_table_lookup(i->callbacks,
+                                                     node->name);
+
+            c->close(node, c->data);
+            xmlFreeNode(node);
+            open = g_slist_delete_link(open, open);
+        }
+
+        /* the reader frees the nodes that it has moved past */
+        if (skip)
+            ret = xmlTextReaderNext(reader);
+        else
+            ret = xmlTextReaderRead(reader);
+    }
+
+    /* close anything left open by a truncated document */
+    while (open) {
+        xmlNodePtr node = open->data;
+        struct Callback *c = g_hash_table_lookup(i->callbacks, node->name);
+
+        c->close(node, c->data);
+        xmlFreeNode(node);
+        open = g_slist_delete_link(open, open);
+    }
+
+    if (!root && ret != 1)
+        g_message("%s is an empty XML document", name);
+    return root;
+}
+
+static gboolean stream_file(ObtXmlInst *i,
+                            const gchar *domain,
+                            const gchar *filename,
+                            const gchar *root_node,
+                            GSList *paths)
+{
+    GSList *it;
+    gboolean r = FALSE;
+
+    g_assert(i->doc == NULL); /* another doc isn't open already? */
+
+    xmlResetLastError();
+
+    for (it = paths; !r && it; it = g_slist_next(it)) {
+        gchar *path;
+        struct stat s;
+
+        if (!domain && !filename) /* given a full path to the file */
+            path = g_strdup(it->data);
+        else
+            path = g_build_filename(it->data, domain, filename, NULL);
+
+        if (stat(path, &s) >= 0) {
+            xmlTextReaderPtr reader;
+
+            reader = xmlReaderForFile(path, NULL, (XML_PARSE_NOBLANKS |
+                                                   XML_PARSE_RECOVER |
+                                                   XML_PARSE_XINCLUDE));
+            if (reader) {
+                r = stream_reader(i, reader, path, root_node);
+                xmlFreeTextReader(reader);
+            }
+        }
+
+        g_free(path);
+    }
+
+    obt_xml_save_last_error(i);
+
+    return r;
+}
+
+gboolean obt_xml_stream_file(ObtXmlInst *i,
+                             const gchar *path,
+                             const gchar *root_node)
+{
+    GSList *paths;
+    gboolean r;
+
+    paths = g_slist_append(NULL, g_strdup(path));
+
+    r = stream_file(i, NULL, NULL, root_node, paths);
+
+    while (paths) {
+        g_free(paths->data);
+        paths = g_slist_delete_link(paths, paths);
+    }
+    return r;
+}
+
+gboolean obt_xml_stream_config_file(ObtXmlInst *i,
+                                    const gchar *domain,
+                                    const gchar *filename,
+                                    const gchar *root_node)
+{
+    GSList *it, *paths = NULL;
+    gboolean r;
+
+    for (it = obt_paths_config_dirs(i->xdg_paths); it; it = g_slist_next(it))
+        paths = g_slist_append(paths, g_strdup(it->data));
+
+    r = stream_file(i, domain, filename, root_node, paths);
+
+    while (paths) {
+        g_free(paths->data);
+        paths = g_slist_delete_link(paths, paths);
+    }
+    return r;
+}
+
+gboolean obt_xml_stream_mem(ObtXmlInst *i,
+                            gpointer data, guint len, const gchar *root_node)
+{
+    xmlTextReaderPtr reader;
+    gboolean r = FALSE;
+
+    g_assert(i->doc == NULL); /* another doc isn't open already? */
+
+    xmlResetLastError();
+
+    reader = xmlReaderForMemory(data, len, NULL, NULL, 0);
+    if (reader) {
+        r = stream_reader(i, reader, "Given memory", root_node);
+        xmlFreeTextReader(reader);
+    }
+
+    obt_xml_save_last_error(i);
+
+    return r;
+}
+
 static void obt_xml_save_last_error(ObtXmlInst* inst)
 {
     xmlErrorPtr error = xmlGetLastError();
@@ -368,7 +586,13 @@ void obt_xml_tree(ObtXmlInst *i, xmlNodePtr node)
     while (node) {
         if (node->name) {
             struct Callback *c = g_hash_table_lookup(i->callbacks, node->name);
-            if (c) c->func(node, c->data);
+            if (c && c->func)
+                c->func(node, c->data);
+            else if (c) {
+                if (c->open(node, c->data))
+                    obt_xml_tree(i, node->children);
+                c->close(node, c->data);
+            }
         }
         node = node->next;
     }
@@ -27,6 +27,10 @@ G_BEGIN_DECLS
 typedef struct _ObtXmlInst ObtXmlInst;
 
 typedef void (*ObtXmlCallback)(xmlNodePtr node, gpointer data);
+/*! Called when a container element is entered.  The node has the element's
+  attributes, but not its children.  Return TRUE to have the callbacks run
+  for the children, or FALSE to skip them. */
+typedef gboolean (*ObtXmlOpenCallback)(xmlNodePtr node, gpointer data);
 
 ObtXmlInst* obt_xml_instance_new(void);
 void obt_xml_instance_ref(ObtXmlInst *inst);
@@ -51,6 +55,22 @@ gboolean obt_xml_load_theme_file(ObtXmlInst *inst,
 gboolean obt_xml_load_mem(ObtXmlInst *inst,
                           gpointer data, guint len, const gchar *root_node);
 
+/*! Parse a file without building the whole document first.  Each element
+  that has a callback registered is handed to its callback as soon as it has
+  been read, and freed again afterwards.  Elements inside of a container are
+  streamed the same way, so the document is never held in memory at once.
+  No document is left open afterwards.
+*/
+gboolean obt_xml_stream_file(ObtXmlInst *inst,
+                             const gchar *path,
+                             const gchar *root_node);
+gboolean obt_xml_stream_config_file(ObtXmlInst *inst,
+                                    const gchar *domain,
+                                    const gchar *filename,
+                                    const gchar *root_node);
+gboolean obt_xml_stream_mem(ObtXmlInst *inst,
+                            gpointer data, guint len, const gchar *root_node);
+
 /* Returns true if an error is present. */
 gboolean obt_xml_last_error(ObtXmlInst *inst);
 gchar* obt_xml_last_error_file(ObtXmlInst *inst);
@@ -68,6 +88,13 @@ void obt_xml_close(ObtXmlInst *inst);
 
 void obt_xml_register(ObtXmlInst *inst, const gchar *tag,
                       ObtXmlCallback func, gpointer data);
+/*! Register a tag whose children are parsed with the registered callbacks
+  too.  open is called when the element starts and close once all of its
+  children have been handled, with the same node. */
+void obt_xml_register_container(ObtXmlInst *inst, const gchar *tag,
+                                ObtXmlOpenCallback open,
+                                ObtXmlCallback close,
+                                gpointer data);
 void obt_xml_unregister(ObtXmlInst *inst, const gchar *tag);
 void obt_xml_tree(ObtXmlInst *i, xmlNodePtr node);
 void obt_xml_tree_from_root(ObtXmlInst *i);
@@ -0,0 +1,275 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   animate.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "animate.h"
+#include "openbox.h"
+#include "debug.h"
+#include "obt/display.h"
+
+/*! The tick rate to use when the screen's refresh rate is not known */
+#define ANIMATE_DEFAULT_RATE 60
+#define ANIMATE_MIN_RATE 20
+#define ANIMATE_MAX_RATE 240
+
+typedef struct _ObAnimation ObAnimation;
+
+struct _ObAnimation {
+    guint id;
+    gint64 interval; /* usec, 0 to step on every tick */
+    gint64 due;      /* when to step it next */
+    ObAnimateFunc func;
+    gpointer data;
+    GDestroyNotify notify;
+    gboolean dead;   /* removed while the animations were being stepped */
+};
+
+static GSList *animations = NULL;
+static guint next_id = 1;
+static guint tick_timer = 0;
+static gint64 tick_time = 0; /* when tick_timer will fire */
+static gint64 tick_period = G_USEC_PER_SEC / ANIMATE_DEFAULT_RATE;
+static gboolean ticking = FALSE;
+#ifdef XRANDR
+/*! If the server can tell us its current modes without probing the
+  outputs for new ones (RandR 1.3) */
+static gboolean randr_current = FALSE;
+#endif
+
+static void schedule(void);
+
+void animate_startup(gboolean reconfig)
+{
+#ifdef XRANDR
+    if (!reconfig && obt_display_extension_randr) {
+        gint major, minor;
+
+        randr_current = XRRQueryVersion(obt_display, &major, &minor) &&
+            (major > 1 || (major == 1 && minor >= 3));
+        /* be told when the modes change, instead of asking */
+        if (randr_current)
+            XRRSelectInput(obt_display, obt_root(ob_screen),
+                           RRScreenChangeNotifyMask);
+    }
+#endif
+    animate_update_rate();
+}
+
+void animate_shutdown(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    while (animations)
+        animate_remove(((ObAnimation*)animations->data)->id);
+    if (tick_timer) g_source_remove(tick_timer);
+    tick_timer = 0;
+}
+
+gint64 animate_time(void)
+{
+#if GLIB_CHECK_VERSION(2,28,0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now;
+
+    g_get_current_time(&now);
+    return (gint64)now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+#ifdef XRANDR
+/*! Returns the refresh rate of the fastest monitor, or 0 if it isn't known */
+static gint current_rate(void)
+{
+    XRRScreenResources *res;
+    gint i, j, rate = 0;
+
+    /* this uses the modes the server already knows about, it doesn't make
+       it look at the outputs again the way XRRGetScreenInfo does */
+    res = XRRGetScreenResourcesCurrent(obt_display, obt_root(ob_screen));
+    if (!res) return 0;
+
+    for (i = 0; i < res->ncrtc; ++i) {
+        XRRCrtcInfo *crtc;
+
+        crtc = XRRGetCrtcInfo(obt_display, res, res->crtcs[i]);
+        if (!crtc) continue;
+
+        for (j = 0; crtc->mode != None && j < res->nmode; ++j) {
+            const XRRModeInfo *m = &res->modes[j];
+            gdouble r;
+
+            if (m->id != crtc->mode || !m->hTotal || !m->vTotal) continue;
+
+            r = (gdouble)m->dotClock / ((gdouble)m->hTotal * m->vTotal);
+            if (m->modeFlags & RR_Interlace) r *= 2;
+            if (m->modeFlags & RR_DoubleScan) r /= 2;
+            rate = MAX(rate, (gint)(r + 0.5));
+        }
+        XRRFreeCrtcInfo(crtc);
+    }
+    XRRFreeScreenResources(res);
+    return rate;
+}
+#endif
+
+void animate_update_rate(void)
+{
+    gint rate = 0;
+
+#ifdef XRANDR
+    if (randr_current)
+        rate = current_rate();
+#endif
+    if (rate <= 0)
+        rate = ANIMATE_DEFAULT_RATE;
+    rate = CLAMP(rate, ANIMATE_MIN_RATE, ANIMATE_MAX_RATE);
+
+    if (tick_period != G_USEC_PER_SEC / rate) {
+        ob_debug("Animating at %d Hz", rate);
+        tick_period = G_USEC_PER_SEC / rate;
+        schedule();
+    }
+}
+
+static void animation_free(ObAnimation *a)
+{
+    g_slice_free(ObAnimation, a);
+}
+
+static gboolean tick(gpointer data)
+{
+    GSList *it, *copy;
+    gint64 now;
+    gboolean stepped = FALSE;
+
+    tick_timer = 0;
+    now = animate_time();
+
+    /* step everything that is due on this tick.  anything that will be due
+       before the middle of the next tick is stepped now too, so that
+       animations which were started at different times end up in step. */
+    ticking = TRUE;
+    copy = g_slist_copy(animations);
+    for (it = copy; it; it = g_slist_next(it)) {
+        ObAnimation *a = it->data;
+
+        if (a->dead || a->due - tick_period / 2 > now) continue;
+
+        stepped = TRUE;
+        if (a->func(now, a->data))
+            a->due = now + MAX(a->interval, tick_period);
+        else if (!a->dead)
+            animate_remove(a->id);
+    }
+    ticking = FALSE;
+
+    /* send all of the changes from this tick together */
+    if (stepped) XFlush(obt_display);
+
+    g_slist_free(copy);
+
+    /* free the ones that were removed while stepping */
+    for (it = animations; it;) {
+        ObAnimation *a = it->data;
+        GSList *next = g_slist_next(it);
+
+        if (a->dead) {
+            animations = g_slist_delete_link(animations, it);
+            animation_free(a);
+        }
+        it = next;
+    }
+
+    schedule();
+    return FALSE; /* schedule() makes a new timer if needed */
+}
+
+/*! Set the timer to fire on the first tick where an animation is due */
+static void schedule(void)
+{
+    GSList *it;
+    gint64 due = G_MAXINT64, now;
+    guint ms;
+
+    if (ticking) return; /* tick() will call this when it is done */
+
+    for (it = animations; it; it = g_slist_next(it)) {
+        ObAnimation *a = it->data;
+        if (!a->dead) due = MIN(due, a->due);
+    }
+
+    if (due == G_MAXINT64) {
+        /* nothing to animate, so let the main loop sleep */
+        if (tick_timer) g_source_remove(tick_timer);
+        tick_timer = 0;
+        return;
+    }
+
+    /* ticks fall on multiples of the tick period, so that everything steps
+       together no matter when it started */
+    due = (due + tick_period - 1) / tick_period * tick_period;
+
+    if (tick_timer) {
+        if (tick_time <= due) return; /* the timer will come soon enough */
+        g_source_remove(tick_timer);
+    }
+
+    now = animate_time();
+    ms = due > now ? (due - now + 999) / 1000 : 0;
+    tick_time = due;
+    tick_timer = g_timeout_add_full(G_PRIORITY_DEFAULT, ms, tick, NULL, NULL);
+}
+
+guint animate_add(guint interval, ObAnimateFunc func, gpointer data,
+                  GDestroyNotify notify)
+{
+    ObAnimation *a;
+
+    a = g_slice_new(ObAnimation);
+    a->id = next_id++;
+    if (!next_id) next_id = 1; /* 0 is not a valid id */
+    a->interval = (gint64)interval * 1000;
+    a->due = animate_time() + a->interval;
+    a->func = func;
+    a->data = data;
+    a->notify = notify;
+    a->dead = FALSE;
+    animations = g_slist_prepend(animations, a);
+
+    schedule();
+    return a->id;
+}
+
+void animate_remove(guint id)
+{
+    GSList *it;
+
+    for (it = animations; it; it = g_slist_next(it)) {
+        ObAnimation *a = it->data;
+
+        if (a->id == id && !a->dead) {
+            a->dead = TRUE;
+            if (!ticking) {
+                animations = g_slist_delete_link(animations, it);
+                schedule();
+            }
+            if (a->notify) a->notify(a->data);
+            if (!ticking) animation_free(a);
+            break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   animate.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __animate_h
+#define __animate_h
+
+#include <glib.h>
+
+/*! Steps an animation.
+  @param now The time of the current tick, from animate_time()
+  @return TRUE to keep the animation going, or FALSE if it is done
+*/
+typedef gboolean (*ObAnimateFunc)(gint64 now, gpointer data);
+
+void animate_startup(gboolean reconfig);
+void animate_shutdown(gboolean reconfig);
+
+/*! Returns the current time in microseconds, from a clock that does not jump
+  when the system time is changed */
+gint64 animate_time(void);
+
+/*! Start an animation.  Every animation is stepped from a single timer, on
+  the same ticks, and the timer is only running while there are animations.
+  @param interval How many milliseconds between each step of the animation,
+                  or 0 to step it on every tick
+  @param notify Called with the data when the animation is over, either
+                because the func returned FALSE or it was removed
+  @return An id for the animation, to pass to animate_remove()
+*/
+guint animate_add(guint interval, ObAnimateFunc func, gpointer data,
+                  GDestroyNotify notify);
+
+/*! Stop an animation before it is done */
+void animate_remove(guint id);
+
+/*! Find the refresh rate of the screen again, and tick at that rate.  Call
+  this when the screen's configuration changes. */
+void animate_update_rate(void);
+
+#endif
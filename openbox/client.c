@@ -28,6 +28,7 @@
 #include "frame.h"
 #include "session.h"
 #include "event.h"
+#include "publish.h"
 #include "grab.h"
 #include "prompt.h"
 #include "focus.h"
@@ -39,6 +40,7 @@
 #include "menuframe.h"
 #include "keyboard.h"
 #include "mouse.h"
+#include "edge_index.h"
 #include "obrender/render.h"
 #include "gettext.h"
 #include "obt/display.h"
@@ -69,10 +71,35 @@ typedef struct
     gpointer data;
 } ClientCallback;
 
+/*! An icon imported from a WM_HINTS icon pixmap and mask */
+struct _ObClientIcon
+{
+    Pixmap pixmap;
+    Pixmap mask;
+    /* the pixmap's geometry when it was imported, if the pixmap is freed
+       and the id reused then this will likely differ */
+    guint w, h, depth;
+    RrImage *image;
+    guint users;
+};
+
 GList          *client_list             = NULL;
 
 static GSList  *client_destroy_notifies = NULL;
 static RrImage *client_default_icon     = NULL;
+/*! Imported WM_HINTS icons, keyed by their pixmap and mask.  Applications
+  often give all of their windows the same icon pixmap, and set their
+  WM_HINTS again and again, so they are only read from the server once. */
+static GHashTable *client_legacy_icons  = NULL;
+/*! The clients' frames on each desktop, for finding edges and directional
+  focus.  The ones on all desktops are in their own index. */
+static GPtrArray   *client_edges        = NULL;
+static ObEdgeIndex *client_edges_all    = NULL;
+/*! The clients which need to be moved in the edge indexes before the next
+  search */
+static GSList      *client_edges_dirty  = NULL;
+/*! The rank given to the last client added to the client_list */
+static guint        client_edge_rank    = 0;
 
 static void client_get_all(ObClient *self, gboolean real);
 static void client_get_startup_id(ObClient *self);
@@ -90,6 +117,12 @@ static void client_set_desktop_recursive(ObClient *self,
 static void client_change_allowed_actions(ObClient *self);
 static void client_change_state(ObClient *self);
 static void client_change_wm_state(ObClient *self);
+static void client_configure_apply(ObClient *self,
+                                   const Rect *oldframe_p,
+                                   const Rect *oldclient_p,
+                                   guint fdecor, gboolean fhorz,
+                                   gboolean fvert, gboolean user,
+                                   gboolean final, gboolean force_reply);
 static void client_apply_startup_state(ObClient *self,
                                        gint x, gint y, gint w, gint h);
 static void client_restore_session_state(ObClient *self);
@@ -107,6 +140,8 @@ static GSList *client_search_all_top_parents_internal(ObClient *self,
                                                       ObStackingLayer layer);
 static void client_call_notifies(ObClient *self, GSList *list);
 static void client_ping_event(ObClient *self, gboolean dead);
+static RrImage* client_legacy_icon(ObClient *self);
+static void client_release_legacy_icon(ObClient *self);
 static void client_prompt_kill(ObClient *self);
 static gboolean client_can_steal_focus(ObClient *self,
                                        gboolean allow_other_desktop,
@@ -114,6 +149,19 @@ static gboolean client_can_steal_focus(ObClient *self,
                                        Time steal_time, Time launch_time);
 static void client_setup_default_decor_and_functions(ObClient *self);
 static void client_setup_decor_undecorated(ObClient *self);
+static void client_edges_forget(ObClient *self);
+
+static guint legacy_icon_hash(gconstpointer key)
+{
+    const struct _ObClientIcon *i = key;
+    return i->pixmap ^ (i->mask << 16);
+}
+
+static gboolean legacy_icon_equal(gconstpointer a, gconstpointer b)
+{
+    const struct _ObClientIcon *i = a, *j = b;
+    return i->pixmap == j->pixmap && i->mask == j->mask;
+}
 
 void client_startup(gboolean reconfig)
 {
@@ -123,6 +171,10 @@ void client_startup(gboolean reconfig)
 
     if (reconfig) return;
 
+    client_legacy_icons = g_hash_table_new(legacy_icon_hash,
+                                           legacy_icon_equal);
+    client_edges = g_ptr_array_new();
+    client_edges_all = edge_index_new();
     client_set_list();
 }
 
@@ -132,6 +184,17 @@ void client_shutdown(gboolean reconfig)
     client_default_icon = NULL;
 
     if (reconfig) return;
+
+    /* the clients are all gone, and they released their icons */
+    g_assert(g_hash_table_size(client_legacy_icons) == 0);
+    g_hash_table_destroy(client_legacy_icons);
+    client_legacy_icons = NULL;
+
+    g_ptr_array_foreach(client_edges, (GFunc)edge_index_free, NULL);
+    g_ptr_array_free(client_edges, TRUE);
+    client_edges = NULL;
+    edge_index_free(client_edges_all);
+    client_edges_all = NULL;
 }
 
 static void client_call_notifies(ObClient *self, GSList *list)
@@ -182,7 +245,7 @@ void client_remove_destroy_notify_data(ObClientCallback func, gpointer data)
     }
 }
 
-void client_set_list(void)
+static void client_set_list_now(gpointer data)
 {
     Window *windows, *win_it;
     GList *it;
@@ -197,8 +260,9 @@ void client_set_list(void)
     } else
         windows = NULL;
 
-    OBT_PROP_SETA32(obt_root(ob_screen), NET_CLIENT_LIST, WINDOW,
-                    (gulong*)windows, size);
+    /* new windows are at the end of the list, so often they can just be
+       appended */
+    PUBLISH_SETA32(NET_CLIENT_LIST, WINDOW, (gulong*)windows, size);
 
     if (windows)
         g_free(windows);
@@ -206,6 +270,13 @@ void client_set_list(void)
     stacking_set_list();
 }
 
+void client_set_list(void)
+{
+    /* managing or unmanaging several windows at once only needs the list
+       set once */
+    event_defer(client_set_list_now, NULL);
+}
+
 void client_manage(Window window, ObPrompt *prompt)
 {
     ObClient *self;
@@ -482,6 +553,10 @@ void client_manage(Window window, ObPrompt *prompt)
        on map. */
     OBT_PROP_SET32(self->window, NET_WM_DESKTOP, CARDINAL, self->desktop);
 
+    /* put the frame in its desktop's container before it is shown */
+    if (frame_adjust_parent(self->frame))
+        stacking_refresh(CLIENT_AS_WINDOW(self));
+
     /* grab mouse bindings before showing the window */
     mouse_grab_for_client(self, TRUE);
 
@@ -525,6 +600,10 @@ void client_manage(Window window, ObPrompt *prompt)
     /* add to client list/map */
     client_list = g_list_append(client_list, self);
     window_add(&self->window, CLIENT_AS_WINDOW(self));
+    /* searching the edge indexes goes through the clients in the same order
+       as the client_list */
+    self->edge_rank = ++client_edge_rank;
+    client_edges_changed(self);
 
     /* this has to happen after we're in the client_list */
     if (STRUT_EXISTS(self->strut))
@@ -689,6 +768,7 @@ void client_unmanage(ObClient *self)
     frame_release_client(self->frame);
     frame_free(self->frame);
     self->frame = NULL;
+    client_edges_forget(self);
 
     if (ob_state() != OB_STATE_EXITING) {
         /* these values should not be persisted across a window
@@ -715,6 +795,7 @@ void client_unmanage(ObClient *self)
 
     /* free all data allocated in the client struct */
     RrImageUnref(self->icon_set);
+    client_release_legacy_icon(self);
     g_slist_free(self->transients);
     g_free(self->startup_id);
     g_free(self->wm_command);
@@ -736,6 +817,7 @@ void client_fake_unmanage(ObClient *self)
     /* this is all that got allocated to get the decorations */
 
     frame_free(self->frame);
+    client_edges_forget(self);
     g_slice_free(ObClient, self);
 }
 
@@ -1343,12 +1425,13 @@ static void client_get_desktop(ObClient *self)
 
 static void client_get_state(ObClient *self)
 {
-    guint32 *state;
-    guint num;
+    ObtPropView32 v;
 
-    if (OBT_PROP_GETA32(self->window, NET_WM_STATE, ATOM, &state, &num)) {
-        gulong i;
-        for (i = 0; i < num; ++i) {
+    if (OBT_PROP_GETV32(self->window, NET_WM_STATE, ATOM, &v)) {
+        const gulong *state = v.data;
+        guint i;
+
+        for (i = 0; i < v.num; ++i) {
             if (state[i] == OBT_PROP_ATOM(NET_WM_STATE_MODAL))
                 self->modal = TRUE;
             else if (state[i] == OBT_PROP_ATOM(NET_WM_STATE_SHADED))
@@ -1375,7 +1458,7 @@ static void client_get_state(ObClient *self)
                 self->undecorated = TRUE;
         }
 
-        g_free(state);
+        obt_prop_view_free(&v);
     }
 }
 
@@ -2083,9 +2166,23 @@ void client_update_wmhints(ObClient *self)
                 client_update_transient_for(self);
         }
 
-        /* the WM_HINTS can contain an icon */
-        if (hints->flags & IconPixmapHint)
-            client_update_icons(self);
+        /* the WM_HINTS can contain an icon, but only look at it again if
+           the pixmaps are different, as some applications change their
+           WM_HINTS much more often than their icon */
+        {
+            Pixmap icon = None, mask = None;
+
+            if (hints->flags & IconPixmapHint) {
+                icon = hints->icon_pixmap;
+                if (hints->flags & IconMaskHint)
+                    mask = hints->icon_mask;
+            }
+            if (icon != self->wmhints_icon || mask != self->wmhints_mask) {
+                self->wmhints_icon = icon;
+                self->wmhints_mask = mask;
+                client_update_icons(self);
+            }
+        }
 
         XFree(hints);
     }
@@ -2169,27 +2266,27 @@ void client_update_title(ObClient *self)
 
 void client_update_strut(ObClient *self)
 {
-    guint num;
-    guint32 *data;
+    ObtPropView32 v;
+    const gulong *data;
     gboolean got = FALSE;
     StrutPartial strut;
 
-    if (OBT_PROP_GETA32(self->window, NET_WM_STRUT_PARTIAL, CARDINAL,
-                        &data, &num))
-    {
-        if (num == 12) {
+    if (OBT_PROP_GETV32(self->window, NET_WM_STRUT_PARTIAL, CARDINAL, &v)) {
+        data = v.data;
+        if (v.num == 12) {
             got = TRUE;
             STRUT_PARTIAL_SET(strut,
                               data[0], data[2], data[1], data[3],
                               data[4], data[5], data[8], data[9],
                               data[6], data[7], data[10], data[11]);
         }
-        g_free(data);
+        obt_prop_view_free(&v);
     }
 
     if (!got &&
-        OBT_PROP_GETA32(self->window, NET_WM_STRUT, CARDINAL, &data, &num)) {
-        if (num == 4) {
+        OBT_PROP_GETV32(self->window, NET_WM_STRUT, CARDINAL, &v)) {
+        data = v.data;
+        if (v.num == 4) {
             const Rect *a;
 
             got = TRUE;
@@ -2204,7 +2301,7 @@ void client_update_strut(ObClient *self)
                               a->y, a->y + a->height - 1,
                               a->x, a->x + a->width - 1);
         }
-        g_free(data);
+        obt_prop_view_free(&v);
     }
 
     if (!got)
@@ -2223,9 +2320,8 @@ void client_update_strut(ObClient *self)
 
 void client_update_icons(ObClient *self)
 {
-    guint num;
-    guint32 *data;
-    guint w, h, i, j;
+    ObtPropView32 v;
+    guint w, h, i;
     RrImage *img;
 
     img = NULL;
@@ -2235,69 +2331,67 @@ void client_update_icons(ObClient *self)
        icon */
     grab_server(TRUE);
 
-    if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num)) {
+    if (OBT_PROP_GETV32(self->window, NET_WM_ICON, CARDINAL, &v)) {
+        RrPixel32 *pixels = NULL;
+        guint pixels_size = 0;
+
         /* figure out how many valid icons are in here */
         i = 0;
-        while (i + 2 < num) { /* +2 is to make sure there is a w and h */
-            w = data[i++];
-            h = data[i++];
+        while (i + 2 < v.num) { /* +2 is to make sure there is a w and h */
+            w = v.data[i++];
+            h = v.data[i++];
             /* watch for the data being too small for the specified size,
                or for zero sized icons. */
-            if (i + w*h > num || w == 0 || h == 0) {
+            if (i + w*h > v.num || w == 0 || h == 0) {
                 i += w*h;
                 continue;
             }
 
-            /* convert it to the right bit order for ObRender */
-            for (j = 0; j < w*h; ++j)
-                data[i+j] =
-                    (((data[i+j] >> 24) & 0xff) << RrDefaultAlphaOffset) +
-                    (((data[i+j] >> 16) & 0xff) << RrDefaultRedOffset)   +
-                    (((data[i+j] >>  8) & 0xff) << RrDefaultGreenOffset) +
-                    (((data[i+j] >>  0) & 0xff) << RrDefaultBlueOffset);
+            /* each icon is copied out of the property once, into a buffer
+               that is big enough for the biggest one so far */
+            if (w*h > pixels_size) {
+                pixels_size = w*h;
+                pixels = g_renew(RrPixel32, pixels, pixels_size);
+            }
+
+#if RrDefaultAlphaOffset == 24 && RrDefaultRedOffset == 16 && \
+    RrDefaultGreenOffset == 8 && RrDefaultBlueOffset == 0
+            /* ObRender uses the same bit order, so just make them 32-bit */
+            obt_prop_view_narrow32(&v, i, w*h, pixels);
+#else
+            {
+                guint j;
+
+                /* convert it to the right bit order for ObRender */
+                for (j = 0; j < w*h; ++j) {
+                    const gulong p = v.data[i+j];
+                    pixels[j] = (((p >> 24) & 0xff) << RrDefaultAlphaOffset) +
+                                (((p >> 16) & 0xff) << RrDefaultRedOffset)   +
+                                (((p >>  8) & 0xff) << RrDefaultGreenOffset) +
+                                (((p >>  0) & 0xff) << RrDefaultBlueOffset);
+                }
+            }
+#endif
 
             /* add it to the image cache as an original */
             if (!img)
-                img = RrImageNewFromData(ob_rr_icons, &data[i], w, h);
+                img = RrImageNewFromData(ob_rr_icons, pixels, w, h);
             else
-                RrImageAddFromData(img, &data[i], w, h);
+                RrImageAddFromData(img, pixels, w, h);
 
             i += w*h;
         }
 
-        g_free(data);
+        g_free(pixels);
+        obt_prop_view_free(&v);
     }
 
     /* if we didn't find an image from the NET_WM_ICON stuff, then try the
        legacy X hints */
-    if (!img) {
-        XWMHints *hints;
-
-        if ((hints = XGetWMHints(obt_display, self->window))) {
-            if (hints->flags & IconPixmapHint) {
-                gboolean xicon;
-                obt_display_ignore_errors(TRUE);
-                xicon = RrPixmapToRGBA(ob_rr_inst,
-                                       hints->icon_pixmap,
-                                       (hints->flags & IconMaskHint ?
-                                        hints->icon_mask : None),
-                                       (gint*)&w, (gint*)&h, &data);
-                obt_display_ignore_errors(FALSE);
-
-                if (xicon) {
-                    if (w > 0 && h > 0) {
-                        if (!img)
-                            img = RrImageNewFromData(ob_rr_icons, data, w, h);
-                        else
-                            RrImageAddFromData(img, data, w, h);
-                    }
-
-                    g_free(data);
-                }
-            }
-            XFree(hints);
-        }
-    }
+    if (!img)
+        img = client_legacy_icon(self);
+    else
+        client_release_legacy_icon(self);
 
     /* set the client's icons to be whatever we found */
     RrImageUnref(self->icon_set);
@@ -2330,6 +2424,82 @@ void client_update_icons(ObClient *self)
     grab_server(FALSE);
 }
 
+/*! Returns the icon from the pixmaps in the window's WM_HINTS, with a new
+  reference, or NULL if it doesn't have one */
+static RrImage* client_legacy_icon(ObClient *self)
+{
+    struct _ObClientIcon key, *icon;
+    Window xr;
+    gint xx, xy;
+    guint w, h, xb, depth;
+    gboolean ok;
+
+    if (!self->wmhints_icon) {
+        client_release_legacy_icon(self);
+        return NULL;
+    }
+
+    key.pixmap = self->wmhints_icon;
+    key.mask = self->wmhints_mask;
+    if (!(icon = g_hash_table_lookup(client_legacy_icons, &key))) {
+        icon = g_slice_new0(struct _ObClientIcon);
+        icon->pixmap = key.pixmap;
+        icon->mask = key.mask;
+        g_hash_table_insert(client_legacy_icons, icon, icon);
+    }
+
+    /* start using the icon before releasing the old one, in case they are
+       the same */
+    ++icon->users;
+    client_release_legacy_icon(self);
+    self->legacy_icon = icon;
+
+    /* only read the pixmap again if it doesn't look like the same one */
+    obt_display_ignore_errors(TRUE);
+    ok = XGetGeometry(obt_display, icon->pixmap,
+                      &xr, &xx, &xy, &w, &h, &xb, &depth);
+    if (ok && !(icon->image &&
+                w == icon->w && h == icon->h && depth == icon->depth))
+    {
+        RrPixel32 *data;
+        gint iw, ih;
+
+        RrImageUnref(icon->image);
+        icon->image = NULL;
+
+        if (RrPixmapToRGBA(ob_rr_inst, icon->pixmap, icon->mask,
+                           &iw, &ih, &data))
+        {
+            if (iw > 0 && ih > 0)
+                icon->image = RrImageNewFromData(ob_rr_icons, data, iw, ih);
+            g_free(data);
+        }
+        icon->w = w;
+        icon->h = h;
+        icon->depth = depth;
+    }
+    obt_display_ignore_errors(FALSE);
+
+    if (!ok || !icon->image)
+        return NULL;
+    RrImageRef(icon->image);
+    return icon->image;
+}
+
+static void client_release_legacy_icon(ObClient *self)
+{
+    struct _ObClientIcon *icon = self->legacy_icon;
+
+    if (!icon) return;
+
+    self->legacy_icon = NULL;
+    if (--icon->users == 0) {
+        g_hash_table_remove(client_legacy_icons, icon);
+        RrImageUnref(icon->image);
+        g_slice_free(struct _ObClientIcon, icon);
+    }
+}
+
 void client_update_icon_geometry(ObClient *self)
 {
     guint num;
@@ -2506,8 +2676,12 @@ static void client_change_wm_state(ObClient *self)
 
     old = self->wmstate;
 
+    /* with desktop containers, windows on other desktops stay mapped in
+       their container, like with a virtual root, so they stay in
+       NormalState and switching desktops doesn't touch them */
     if (self->shaded || self->iconic ||
-        (self->desktop != DESKTOP_ALL && self->desktop != screen_desktop))
+        (!screen_use_containers() &&
+         self->desktop != DESKTOP_ALL && self->desktop != screen_desktop))
     {
         self->wmstate = IconicState;
     } else
@@ -2528,6 +2702,11 @@ static void client_change_state(ObClient *self)
     gulong netstate[12];
     guint num;
 
+    if (self->transaction) {
+        self->pending.state = TRUE;
+        return;
+    }
+
     num = 0;
     if (self->modal)
         netstate[num++] = OBT_PROP_ATOM(NET_WM_STATE_MODAL);
@@ -2703,6 +2882,11 @@ void client_calc_layer(ObClient *self)
 {
     GList *it;
 
+    if (self->transaction) {
+        self->pending.layer = TRUE;
+        return;
+    }
+
     /* skip over stuff above fullscreen layer */
     for (it = stacking_list; it; it = g_list_next(it))
         if (window_layer(it->data) <= OB_STACKING_LAYER_FULLSCREEN) break;
@@ -2785,7 +2969,13 @@ gboolean client_hide(ObClient *self)
            should be going to the window */
         mouse_replay_pointer();
 
-        frame_hide(self->frame);
+        /* when the window is only being hidden because it is on another
+           desktop, its desktop's container is what hides it */
+        if (screen_use_containers() && !self->iconic &&
+            !(client_normal(self) && screen_showing_desktop()))
+            frame_hide_in_container(self->frame);
+        else
+            frame_hide(self->frame);
         hide = TRUE;
 
         /* According to the ICCCM (sec 4.1.3.1) when a window is not visible,
@@ -2883,6 +3073,8 @@ static void client_apply_startup_state(ObClient *self,
     if (demands_attention)
         client_hilite(self, TRUE);
 
+    client_begin(self);
+
     if (max_vert && max_horz)
         client_maximize(self, TRUE, 0);
     else if (max_vert)
@@ -2908,8 +3100,14 @@ static void client_apply_startup_state(ObClient *self,
        not, so this needs to be called even if we have fullscreened/maxed
     */
     self->area = oldarea;
+    /* the states above were applied from the placed area, but the window
+       itself was never moved away from oldarea */
+    if (self->pending.configure)
+        self->pending.oldclient = oldarea;
     client_configure(self, x, y, w, h, FALSE, TRUE, FALSE);
 
+    client_commit(self);
+
     /* nothing to do for the other states:
        skip_taskbar
        skip_pager
@@ -3166,9 +3364,6 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
                       gboolean user, gboolean final, gboolean force_reply)
 {
     Rect oldframe, oldclient;
-    gboolean send_resize_client;
-    gboolean moved = FALSE, resized = FALSE, rootmoved = FALSE;
-    gboolean fmoved, fresized;
     guint fdecor = self->frame->decorations;
     gboolean fhorz = self->frame->max_horz;
     gboolean fvert = self->frame->max_vert;
@@ -3181,14 +3376,64 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
     if (!(w == self->area.width && h == self->area.height))
         SIZE_SET(self->logical_size, logicalw, logicalh);
 
-    /* figure out if we moved or resized or what */
-    moved = (x != self->area.x || y != self->area.y);
-    resized = (w != self->area.width || h != self->area.height);
-
     oldframe = self->frame->area;
     oldclient = self->area;
     RECT_SET(self->area, x, y, w, h);
 
+    if (self->transaction) {
+        /* remember where things were before the first change, and send them
+           all to the server at once in client_commit() */
+        if (!self->pending.configure) {
+            self->pending.configure = TRUE;
+            self->pending.oldframe = oldframe;
+            self->pending.oldclient = oldclient;
+            self->pending.fdecor = fdecor;
+            self->pending.fhorz = fhorz;
+            self->pending.fvert = fvert;
+            self->pending.final = final;
+            self->pending.force_reply = force_reply;
+            self->pending.user = user;
+        } else {
+            /* merge with the configure that is waiting.  it is only treated
+               as coming from the user if all of them did */
+            self->pending.final = self->pending.final || final;
+            self->pending.force_reply =
+                self->pending.force_reply || force_reply;
+            self->pending.user = self->pending.user && user;
+        }
+
+        /* keep the frame's area right for anything that looks at it before
+           the commit, without changing anything visible */
+        frame_adjust_area(self->frame, FALSE, TRUE, TRUE);
+        self->frame->area.x = x;
+        self->frame->area.y = y;
+        frame_client_gravity(self->frame,
+                             &self->frame->area.x, &self->frame->area.y);
+        return;
+    }
+
+    client_configure_apply(self, &oldframe, &oldclient, fdecor, fhorz, fvert,
+                           user, final, force_reply);
+}
+
+static void client_configure_apply(ObClient *self,
+                                   const Rect *oldframe_p,
+                                   const Rect *oldclient_p,
+                                   guint fdecor, gboolean fhorz,
+                                   gboolean fvert, gboolean user,
+                                   gboolean final, gboolean force_reply)
+{
+    Rect oldframe = *oldframe_p, oldclient = *oldclient_p;
+    gint x = self->area.x, y = self->area.y;
+    gint w = self->area.width, h = self->area.height;
+    gboolean send_resize_client;
+    gboolean moved = FALSE, resized = FALSE, rootmoved = FALSE;
+    gboolean fmoved, fresized;
+
+    /* figure out if we moved or resized or what */
+    moved = (x != oldclient.x || y != oldclient.y);
+    resized = (w != oldclient.width || h != oldclient.height);
+
     /* for app-requested resizes, always resize if 'resized' is true.
        for user-requested ones, only resize if final is true, or when
        resizing in redraw mode */
@@ -3317,6 +3562,63 @@ void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
     }
 }
 
+void client_begin(ObClient *self)
+{
+    if (!self->transaction++) {
+        self->pending.configure = FALSE;
+        self->pending.state = FALSE;
+        self->pending.layer = FALSE;
+        self->pending.frame = FALSE;
+    }
+}
+
+/*! Send the move/resize gathered in the client's transaction, if there is
+  one.  This is done while still inside the transaction, so that a change of
+  monitor only marks the layer to be recalculated at the commit, instead of
+  restacking right away */
+static void client_commit_configure(ObClient *self)
+{
+    if (self->pending.configure) {
+        self->pending.configure = FALSE;
+        client_configure_apply(self,
+                               &self->pending.oldframe,
+                               &self->pending.oldclient,
+                               self->pending.fdecor,
+                               self->pending.fhorz,
+                               self->pending.fvert,
+                               self->pending.user,
+                               self->pending.final,
+                               self->pending.force_reply);
+    }
+}
+
+void client_commit(ObClient *self)
+{
+    g_assert(self->transaction > 0);
+
+    if (self->transaction > 1) {
+        --self->transaction;
+        return;
+    }
+
+    client_commit_configure(self);
+
+    self->transaction = 0;
+
+    if (self->pending.frame) {
+        self->pending.frame = FALSE;
+        frame_adjust_area(self->frame, FALSE, TRUE, FALSE);
+    }
+    if (self->pending.state) {
+        self->pending.state = FALSE;
+        client_change_state(self);
+    }
+    if (self->pending.layer) {
+        self->pending.layer = FALSE;
+        client_calc_layer(self);
+    }
+}
+
 void client_fullscreen(ObClient *self, gboolean fs)
 {
     gint x, y, w, h;
@@ -3324,6 +3626,8 @@ void client_fullscreen(ObClient *self, gboolean fs)
     if (!(self->functions & OB_CLIENT_FUNC_FULLSCREEN) || /* can't */
         self->fullscreen == fs) return;                   /* already done */
 
+    client_begin(self);
+
     self->fullscreen = fs;
     client_change_state(self); /* change the state hints on the client */
 
@@ -3387,6 +3691,8 @@ void client_fullscreen(ObClient *self, gboolean fs)
        considered "fullscreen" and it affects their layer */
     client_calc_layer(self);
 
+    client_commit(self);
+
     if (fs) {
         /* try focus us when we go into fullscreen mode */
         client_focus(self);
@@ -3433,6 +3739,7 @@ static void client_iconify_recursive(ObClient *self,
     }
 
     if (changed) {
+        client_edges_changed(self);
         client_change_state(self);
         if (config_animate_iconify && !hide_animation)
             frame_begin_iconify_animation(self->frame, iconic);
@@ -3477,6 +3784,8 @@ void client_maximize(ObClient *self, gboolean max, gint dir)
         if (dir == 2 && !self->max_vert) return;
     }
 
+    client_begin(self);
+
     /* these will help configure_full figure out which screen to fill with
        the window */
     x = self->area.x;
@@ -3530,6 +3839,8 @@ void client_maximize(ObClient *self, gboolean max, gint dir)
 
     client_setup_decor_and_functions(self, FALSE);
     client_move_resize(self, x, y, w, h);
+
+    client_commit(self);
 }
 
 void client_shade(ObClient *self, gboolean shade)
@@ -3541,8 +3852,12 @@ void client_shade(ObClient *self, gboolean shade)
     self->shaded = shade;
     client_change_state(self);
     client_change_wm_state(self); /* the window is being hidden/shown */
-    /* resize the frame to just the titlebar */
-    frame_adjust_area(self->frame, FALSE, TRUE, FALSE);
+    /* resize the frame to just the titlebar, after any move/resize that is
+       waiting to be sent */
+    if (self->transaction)
+        self->pending.frame = TRUE;
+    else
+        frame_adjust_area(self->frame, FALSE, TRUE, FALSE);
 }
 
 static void client_ping_event(ObClient *self, gboolean dead)
@@ -3748,7 +4063,11 @@ static void client_set_desktop_recursive(ObClient *self,
 
         old = self->desktop;
         self->desktop = target;
+        client_edges_changed(self);
         OBT_PROP_SET32(self->window, NET_WM_DESKTOP, CARDINAL, target);
+        /* move it into the container for the new desktop */
+        if (frame_adjust_parent(self->frame))
+            stacking_refresh(CLIENT_AS_WINDOW(self));
         /* the frame can display the current desktop state */
         frame_adjust_state(self->frame);
         /* 'move' the window to the new desktop */
@@ -3941,6 +4260,10 @@ void client_set_state(ObClient *self, Atom action, glong data1, glong data2)
         }
     }
 
+    /* gather the geometry, decoration and layer changes, so the window is
+       only moved and restacked once for all of them */
+    client_begin(self);
+
     if (max_horz != self->max_horz || max_vert != self->max_vert) {
         if (max_horz != self->max_horz && max_vert != self->max_vert) {
             /* toggling both */
@@ -3962,8 +4285,6 @@ void client_set_state(ObClient *self, Atom action, glong data1, glong data2)
        can shade or not */
     if (fullscreen != self->fullscreen)
         client_fullscreen(self, fullscreen);
-    if (shaded != self->shaded)
-        client_shade(self, shaded);
     if (undecorated != self->undecorated)
         client_set_undecorated(self, undecorated);
     if (above != self->above || below != self->below) {
@@ -3972,6 +4293,13 @@ void client_set_state(ObClient *self, Atom action, glong data1, glong data2)
         client_calc_layer(self);
     }
 
+    client_commit(self);
+
+    /* shading adjusts the frame right away, so do it once the frame has
+       its new size */
+    if (shaded != self->shaded)
+        client_shade(self, shaded);
+
     if (modal != self->modal) {
         self->modal = modal;
         /* when a window changes modality, then its stacking order with its
@@ -4022,6 +4350,11 @@ gboolean client_focus(ObClient *self)
 {
     if (!client_validate(self)) return FALSE;
 
+    /* focusing can depend on where the window is, so send the move/resize
+       that is waiting first */
+    if (self->transaction)
+        client_commit_configure(self);
+
     /* we might not focus this window, so if we have modal children which would
        be focused instead, bring them to this desktop */
     client_bring_modal_windows(self);
@@ -4173,6 +4506,7 @@ RrImage* client_icon(ObClient *self)
 
 void client_set_layer(ObClient *self, gint layer)
 {
+    client_begin(self);
     if (layer < 0) {
         self->below = TRUE;
         self->above = FALSE;
@@ -4184,6 +4518,7 @@ void client_set_layer(ObClient *self, gint layer)
     }
     client_calc_layer(self);
     client_change_state(self); /* reflect this in the state hints */
+    client_commit(self);
 }
 
 void client_set_undecorated(ObClient *self, gboolean undecorated)
@@ -4193,9 +4528,11 @@ void client_set_undecorated(ObClient *self, gboolean undecorated)
            it redecorate */
         (self->functions & OB_CLIENT_FUNC_UNDECORATE || !undecorated))
     {
+        client_begin(self);
         self->undecorated = undecorated;
         client_setup_decor_and_functions(self, TRUE);
         client_change_state(self); /* reflect this in the state hints */
+        client_commit(self);
     }
 }
 
@@ -4296,109 +4633,76 @@ ObClient *client_search_transient(ObClient *self, ObClient *search)
     return NULL;
 }
 
-static void detect_edge(Rect area, ObDirection dir,
-                        gint my_head, gint my_size,
-                        gint my_edge_start, gint my_edge_size,
-                        gint *dest, gboolean *near_edge)
+void client_edges_changed(ObClient *self)
 {
-    gint edge_start, edge_size, head, tail;
-    gboolean skip_head = FALSE, skip_tail = FALSE;
-
-    switch (dir) {
-        case OB_DIRECTION_NORTH:
-        case OB_DIRECTION_SOUTH:
-            edge_start = area.x;
-            edge_size = area.width;
-            break;
-        case OB_DIRECTION_EAST:
-        case OB_DIRECTION_WEST:
-            edge_start = area.y;
-            edge_size = area.height;
-            break;
-        default:
-            g_assert_not_reached();
+    if (!self->edge_dirty) {
+        self->edge_dirty = TRUE;
+        client_edges_dirty = g_slist_prepend(client_edges_dirty, self);
     }
+}
 
-    /* do we collide with this window? */
-    if (!RANGES_INTERSECT(my_edge_start, my_edge_size,
-                edge_start, edge_size))
-        return;
-
-    switch (dir) {
-        case OB_DIRECTION_NORTH:
-            head = RECT_BOTTOM(area);
-            tail = RECT_TOP(area);
-            break;
-        case OB_DIRECTION_SOUTH:
-            head = RECT_TOP(area);
-            tail = RECT_BOTTOM(area);
-            break;
-        case OB_DIRECTION_WEST:
-            head = RECT_RIGHT(area);
-            tail = RECT_LEFT(area);
-            break;
-        case OB_DIRECTION_EAST:
-            head = RECT_LEFT(area);
-            tail = RECT_RIGHT(area);
-            break;
-        default:
-            g_assert_not_reached();
+static void client_edges_forget(ObClient *self)
+{
+    if (self->edge_index) {
+        edge_index_remove(self->edge_index, self);
+        self->edge_index = NULL;
     }
-    switch (dir) {
-        case OB_DIRECTION_NORTH:
-        case OB_DIRECTION_WEST:
-            /* check if our window is past the head of this window */
-            if (my_head <= head + 1)
-                skip_head = TRUE;
-            /* check if our window's tail is past the tail of this window */
-            if (my_head + my_size - 1 <= tail)
-                skip_tail = TRUE;
-            /* check if the head of this window is closer than the previously
-               chosen edge (take into account that the previously chosen
-               edge might have been a tail, not a head) */
-            if (head + (*near_edge ? 0 : my_size) <= *dest)
-                skip_head = TRUE;
-            /* check if the tail of this window is closer than the previously
-               chosen edge (take into account that the previously chosen
-               edge might have been a head, not a tail) */
-            if (tail - (!*near_edge ? 0 : my_size) <= *dest)
-                skip_tail = TRUE;
-            break;
-        case OB_DIRECTION_SOUTH:
-        case OB_DIRECTION_EAST:
-            /* check if our window is past the head of this window */
-            if (my_head >= head - 1)
-                skip_head = TRUE;
-            /* check if our window's tail is past the tail of this window */
-            if (my_head - my_size + 1 >= tail)
-                skip_tail = TRUE;
-            /* check if the head of this window is closer than the previously
-               chosen edge (take into account that the previously chosen
-               edge might have been a tail, not a head) */
-            if (head - (*near_edge ? 0 : my_size) >= *dest)
-                skip_head = TRUE;
-            /* check if the tail of this window is closer than the previously
-               chosen edge (take into account that the previously chosen
-               edge might have been a head, not a tail) */
-            if (tail + (!*near_edge ? 0 : my_size) >= *dest)
-                skip_tail = TRUE;
-            break;
-        default:
-            g_assert_not_reached();
+    if (self->edge_dirty) {
+        client_edges_dirty = g_slist_remove(client_edges_dirty, self);
+        self->edge_dirty = FALSE;
     }
+}
 
-    ob_debug("my head %d size %d", my_head, my_size);
-    ob_debug("head %d tail %d dest %d", head, tail, *dest);
-    if (!skip_head) {
-        ob_debug("using near edge %d", head);
-        *dest = head;
-        *near_edge = TRUE;
-    }
-    else if (!skip_tail) {
-        ob_debug("using far edge %d", tail);
-        *dest = tail;
-        *near_edge = FALSE;
+static ObEdgeIndex* client_edges_for(guint desktop)
+{
+    if (desktop == DESKTOP_ALL)
+        return client_edges_all;
+
+    if (desktop >= client_edges->len)
+        g_ptr_array_set_size(client_edges, desktop + 1);
+    if (!g_ptr_array_index(client_edges, desktop))
+        g_ptr_array_index(client_edges, desktop) = edge_index_new();
+    return g_ptr_array_index(client_edges, desktop);
+}
+
+/*! Move the clients which have changed to where they are now in the edge
+  indexes.  Iconic clients are left out, as nothing searches for them. */
+static void client_edges_update(void)
+{
+    GSList *it;
+
+    for (it = client_edges_dirty; it; it = g_slist_next(it)) {
+        ObClient *c = it->data;
+
+        if (c->edge_index) {
+            edge_index_remove(c->edge_index, c);
+            c->edge_index = NULL;
+        }
+        if (c->edge_rank && c->frame && !c->iconic) {
+            c->edge_index = client_edges_for(c->desktop);
+            edge_index_add(c->edge_index, c, c->edge_rank, &c->frame->area);
+        }
+        c->edge_dirty = FALSE;
     }
+    g_slist_free(client_edges_dirty);
+    client_edges_dirty = NULL;
+}
+
+/*! Get the edge indexes for the clients which are visible on the desktop,
+  or on either of the desktops */
+static guint client_edges_get(guint desktop1, guint desktop2,
+                              ObEdgeIndex **indexes)
+{
+    guint n = 0;
+
+    client_edges_update();
+
+    indexes[n++] = client_edges_all;
+    if (desktop1 != DESKTOP_ALL)
+        indexes[n++] = client_edges_for(desktop1);
+    if (desktop2 != DESKTOP_ALL && desktop2 != desktop1)
+        indexes[n++] = client_edges_for(desktop2);
+    return n;
 }
 
 void client_find_edge_directional(ObClient *self, ObDirection dir,
@@ -4406,11 +4710,11 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
                                   gint my_edge_start, gint my_edge_size,
                                   gint *dest, gboolean *near_edge)
 {
-    GList *it;
+    ObEdgeIndex *indexes[3];
     Rect *a;
     Rect dock_area;
     gint edge;
-    guint i;
+    guint i, n;
 
     a = screen_area(self->desktop, SCREEN_AREA_ALL_MONITORS,
                     &self->frame->area);
@@ -4438,36 +4742,37 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
     /* search for edges of monitors */
     for (i = 0; i < screen_num_monitors; ++i) {
         Rect *area = screen_area(self->desktop, i, NULL);
-        detect_edge(*area, dir, my_head, my_size, my_edge_start,
-                    my_edge_size, dest, near_edge);
+        edge_index_detect(area, dir, my_head, my_size, my_edge_start,
+                          my_edge_size, dest, near_edge);
         g_slice_free(Rect, area);
     }
 
-    /* search for edges of clients */
-    for (it = client_list; it; it = g_list_next(it)) {
-        ObClient *cur = it->data;
-
-        /* skip windows to not bump into */
-        if (cur == self)
-            continue;
-        if (cur->iconic)
-            continue;
-        if (self->desktop != cur->desktop && cur->desktop != DESKTOP_ALL &&
-            cur->desktop != screen_desktop)
-            continue;
-
-        ob_debug("trying window %s", cur->title);
+    /* search for edges of the clients on our desktop or the visible one,
+       skipping ourself */
+    n = client_edges_get(self->desktop, screen_desktop, indexes);
+    edge_index_find_edge(indexes, n, self, dir, my_head, my_size,
+                         my_edge_start, my_edge_size, dest, near_edge);
+    ob_debug("edge %d is the %s edge for window %s", *dest,
+             *near_edge ? "near" : "far", self->title);
 
-        detect_edge(cur->frame->area, dir, my_head, my_size, my_edge_start,
-                    my_edge_size, dest, near_edge);
-    }
     dock_get_area(&dock_area);
-    detect_edge(dock_area, dir, my_head, my_size, my_edge_start,
-                my_edge_size, dest, near_edge);
+    edge_index_detect(&dock_area, dir, my_head, my_size, my_edge_start,
+                      my_edge_size, dest, near_edge);
 
     g_slice_free(Rect, a);
 }
 
+ObClient* client_find_directional(ObClient *self, ObDirection dir,
+                                  ObClientValidFunc valid)
+{
+    ObEdgeIndex *indexes[3];
+    guint n;
+
+    n = client_edges_get(screen_desktop, screen_desktop, indexes);
+    return edge_index_find_directional(indexes, n, self, &self->frame->area,
+                                       dir, (ObEdgeIndexValidFunc)valid);
+}
+
 void client_find_move_directional(ObClient *self, ObDirection dir,
                                   gint *x, gint *y)
 {
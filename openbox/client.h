@@ -38,6 +38,7 @@ struct _ObFrame;
 struct _ObGroup;
 struct _ObSessionState;
 struct _ObPrompt;
+struct _ObClientIcon;
 
 typedef struct _ObClient      ObClient;
 
@@ -311,11 +312,53 @@ struct _ObClient
     /* The window's icon, in a variety of shapes and sizes */
     RrImage *icon_set;
 
+    /*! The icon pixmap and mask in the window's WM_HINTS, or None */
+    Pixmap wmhints_icon;
+    Pixmap wmhints_mask;
+    /*! The icon imported from wmhints_icon, it is shared with any other
+      windows which use the same pixmaps */
+    struct _ObClientIcon *legacy_icon;
+
     /*! Where the window should iconify to/from */
     Rect icon_geometry;
 
     /*! A boolean used for algorithms which need to mark clients as visited */
     gboolean visited;
+
+    /*! How deep the client is nested in client_begin() calls.  While this is
+      non-zero, changes are gathered up in pending and applied all together
+      by the outermost client_commit(). */
+    guint transaction;
+    struct {
+        /*! A move/resize is waiting to be sent to the X server */
+        gboolean configure;
+        /*! The frame and client areas from before the first move/resize */
+        Rect oldframe;
+        Rect oldclient;
+        /*! The frame's decorations and maximized state from before the first
+          move/resize */
+        guint fdecor;
+        gboolean fhorz;
+        gboolean fvert;
+        gboolean user;
+        gboolean final;
+        gboolean force_reply;
+        /*! The _NET_WM_STATE hint needs to be updated */
+        gboolean state;
+        /*! The client's stacking layer needs to be recalculated */
+        gboolean layer;
+        /*! The frame needs to be resized for the client's shaded state */
+        gboolean frame;
+    } pending;
+
+    /*! Where the client comes in the edge indexes when its edges are as
+      close as another's, which follows the client_list order */
+    guint edge_rank;
+    /*! The edge index that the client's frame is in, NULL if it is not in
+      one */
+    struct _ObEdgeIndex *edge_index;
+    /*! The client needs to be moved in the edge indexes */
+    gboolean edge_dirty;
 };
 
 extern GList      *client_list;
@@ -324,6 +367,7 @@ void client_startup(gboolean reconfig);
 void client_shutdown(gboolean reconfig);
 
 typedef void (*ObClientCallback)(ObClient *client, gpointer data);
+typedef gboolean (*ObClientValidFunc)(ObClient *client);
 
 /* Callback functions */
 
@@ -458,6 +502,21 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
 void client_configure(ObClient *self, gint x, gint y, gint w, gint h,
                       gboolean user, gboolean final, gboolean force_reply);
 
+/*! Start gathering changes to the client into a single update.
+  Until the matching client_commit(), client_configure() only updates the
+  client's area, and the _NET_WM_STATE hint and the stacking layer are left
+  for the commit.  Focusing the client sends the move/resize gathered so far
+  first.  Calls may be nested, and only the outermost commit applies the
+  changes.
+*/
+void client_begin(ObClient *self);
+
+/*! Apply the changes gathered since client_begin().  The frame is moved and
+  resized once, at most one synthetic ConfigureNotify is sent, and the state
+  hint and stacking layer are each updated once.
+*/
+void client_commit(ObClient *self);
+
 /*! Finds coordinates to keep a client on the screen.
   @param self The client
   @param x The x coord of the client, may be changed.
@@ -490,6 +549,17 @@ void client_find_edge_directional(ObClient *self, ObDirection dir,
 void client_find_move_directional(ObClient *self, ObDirection dir,
                                   gint *x, gint *y);
 
+/*! Find the client which is the best match in the direction from the
+  centre of this one, from the ones on the current desktop for which valid
+  returns TRUE.  Returns self if there are none. */
+ObClient* client_find_directional(ObClient *self, ObDirection dir,
+                                  ObClientValidFunc valid);
+
+/*! Call this when the client's frame has moved or been resized, or it has
+  changed desktops or been iconified, to update the edge indexes before
+  they are searched next. */
+void client_edges_changed(ObClient *self);
+
 typedef enum {
     CLIENT_RESIZE_GROW,
     CLIENT_RESIZE_GROW_IF_NOT_ON_EDGE,
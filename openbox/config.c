@@ -64,6 +64,7 @@ guint   config_desktops_num;
 GSList *config_desktops_names;
 guint   config_screen_firstdesk;
 guint   config_desktop_popup_time;
+gboolean config_desktop_containers;
 
 gboolean         config_resize_redraw;
 gint             config_resize_popup_show;
@@ -812,6 +813,8 @@ static void parse_desktops(xmlNodePtr node, gpointer d)
     }
     if ((n = obt_xml_find_node(node, "popupTime")))
         config_desktop_popup_time = obt_xml_node_int(n);
+    if ((n = obt_xml_find_node(node, "containers")))
+        config_desktop_containers = obt_xml_node_bool(n);
 }
 
 static void parse_resize(xmlNodePtr node, gpointer d)
@@ -1112,6 +1115,7 @@ void config_startup(ObtXmlInst *i)
     config_screen_firstdesk = 1;
     config_desktops_names = NULL;
     config_desktop_popup_time = 875;
+    config_desktop_containers = FALSE;
 
     obt_xml_register(i, "desktops", parse_desktops, NULL);
 
@@ -174,6 +174,10 @@ extern guint config_screen_firstdesk;
 extern GSList *config_desktops_names;
 /*! Amount of time to show the desktop switch dialog */
 extern guint config_desktop_popup_time;
+/*! Keep the windows for each desktop inside a container window, so that
+  switching desktops only maps and unmaps the containers.  Windows on all
+  desktops are moved into the current desktop's container. */
+extern gboolean config_desktop_containers;
 
 /*! The keycode of the key combo which resets the keybaord chains */
 extern guint config_keyboard_reset_keycode;
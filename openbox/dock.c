@@ -52,9 +52,6 @@ static void dock_app_grab_button(ObDockApp *app, gboolean grab)
     }
 }
 
-static guint window_hash(Window *w) { return *w; }
-static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
-
 void dock_startup(gboolean reconfig)
 {
     XSetWindowAttributes attrib;
@@ -87,13 +84,12 @@ void dock_startup(gboolean reconfig)
 
     dock->hidden = TRUE;
 
-    dock->dock_map = g_hash_table_new((GHashFunc)window_hash,
-                                      (GEqualFunc)window_comp);
-
     attrib.event_mask = DOCK_EVENT_MASK;
     attrib.override_redirect = True;
     attrib.do_not_propagate_mask = DOCK_NOPROPAGATEMASK;
-    dock->frame = XCreateWindow(obt_display, obt_root(ob_screen),
+    /* the dock is shown on every desktop */
+    dock->parent = screen_container(DESKTOP_ALL);
+    dock->frame = XCreateWindow(obt_display, dock->parent,
                                 0, 0, 1, 1, 0,
                                 RrDepth(ob_rr_inst), InputOutput,
                                 RrVisual(ob_rr_inst),
@@ -125,8 +121,6 @@ void dock_shutdown(gboolean reconfig)
         return;
     }
 
-    g_hash_table_destroy(dock->dock_map);
-
     XDestroyWindow(obt_display, dock->frame);
     RrAppearanceFree(dock->a_frame);
     window_remove(dock->frame);
@@ -165,7 +159,7 @@ void dock_manage(Window icon_win, Window name_win)
     }
 
     dock->dock_apps = g_list_append(dock->dock_apps, app);
-    g_hash_table_insert(dock->dock_map, &app->icon_win, app);
+    window_add_dockapp(&app->icon_win, app);
     dock_configure();
 
     XReparentWindow(obt_display, app->icon_win, dock->frame, app->x, app->y);
@@ -221,7 +215,7 @@ void dock_unmanage(ObDockApp *app, gboolean reparent)
     }
 
     dock->dock_apps = g_list_remove(dock->dock_apps, app);
-    g_hash_table_remove(dock->dock_map, &app->icon_win);
+    window_remove(app->icon_win);
     dock_configure();
 
     ob_debug("Unmanaged Dock App: 0x%lx (%s)", app->icon_win, app->class);
@@ -671,6 +665,20 @@ void dock_hide(gboolean hide)
     }
 }
 
+gboolean dock_adjust_parent(void)
+{
+    Window parent;
+
+    /* the dock is shown on every desktop */
+    if (!dock || (parent = screen_container(DESKTOP_ALL)) == dock->parent)
+        return FALSE;
+
+    XReparentWindow(obt_display, dock->frame, parent,
+                    dock->area.x, dock->area.y);
+    dock->parent = parent;
+    return TRUE;
+}
+
 void dock_get_area(Rect *a)
 {
     RECT_SET(*a, dock->area.x, dock->area.y,
@@ -689,5 +697,8 @@ void dock_lower_dock(void)
 
 ObDockApp* dock_find_dockapp(Window xwin)
 {
-    return g_hash_table_lookup(dock->dock_map, &xwin);
+    ObWindowClass type;
+    ObDockApp *app = window_find_any(xwin, &type);
+
+    return (app && type == OB_WINDOW_CLASS_DOCKAPP) ? app : NULL;
 }
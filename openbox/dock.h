@@ -36,6 +36,9 @@ struct _ObDock
     ObWindow obwin;
 
     Window frame;
+    /*! The window that the dock is a child of, the root window or the
+      current desktop's container */
+    Window parent;
     RrAppearance *a_frame;
 
     /* actual position (when not auto-hidden) */
@@ -44,7 +47,6 @@ struct _ObDock
     gboolean hidden;
 
     GList *dock_apps;
-    GHashTable *dock_map;
 };
 
 struct _ObDockApp {
@@ -69,6 +71,9 @@ void dock_shutdown(gboolean reconfig);
 
 void dock_configure(void);
 void dock_hide(gboolean hide);
+/*! Move the dock into the current desktop's container.  Returns TRUE if it
+  was moved, in which case the stacking order needs to be refreshed. */
+gboolean dock_adjust_parent(void);
 
 void dock_manage(Window icon_win, Window name_win);
 
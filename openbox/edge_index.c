@@ -0,0 +1,478 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   edge_index.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "edge_index.h"
+
+/*! The things that each rectangle is sorted by */
+enum {
+    KEY_LEFT,
+    KEY_RIGHT,
+    KEY_TOP,
+    KEY_BOTTOM,
+    KEY_CENTRE_X,
+    KEY_CENTRE_Y,
+    KEY_CENTRE_SUM,  /* x + y, for the diagonals */
+    KEY_CENTRE_DIFF, /* y - x, for the diagonals */
+    NUM_KEYS
+};
+
+typedef struct _ObEdgeRect ObEdgeRect;
+typedef struct _ObEdgeKey ObEdgeKey;
+
+struct _ObEdgeRect {
+    gpointer owner;
+    guint rank;
+    Rect area;
+};
+
+struct _ObEdgeKey {
+    gint pos;
+    ObEdgeRect *r;
+};
+
+struct _ObEdgeIndex {
+    /* ObEdgeKeys sorted by their pos, then by the rank of their rect */
+    GArray *keys[NUM_KEYS];
+    /* the ObEdgeRect for each owner */
+    GHashTable *rects;
+};
+
+/*! The best edge found so far by edge_index_find_edge */
+typedef struct _ObEdgeBest {
+    gint k;       /* the edge's position, with my_size taken into account
+                     for the edges behind the ones facing us */
+    guint rank;   /* twice the rect's rank, plus one for a far edge */
+    gint dest;
+    gboolean near_edge;
+} ObEdgeBest;
+
+static gint key_pos(const Rect *a, gint key)
+{
+    switch (key) {
+    case KEY_LEFT:        return RECT_LEFT(*a);
+    case KEY_RIGHT:       return RECT_RIGHT(*a);
+    case KEY_TOP:         return RECT_TOP(*a);
+    case KEY_BOTTOM:      return RECT_BOTTOM(*a);
+    case KEY_CENTRE_X:    return a->x + a->width / 2;
+    case KEY_CENTRE_Y:    return a->y + a->height / 2;
+    case KEY_CENTRE_SUM:  return a->x + a->width / 2 + a->y + a->height / 2;
+    case KEY_CENTRE_DIFF: return a->y + a->height / 2 - a->x - a->width / 2;
+    }
+    g_assert_not_reached();
+    return 0;
+}
+
+/*! The first place in the array with a key which is not before pos and
+  rank.  Ranks start at 1, so a rank of 0 finds the first one at pos. */
+static guint lower_bound(GArray *a, gint pos, guint rank)
+{
+    guint lo = 0, hi = a->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        const ObEdgeKey *k = &g_array_index(a, ObEdgeKey, mid);
+
+        if (k->pos < pos || (k->pos == pos && k->r->rank < rank))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+ObEdgeIndex* edge_index_new(void)
+{
+    ObEdgeIndex *e;
+    gint i;
+
+    e = g_slice_new(ObEdgeIndex);
+    for (i = 0; i < NUM_KEYS; ++i)
+        e->keys[i] = g_array_new(FALSE, FALSE, sizeof(ObEdgeKey));
+    e->rects = g_hash_table_new(g_direct_hash, g_direct_equal);
+    return e;
+}
+
+static void free_rect(gpointer key, gpointer value, gpointer data)
+{
+    g_slice_free(ObEdgeRect, value);
+}
+
+void edge_index_free(ObEdgeIndex *e)
+{
+    gint i;
+
+    if (e) {
+        for (i = 0; i < NUM_KEYS; ++i)
+            g_array_free(e->keys[i], TRUE);
+        g_hash_table_foreach(e->rects, free_rect, NULL);
+        g_hash_table_destroy(e->rects);
+        g_slice_free(ObEdgeIndex, e);
+    }
+}
+
+void edge_index_add(ObEdgeIndex *e, gpointer owner, guint rank,
+                    const Rect *area)
+{
+    ObEdgeRect *r;
+    gint i;
+
+    g_assert(rank > 0);
+    g_assert(!g_hash_table_lookup(e->rects, owner));
+
+    r = g_slice_new(ObEdgeRect);
+    r->owner = owner;
+    r->rank = rank;
+    r->area = *area;
+    g_hash_table_insert(e->rects, owner, r);
+
+    for (i = 0; i < NUM_KEYS; ++i) {
+        ObEdgeKey k;
+
+        k.pos = key_pos(area, i);
+        k.r = r;
+        g_array_insert_val(e->keys[i], lower_bound(e->keys[i], k.pos, rank),
+                           k);
+    }
+}
+
+void edge_index_remove(ObEdgeIndex *e, gpointer owner)
+{
+    ObEdgeRect *r;
+    gint i;
+
+    if (!(r = g_hash_table_lookup(e->rects, owner))) return;
+
+    for (i = 0; i < NUM_KEYS; ++i) {
+        guint at = lower_bound(e->keys[i], key_pos(&r->area, i), r->rank);
+
+        g_assert(g_array_index(e->keys[i], ObEdgeKey, at).r == r);
+        g_array_remove_index(e->keys[i], at);
+    }
+
+    g_hash_table_remove(e->rects, owner);
+    g_slice_free(ObEdgeRect, r);
+}
+
+void edge_index_detect(const Rect *area, ObDirection dir,
+                       gint my_head, gint my_size,
+                       gint my_edge_start, gint my_edge_size,
+                       gint *dest, gboolean *near_edge)
+{
+    gint edge_start, edge_size, head, tail;
+    gboolean skip_head = FALSE, skip_tail = FALSE;
+
+    switch (dir) {
+        case OB_DIRECTION_NORTH:
+        case OB_DIRECTION_SOUTH:
+            edge_start = area->x;
+            edge_size = area->width;
+            break;
+        case OB_DIRECTION_EAST:
+        case OB_DIRECTION_WEST:
+            edge_start = area->y;
+            edge_size = area->height;
+            break;
+        default:
+            g_assert_not_reached();
+    }
+
+    /* do we collide with this window? */
+    if (!RANGES_INTERSECT(my_edge_start, my_edge_size,
+                edge_start, edge_size))
+        return;
+
+    switch (dir) {
+        case OB_DIRECTION_NORTH:
+            head = RECT_BOTTOM(*area);
+            tail = RECT_TOP(*area);
+            break;
+        case OB_DIRECTION_SOUTH:
+            head = RECT_TOP(*area);
+            tail = RECT_BOTTOM(*area);
+            break;
+        case OB_DIRECTION_WEST:
+            head = RECT_RIGHT(*area);
+            tail = RECT_LEFT(*area);
+            break;
+        case OB_DIRECTION_EAST:
+            head = RECT_LEFT(*area);
+            tail = RECT_RIGHT(*area);
+            break;
+        default:
+            g_assert_not_reached();
+    }
+    switch (dir) {
+        case OB_DIRECTION_NORTH:
+        case OB_DIRECTION_WEST:
+            /* check if our window is past the head of this window */
+            if (my_head <= head + 1)
+                skip_head = TRUE;
+            /* check if our window's tail is past the tail of this window */
+            if (my_head + my_size - 1 <= tail)
+                skip_tail = TRUE;
+            /* check if the head of this window is closer than the previously
+               chosen edge (take into account that the previously chosen
+               edge might have been a tail, not a head) */
+            if (head + (*near_edge ? 0 : my_size) <= *dest)
+                skip_head = TRUE;
+            /* check if the tail of this window is closer than the previously
+               chosen edge (take into account that the previously chosen
+               edge might have been a head, not a tail) */
+            if (tail - (!*near_edge ? 0 : my_size) <= *dest)
+                skip_tail = TRUE;
+            break;
+        case OB_DIRECTION_SOUTH:
+        case OB_DIRECTION_EAST:
+            /* check if our window is past the head of this window */
+            if (my_head >= head - 1)
+                skip_head = TRUE;
+            /* check if our window's tail is past the tail of this window */
+            if (my_head - my_size + 1 >= tail)
+                skip_tail = TRUE;
+            /* check if the head of this window is closer than the previously
+               chosen edge (take into account that the previously chosen
+               edge might have been a tail, not a head) */
+            if (head - (*near_edge ? 0 : my_size) >= *dest)
+                skip_head = TRUE;
+            /* check if the tail of this window is closer than the previously
+               chosen edge (take into account that the previously chosen
+               edge might have been a head, not a tail) */
+            if (tail + (!*near_edge ? 0 : my_size) >= *dest)
+                skip_tail = TRUE;
+            break;
+        default:
+            g_assert_not_reached();
+    }
+
+    if (!skip_head) {
+        *dest = head;
+        *near_edge = TRUE;
+    }
+    else if (!skip_tail) {
+        *dest = tail;
+        *near_edge = FALSE;
+    }
+}
+
+/*! Look through one sorted list of edges for a better one than best.
+
+  edge_index_detect() takes an edge when it is closer than the last one it
+  took, once the far edges are moved by my_size to compare them with the
+  near ones.  So going through the rects in order of their rank finds the
+  closest one, and the lowest ranked one when some are as close as each
+  other.  The list is sorted, so this starts at the closest edge that our
+  window is not past, and stops once the edges are further away than the
+  best one.
+*/
+static void find_edge_in(GArray *a, gboolean forward, gboolean near_edge,
+                         gint limit, gint shift, gpointer skip,
+                         gboolean vertical, gint my_edge_start,
+                         gint my_edge_size, ObEdgeBest *best)
+{
+    gint i, step;
+
+    if (forward) {
+        /* the edges at or after the limit, closest first */
+        i = lower_bound(a, limit, 0);
+        step = 1;
+    }
+    else {
+        /* the edges at or before the limit, closest first */
+        i = (gint)lower_bound(a, limit + 1, 0) - 1;
+        step = -1;
+    }
+
+    for (; i >= 0 && i < (gint)a->len; i += step) {
+        const ObEdgeKey *key = &g_array_index(a, ObEdgeKey, i);
+        const ObEdgeRect *r = key->r;
+        gint k = key->pos + shift;
+        guint rank = r->rank * 2 + (near_edge ? 0 : 1);
+
+        /* nothing from here on can be as close */
+        if (forward ? k > best->k : k < best->k) break;
+
+        if (r->owner == skip) continue;
+        if (k == best->k && rank > best->rank) continue;
+        if (vertical ?
+            !RANGES_INTERSECT(my_edge_start, my_edge_size,
+                              r->area.x, r->area.width) :
+            !RANGES_INTERSECT(my_edge_start, my_edge_size,
+                              r->area.y, r->area.height))
+            continue;
+
+        best->k = k;
+        best->rank = rank;
+        best->dest = key->pos;
+        best->near_edge = near_edge;
+    }
+}
+
+void edge_index_find_edge(ObEdgeIndex **indexes, guint n, gpointer skip,
+                          ObDirection dir, gint my_head, gint my_size,
+                          gint my_edge_start, gint my_edge_size,
+                          gint *dest, gboolean *near_edge)
+{
+    ObEdgeBest best;
+    gint head_key, tail_key;
+    gboolean forward, vertical;
+    guint i;
+
+    switch (dir) {
+    case OB_DIRECTION_NORTH:
+        head_key = KEY_BOTTOM;
+        tail_key = KEY_TOP;
+        break;
+    case OB_DIRECTION_SOUTH:
+        head_key = KEY_TOP;
+        tail_key = KEY_BOTTOM;
+        break;
+    case OB_DIRECTION_WEST:
+        head_key = KEY_RIGHT;
+        tail_key = KEY_LEFT;
+        break;
+    case OB_DIRECTION_EAST:
+        head_key = KEY_LEFT;
+        tail_key = KEY_RIGHT;
+        break;
+    default:
+        g_assert_not_reached();
+    }
+    forward = dir == OB_DIRECTION_SOUTH || dir == OB_DIRECTION_EAST;
+    vertical = dir == OB_DIRECTION_NORTH || dir == OB_DIRECTION_SOUTH;
+
+    /* start with whatever was found before, which wins any ties */
+    best.dest = *dest;
+    best.near_edge = *near_edge;
+    best.rank = 0;
+    if (forward)
+        best.k = *dest + (*near_edge ? 0 : my_size);
+    else
+        best.k = *dest - (*near_edge ? 0 : my_size);
+
+    for (i = 0; i < n; ++i) {
+        if (forward) {
+            find_edge_in(indexes[i]->keys[head_key], TRUE, TRUE,
+                         my_head + 2, 0, skip, vertical,
+                         my_edge_start, my_edge_size, &best);
+            find_edge_in(indexes[i]->keys[tail_key], TRUE, FALSE,
+                         my_head - my_size + 2, my_size, skip, vertical,
+                         my_edge_start, my_edge_size, &best);
+        }
+        else {
+            find_edge_in(indexes[i]->keys[head_key], FALSE, TRUE,
+                         my_head - 2, 0, skip, vertical,
+                         my_edge_start, my_edge_size, &best);
+            find_edge_in(indexes[i]->keys[tail_key], FALSE, FALSE,
+                         my_head + my_size - 2, -my_size, skip, vertical,
+                         my_edge_start, my_edge_size, &best);
+        }
+    }
+
+    *dest = best.dest;
+    *near_edge = best.near_edge;
+}
+
+/* this be mostly ripped from fvwm */
+gpointer edge_index_find_directional(ObEdgeIndex **indexes, guint n,
+                                     gpointer from, const Rect *area,
+                                     ObDirection dir,
+                                     ObEdgeIndexValidFunc valid)
+{
+    gint key, side_key, mine, my_side;
+    gint best_score = -1;
+    guint best_rank = 0;
+    gpointer best = from;
+    gboolean forward;
+    guint i;
+
+    /* the diagonals are measured with the centres turned 45 degrees */
+    switch (dir) {
+    case OB_DIRECTION_NORTH:
+    case OB_DIRECTION_SOUTH:
+        key = KEY_CENTRE_Y;
+        side_key = KEY_CENTRE_X;
+        break;
+    case OB_DIRECTION_EAST:
+    case OB_DIRECTION_WEST:
+        key = KEY_CENTRE_X;
+        side_key = KEY_CENTRE_Y;
+        break;
+    case OB_DIRECTION_NORTHEAST:
+    case OB_DIRECTION_SOUTHWEST:
+        key = KEY_CENTRE_DIFF;
+        side_key = KEY_CENTRE_SUM;
+        break;
+    case OB_DIRECTION_SOUTHEAST:
+    case OB_DIRECTION_NORTHWEST:
+        key = KEY_CENTRE_SUM;
+        side_key = KEY_CENTRE_DIFF;
+        break;
+    default:
+        g_assert_not_reached();
+    }
+    forward = (dir == OB_DIRECTION_SOUTH || dir == OB_DIRECTION_EAST ||
+               dir == OB_DIRECTION_SOUTHWEST || dir == OB_DIRECTION_SOUTHEAST);
+
+    mine = key_pos(area, key);
+    my_side = key_pos(area, side_key);
+
+    for (i = 0; i < n; ++i) {
+        GArray *a = indexes[i]->keys[key];
+        gint j, step;
+
+        /* only the ones in front of us, closest first */
+        if (forward) {
+            j = lower_bound(a, mine + 1, 0);
+            step = 1;
+        }
+        else {
+            j = (gint)lower_bound(a, mine, 0) - 1;
+            step = -1;
+        }
+
+        for (; j >= 0 && j < (gint)a->len; j += step) {
+            const ObEdgeKey *k = &g_array_index(a, ObEdgeKey, j);
+            const ObEdgeRect *r = k->r;
+            gint distance, offset, score;
+
+            distance = forward ? k->pos - mine : mine - k->pos;
+            /* the score is never less than the distance */
+            if (best_score >= 0 && distance > best_score) break;
+
+            if (r->owner == from || !valid(r->owner)) continue;
+
+            offset = ABS(key_pos(&r->area, side_key) - my_side);
+
+            /* The smaller the score the better.  Windows more than 45
+               degrees off the direction are heavily penalized and will only
+               be chosen if nothing else within a million pixels */
+            score = distance + offset;
+            if (offset > distance)
+                score += 1000000;
+
+            if (best_score == -1 || score < best_score ||
+                (score == best_score && r->rank < best_rank))
+            {
+                best = r->owner;
+                best_score = score;
+                best_rank = r->rank;
+            }
+        }
+    }
+
+    return best;
+}
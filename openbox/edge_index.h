@@ -0,0 +1,80 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   edge_index.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __edge_index_h
+#define __edge_index_h
+
+#include "geom.h"
+#include "misc.h"
+
+#include <glib.h>
+
+/*! A set of rectangles with each of their edges and centres kept sorted, so
+  that searching for the nearest one in a direction only looks at the ones
+  in that direction, starting with the closest.
+
+  Every rectangle has an owner and a rank.  When two rectangles would give
+  the same answer, the one with the lower rank wins, which is the one that
+  a search going through the owners in the order of their ranks would have
+  found first. */
+typedef struct _ObEdgeIndex ObEdgeIndex;
+
+typedef gboolean (*ObEdgeIndexValidFunc)(gpointer owner);
+
+ObEdgeIndex* edge_index_new(void);
+void edge_index_free(ObEdgeIndex *e);
+
+/*! Add the owner's rectangle to the index.  The rank must be more than 0,
+  and no two owners in the index can have the same rank. */
+void edge_index_add(ObEdgeIndex *e, gpointer owner, guint rank,
+                    const Rect *area);
+/*! Take the owner's rectangle out of the index, if it is in it */
+void edge_index_remove(ObEdgeIndex *e, gpointer owner);
+
+/*! Look at one rectangle for an edge to stop at when moving an edge of
+  size my_size at my_head in the direction, like when growing or moving a
+  window to the next edge.  The area has to overlap with my_edge_start and
+  my_edge_size across the direction for its edges to be used.  If one of
+  them is closer than *dest, then *dest is set to it, and *near_edge to if
+  it is the edge that faces my_head or the one behind it. */
+void edge_index_detect(const Rect *area, ObDirection dir,
+                       gint my_head, gint my_size,
+                       gint my_edge_start, gint my_edge_size,
+                       gint *dest, gboolean *near_edge);
+
+/*! Do the same as edge_index_detect() for all of the rectangles in the
+  indexes, except for the one owned by skip.  This gives the same answer as
+  calling edge_index_detect() for each of them in the order of their ranks,
+  after whatever set *dest and *near_edge first. */
+void edge_index_find_edge(ObEdgeIndex **indexes, guint n, gpointer skip,
+                          ObDirection dir, gint my_head, gint my_size,
+                          gint my_edge_start, gint my_edge_size,
+                          gint *dest, gboolean *near_edge);
+
+/*! Find the rectangle whose centre is the best match in the direction from
+  the centre of the area, from all of the indexes.  The ones straight ahead
+  are best, and the ones more than 45 degrees off to the side are only
+  chosen if nothing else is closer than a million pixels.  The owner of
+  the one found is returned, or from if there are none.  Only owners for
+  which the valid function returns TRUE are looked at, and from is
+  skipped. */
+gpointer edge_index_find_directional(ObEdgeIndex **indexes, guint n,
+                                     gpointer from, const Rect *area,
+                                     ObDirection dir,
+                                     ObEdgeIndexValidFunc valid);
+
+#endif
@@ -0,0 +1,220 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   edgetest.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Checks that searching the edge indexes gives the same answers as going
+   through every window in order, the way openbox used to.  The windows are
+   small and close together, so that lots of their edges are the same.
+*/
+
+#include "edge_index.h"
+
+#include <glib.h>
+#include <stdio.h>
+
+#define MAXWIN 40
+#define NUMINDEX 3
+
+static guint failures = 0;
+
+static Rect areas[MAXWIN];
+/*! Which index each window is in, -1 for none */
+static gint where[MAXWIN];
+static gboolean valid[MAXWIN];
+static ObEdgeIndex *indexes[NUMINDEX];
+
+/* the owners are the window's number plus one, and so are their ranks */
+#define OWNER(i) GINT_TO_POINTER((i) + 1)
+
+static gboolean is_valid(gpointer owner)
+{
+    return valid[GPOINTER_TO_INT(owner) - 1];
+}
+
+static void random_area(GRand *r, Rect *a)
+{
+    RECT_SET(*a, g_rand_int_range(r, 0, 30), g_rand_int_range(r, 0, 30),
+             g_rand_int_range(r, 1, 12), g_rand_int_range(r, 1, 12));
+}
+
+static void check_edge(GRand *r, ObDirection dir, gint skip)
+{
+    gint my_head, my_size, my_edge_start, my_edge_size;
+    gint dest1, dest2;
+    gboolean near1, near2;
+    gint i;
+
+    my_head = g_rand_int_range(r, -2, 45);
+    my_size = g_rand_int_range(r, 1, 15);
+    my_edge_start = g_rand_int_range(r, -2, 40);
+    my_edge_size = g_rand_int_range(r, 1, 15);
+
+    /* start at the edge of the screen, like openbox does */
+    near1 = near2 = TRUE;
+    if (dir == OB_DIRECTION_NORTH || dir == OB_DIRECTION_WEST)
+        dest1 = dest2 = -1;
+    else
+        dest1 = dest2 = 45;
+
+    for (i = 0; i < MAXWIN; ++i)
+        if (where[i] >= 0 && i != skip)
+            edge_index_detect(&areas[i], dir, my_head, my_size,
+                              my_edge_start, my_edge_size, &dest1, &near1);
+    edge_index_find_edge(indexes, NUMINDEX, skip >= 0 ? OWNER(skip) : NULL,
+                         dir, my_head, my_size, my_edge_start, my_edge_size,
+                         &dest2, &near2);
+
+    if (dest1 != dest2 || near1 != near2)
+        if (++failures <= 10)
+            fprintf(stderr, "edge mismatch going %d from %d size %d: "
+                    "expected %d %s got %d %s\n", dir, my_head, my_size,
+                    dest1, near1 ? "near" : "far",
+                    dest2, near2 ? "near" : "far");
+}
+
+/*! The way openbox used to find the window to focus in a direction */
+static gpointer find_directional(gint from, ObDirection dir)
+{
+    gint my_cx, my_cy, his_cx, his_cy;
+    gint offset = 0, distance = 0, score, best_score = -1;
+    gint i, best = from;
+
+    my_cx = areas[from].x + areas[from].width / 2;
+    my_cy = areas[from].y + areas[from].height / 2;
+
+    for (i = 0; i < MAXWIN; ++i) {
+        if (where[i] < 0 || i == from || !valid[i]) continue;
+
+        his_cx = (areas[i].x - my_cx) + areas[i].width / 2;
+        his_cy = (areas[i].y - my_cy) + areas[i].height / 2;
+
+        if (dir == OB_DIRECTION_NORTHEAST || dir == OB_DIRECTION_SOUTHEAST ||
+            dir == OB_DIRECTION_SOUTHWEST || dir == OB_DIRECTION_NORTHWEST)
+        {
+            gint tx = his_cx + his_cy;
+            his_cy = -his_cx + his_cy;
+            his_cx = tx;
+        }
+
+        switch (dir) {
+        case OB_DIRECTION_NORTH:
+        case OB_DIRECTION_SOUTH:
+        case OB_DIRECTION_NORTHEAST:
+        case OB_DIRECTION_SOUTHWEST:
+            offset = ABS(his_cx);
+            distance = ((dir == OB_DIRECTION_NORTH ||
+                         dir == OB_DIRECTION_NORTHEAST) ?
+                        -his_cy : his_cy);
+            break;
+        case OB_DIRECTION_EAST:
+        case OB_DIRECTION_WEST:
+        case OB_DIRECTION_SOUTHEAST:
+        case OB_DIRECTION_NORTHWEST:
+            offset = ABS(his_cy);
+            distance = ((dir == OB_DIRECTION_WEST ||
+                         dir == OB_DIRECTION_NORTHWEST) ?
+                        -his_cx : his_cx);
+            break;
+        }
+
+        if (distance <= 0) continue;
+
+        score = distance + offset;
+        if (offset > distance)
+            score += 1000000;
+
+        if (best_score == -1 || score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    return OWNER(best);
+}
+
+static void check_directional(gint from, ObDirection dir)
+{
+    gpointer a, b;
+
+    a = find_directional(from, dir);
+    b = edge_index_find_directional(indexes, NUMINDEX, OWNER(from),
+                                    &areas[from], dir, is_valid);
+    if (a != b)
+        if (++failures <= 10)
+            fprintf(stderr, "directional mismatch going %d from %d: "
+                    "expected %d got %d\n", dir, from,
+                    GPOINTER_TO_INT(a) - 1, GPOINTER_TO_INT(b) - 1);
+}
+
+static void test_random(GRand *r)
+{
+    gint round, i, j;
+
+    for (i = 0; i < NUMINDEX; ++i)
+        indexes[i] = edge_index_new();
+    for (i = 0; i < MAXWIN; ++i)
+        where[i] = -1;
+
+    for (round = 0; round < 20000; ++round) {
+        /* move a few windows around, or between the indexes, or out of
+           them */
+        for (j = g_rand_int_range(r, 1, 4); j > 0; --j) {
+            i = g_rand_int_range(r, 0, MAXWIN);
+            if (where[i] >= 0)
+                edge_index_remove(indexes[where[i]], OWNER(i));
+            if (g_rand_int_range(r, 0, 5)) {
+                random_area(r, &areas[i]);
+                where[i] = g_rand_int_range(r, 0, NUMINDEX);
+                edge_index_add(indexes[where[i]], OWNER(i), i + 1, &areas[i]);
+            }
+            else
+                where[i] = -1;
+            valid[i] = g_rand_int_range(r, 0, 4) > 0;
+        }
+
+        i = g_rand_int_range(r, 0, MAXWIN);
+        if (where[i] < 0) i = -1;
+        check_edge(r, OB_DIRECTION_NORTH, i);
+        check_edge(r, OB_DIRECTION_SOUTH, i);
+        check_edge(r, OB_DIRECTION_EAST, i);
+        check_edge(r, OB_DIRECTION_WEST, i);
+
+        if (i >= 0) {
+            ObDirection dir;
+
+            for (dir = OB_DIRECTION_NORTH; dir <= OB_DIRECTION_NORTHWEST;
+                 ++dir)
+                check_directional(i, dir);
+        }
+    }
+
+    for (i = 0; i < NUMINDEX; ++i)
+        edge_index_free(indexes[i]);
+}
+
+gint main(gint argc, gchar **argv)
+{
+    GRand *r = g_rand_new_with_seed(1);
+
+    test_random(r);
+    g_rand_free(r);
+
+    if (failures) {
+        printf("FAILED: %u searches did not match\n", failures);
+        return 1;
+    }
+    printf("OK: the edge indexes match searching every window\n");
+    return 0;
+}
@@ -39,10 +39,12 @@
 #include "group.h"
 #include "stacking.h"
 #include "ping.h"
+#include "animate.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
 #include "obt/prop.h"
 #include "obt/keyboard.h"
+#include "obt/loop.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
@@ -80,6 +82,12 @@ typedef struct
     gulong end;   /* inclusive */
 } ObSerialRange;
 
+typedef struct
+{
+    ObEventDeferFunc func;
+    gpointer data;
+} ObEventDeferred;
+
 static void event_process(const XEvent *e, gpointer data);
 static void event_handle_root(XEvent *e);
 static gboolean event_handle_menu_input(XEvent *e);
@@ -91,12 +99,15 @@ static void event_handle_client(ObClient *c, XEvent *e);
 static gboolean event_handle_user_input(ObClient *client, XEvent *e);
 static gboolean is_enter_focus_event_ignored(gulong serial);
 static void event_ignore_enter_range(gulong start, gulong end);
+static void event_move_serial_past_ignored(gpointer data);
+static gboolean event_cancel_crossing(XEvent *e);
 
 static void focus_delay_dest(gpointer data);
 static void unfocus_delay_dest(gpointer data);
 static gboolean focus_delay_func(gpointer data);
 static gboolean unfocus_delay_func(gpointer data);
 static void focus_delay_client_dest(ObClient *client, gpointer data);
+static gboolean deferred_idle_func(gpointer data);
 
 Time event_last_user_time = CurrentTime;
 
@@ -110,12 +121,42 @@ static Time event_sourcetime = CurrentTime;
 static gulong event_curserial;
 static gboolean focus_left_screen = FALSE;
 static gboolean waiting_for_focusin = FALSE;
-/*! A list of ObSerialRanges which are to be ignored for mouse enter events */
-static GSList *ignore_serials = NULL;
+/*! How many ranges of serials can be ignored for mouse enter events at
+  once.  Ranges which overlap or follow on from each other are merged, so
+  this is only filled when lots are made without any events in between. */
+#define IGNORE_SERIALS_SIZE 16
+/*! A ring of ObSerialRanges which are to be ignored for mouse enter events,
+  starting at ignore_serials_first.  They are kept in order, and do not
+  overlap, so the ones that events have gone past are always at the
+  front. */
+static ObSerialRange ignore_serials[IGNORE_SERIALS_SIZE];
+static guint ignore_serials_first = 0;
+static guint ignore_serials_num = 0;
+/*! The end of the last range of serials to be ignored, the serial needs to
+  be moved past it */
+static gulong ignore_serials_end = 0;
+/*! How many requests were made to move the serial past the ignored ranges,
+  and how many times something else had done it first */
+static guint serial_bumps_made = 0;
+static guint serial_bumps_skipped = 0;
+/*! How many times the mouse left a window and came straight back into it,
+  without it being focused or unfocused */
+static guint crossings_cancelled = 0;
 static guint focus_delay_timeout_id = 0;
 static ObClient *focus_delay_timeout_client = NULL;
 static guint unfocus_delay_timeout_id = 0;
 static ObClient *unfocus_delay_timeout_client = NULL;
+/*! The ObEventDeferred calls waiting, in the order they were asked for */
+static GQueue deferred = G_QUEUE_INIT;
+/*! The same ObEventDeferred calls, to find a call that is already waiting */
+static GHashTable *deferred_set = NULL;
+/*! Runs the deferred calls when they were made outside of handling an
+  event */
+static guint deferred_idle_id = 0;
+/*! How many deferred calls were made, and how many were merged into a call
+  that was already waiting */
+static guint deferred_run = 0;
+static guint deferred_merged = 0;
 
 #ifdef USE_SM
 static gboolean ice_handler(GIOChannel *source, GIOCondition cond,
@@ -131,13 +172,10 @@ static void ice_watch(IceConn conn, IcePointer data, Bool opening,
 {
     static guint id = 0;
 
-    if (opening) {
-        GIOChannel *ch;
-
-        ch = g_io_channel_unix_new(IceConnectionNumber(conn));
-        id = g_io_add_watch(ch, G_IO_IN, ice_handler, conn);
-        g_io_channel_unref(ch);
-    } else if (id) {
+    if (opening)
+        id = obt_loop_add(IceConnectionNumber(conn), G_IO_IN, ice_handler,
+                          conn);
+    else if (id) {
         g_source_remove(id);
         id = 0;
     }
@@ -159,8 +197,29 @@ void event_startup(gboolean reconfig)
 
 void event_shutdown(gboolean reconfig)
 {
+    ob_debug("Deferred work: %u calls made, %u redundant calls merged",
+             deferred_run, deferred_merged);
+    ob_debug("Ignored enters: %u serial bumps made, %u skipped, "
+             "%u focus changes avoided",
+             serial_bumps_made, serial_bumps_skipped, crossings_cancelled);
+
+    /* when reconfiguring, calls deferred by the shutdown are made once
+       everything is started again */
     if (reconfig) return;
 
+    /* the work waiting was run before anything was shut down.  what the
+       shutdown deferred is for things which are gone now */
+    if (deferred_idle_id) {
+        g_source_remove(deferred_idle_id);
+        deferred_idle_id = 0;
+    }
+    while (!g_queue_is_empty(&deferred))
+        g_slice_free(ObEventDeferred, g_queue_pop_head(&deferred));
+    if (deferred_set) {
+        g_hash_table_destroy(deferred_set);
+        deferred_set = NULL;
+    }
+
 #ifdef USE_SM
     IceRemoveConnectionWatch(ice_watch, NULL);
 #endif
@@ -458,6 +517,8 @@ static void event_process(const XEvent *ec, gpointer data)
     ObWindow *obwin = NULL;
     ObMenuFrame *menu = NULL;
     ObPrompt *prompt = NULL;
+    ObWindowClass type;
+    gpointer found;
     gboolean used;
 
     /* make a copy we can mangle */
@@ -467,8 +528,11 @@ static void event_process(const XEvent *ec, gpointer data)
     window = event_get_window(e);
     if (window == obt_root(ob_screen))
         /* don't do any lookups, waste of cpu */;
-    else if ((obwin = window_find(window))) {
-        switch (obwin->type) {
+    else if ((found = window_find_any(window, &type))) {
+        if (type != OB_WINDOW_CLASS_DOCKAPP)
+            obwin = found;
+
+        switch (type) {
         case OB_WINDOW_CLASS_DOCK:
             dock = WINDOW_AS_DOCK(obwin);
             break;
@@ -486,10 +550,11 @@ static void event_process(const XEvent *ec, gpointer data)
         case OB_WINDOW_CLASS_PROMPT:
             prompt = WINDOW_AS_PROMPT(obwin);
             break;
+        case OB_WINDOW_CLASS_DOCKAPP:
+            dockapp = found;
+            break;
         }
     }
-    else
-        dockapp = dock_find_dockapp(window);
 
     event_set_curtime(e);
     event_curserial = e->xany.serial;
@@ -635,6 +700,8 @@ static void event_process(const XEvent *ec, gpointer data)
     else if (e->type == MapRequest)
         window_manage(window);
     else if (e->type == MappingNotify) {
+        obt_keyboard_mapping_changed(&e->xmapping);
+
         /* keyboard layout changes for modifier mapping changes. reload the
            modifier map, and rebind all the key bindings as appropriate */
         if (config_keyboard_rebind_on_mapping_notify) {
@@ -743,6 +810,11 @@ static void event_process(const XEvent *ec, gpointer data)
        the time, so clear it here until the next event is handled */
     event_curtime = event_sourcetime = CurrentTime;
     event_curserial = 0;
+
+    /* once the events that have arrived are all handled, do the work that
+       was put off until the end */
+    if (!xqueue_pending_local())
+        event_run_deferred();
 }
 
 static void event_handle_root(XEvent *e)
@@ -801,6 +873,8 @@ static void event_handle_root(XEvent *e)
         }
         else if (e->xproperty.atom == OBT_PROP_ATOM(NET_DESKTOP_LAYOUT))
             screen_update_layout();
+        else if (e->xproperty.atom == OBT_PROP_ATOM(ROOTPMAPID))
+            screen_update_background();
         break;
     case ConfigureNotify:
 #ifdef XRANDR
@@ -809,6 +883,16 @@ static void event_handle_root(XEvent *e)
         screen_resize();
         break;
     default:
+#ifdef XRANDR
+        if (obt_display_extension_randr &&
+            e->type == obt_display_extension_randr_basep +
+            RRScreenChangeNotify)
+        {
+            XRRUpdateConfiguration(e);
+            /* the refresh rate may have changed along with the mode */
+            animate_update_rate();
+        }
+#endif
         ;
     }
 }
@@ -1090,6 +1174,9 @@ static void event_handle_client(ObClient *client, XEvent *e)
                    delay is up */
                 e->xcrossing.detail != NotifyInferior)
             {
+                /* coming straight back in leaves things as they are */
+                if (event_cancel_crossing(e))
+                    break;
                 if (config_focus_delay && focus_delay_timeout_id)
                     g_source_remove(focus_delay_timeout_id);
                 if (config_unfocus_leave)
@@ -1876,10 +1963,16 @@ static gboolean event_handle_menu_input(XEvent *ev)
             sym = obt_keyboard_keypress_to_keysym(ev);
 
             if (sym == XK_Escape) {
-                menu_frame_hide_all();
+                /* the first Escape stops filtering the menu */
+                if (!menu_frame_filter_clear(frame))
+                    menu_frame_hide_all();
                 ret = TRUE;
             }
 
+            /* BackSpace only means something while filtering the menu */
+            else if (sym == XK_BackSpace && menu_frame_filter_back(frame))
+                ret = TRUE;
+
             else if (sym == XK_Left) {
                 /* Left goes to the parent menu */
                 if (frame->parent) {
@@ -1933,6 +2026,17 @@ static gboolean event_handle_menu_input(XEvent *ev)
                 ret = TRUE;
             }
 
+            /* once the menu is being filtered, typing adds to the filter */
+            else if (frame->filter &&
+                     (unikey =
+                      obt_keyboard_keypress_to_unichar(menu_frame_ic(frame),
+                                                       ev)) &&
+                     g_unichar_isgraph(unikey))
+            {
+                menu_frame_filter_add(frame, unikey);
+                ret = TRUE;
+            }
+
             /* keyboard accelerator shortcuts. (if it was a valid key) */
             else if (frame->entries &&
                      (unikey =
@@ -1989,6 +2093,12 @@ static gboolean event_handle_menu_input(XEvent *ev)
                     }
                     ret = TRUE;
                 }
+                /* if no entry has it as a shortcut, start filtering the
+                   entries with it */
+                else if (g_unichar_isgraph(unikey)) {
+                    menu_frame_filter_add(frame, unikey);
+                    ret = TRUE;
+                }
             }
         }
 
@@ -2166,23 +2276,79 @@ gulong event_start_ignore_all_enters(void)
     return NextRequest(obt_display);
 }
 
+#define IGNORE_SERIAL(i) \
+    ignore_serials[(ignore_serials_first + (i)) % IGNORE_SERIALS_SIZE]
+
 static void event_ignore_enter_range(gulong start, gulong end)
 {
-    ObSerialRange *r;
+    ObSerialRange after[IGNORE_SERIALS_SIZE];
+    guint i, nafter = 0;
 
     g_assert(start != 0);
     g_assert(end != 0);
 
-    r = g_slice_new(ObSerialRange);
-    r->start = start;
-    r->end = end;
-    ignore_serials = g_slist_prepend(ignore_serials, r);
-
     ob_debug_type(OB_DEBUG_FOCUS, "ignoring enters from %lu until %lu",
-                  r->start, r->end);
+                  start, end);
+
+    /* take off the ranges which come after this one, with a gap between
+       them.  usually there are none, as the serials only go up */
+    while (ignore_serials_num) {
+        ObSerialRange *r = &IGNORE_SERIAL(ignore_serials_num - 1);
+
+        if ((glong)(r->start - (end + 1)) <= 0) break;
+        after[nafter++] = *r;
+        --ignore_serials_num;
+    }
+    /* merge it with the ones that it overlaps or touches */
+    while (ignore_serials_num) {
+        ObSerialRange *r = &IGNORE_SERIAL(ignore_serials_num - 1);
+
+        if ((glong)((r->end + 1) - start) < 0) break;
+        if ((glong)(r->start - start) < 0) start = r->start;
+        if ((glong)(r->end - end) > 0) end = r->end;
+        --ignore_serials_num;
+    }
+
+    /* put it and the ones after it back */
+    for (i = nafter + 1; i > 0; --i) {
+        ObSerialRange *r;
+
+        if (ignore_serials_num == IGNORE_SERIALS_SIZE) {
+            /* out of room, so ignore the gap between the oldest two as
+               well, rather than forget to ignore any of them */
+            IGNORE_SERIAL(1).start = IGNORE_SERIAL(0).start;
+            ignore_serials_first =
+                (ignore_serials_first + 1) % IGNORE_SERIALS_SIZE;
+            --ignore_serials_num;
+        }
+
+        r = &IGNORE_SERIAL(ignore_serials_num);
+        if (i == nafter + 1) {
+            r->start = start;
+            r->end = end;
+        }
+        else
+            *r = after[i - 1];
+        ++ignore_serials_num;
+    }
+
+    ignore_serials_end = IGNORE_SERIAL(ignore_serials_num - 1).end;
 
-    /* increment the serial so we don't ignore events we weren't meant to */
-    OBT_PROP_ERASE(screen_support_win, MOTIF_WM_HINTS);
+    /* increment the serial so we don't ignore events we weren't meant to,
+       once all of the ranges for these events have been made */
+    event_defer(event_move_serial_past_ignored, NULL);
+}
+
+static void event_move_serial_past_ignored(gpointer data)
+{
+    /* if another request has been made since the last ignored serial, then
+       new events will already have a serial after it */
+    if ((glong)((NextRequest(obt_display) - 1) - ignore_serials_end) > 0)
+        ++serial_bumps_skipped;
+    else {
+        OBT_PROP_ERASE(screen_support_win, MOTIF_WM_HINTS);
+        ++serial_bumps_made;
+    }
 }
 
 void event_end_ignore_all_enters(gulong start)
@@ -2196,26 +2362,163 @@ void event_end_ignore_all_enters(gulong start)
     event_ignore_enter_range(start, NextRequest(obt_display)-1);
 }
 
-static gboolean is_enter_focus_event_ignored(gulong serial)
+static guint deferred_hash(gconstpointer key)
+{
+    const ObEventDeferred *d = key;
+    return (guint)(gsize)d->func * 31 + GPOINTER_TO_UINT(d->data);
+}
+
+static gboolean deferred_equal(gconstpointer a, gconstpointer b)
+{
+    const ObEventDeferred *d = a, *e = b;
+    return d->func == e->func && d->data == e->data;
+}
+
+void event_defer(ObEventDeferFunc func, gpointer data)
+{
+    ObEventDeferred *d, key;
+
+    if (!deferred_set)
+        deferred_set = g_hash_table_new(deferred_hash, deferred_equal);
+
+    key.func = func;
+    key.data = data;
+    if (g_hash_table_lookup(deferred_set, &key)) {
+        ++deferred_merged;
+        return;
+    }
+
+    d = g_slice_new(ObEventDeferred);
+    d->func = func;
+    d->data = data;
+    g_queue_push_tail(&deferred, d);
+    g_hash_table_insert(deferred_set, d, d);
+
+    /* if this isn't coming from an event, then there is no end of the
+       events to wait for, so do it when the main loop is idle */
+    if (!deferred_idle_id)
+        deferred_idle_id = g_idle_add(deferred_idle_func, NULL);
+}
+
+void event_cancel_defer(ObEventDeferFunc func, gpointer data)
 {
-    GSList *it, *next;
+    ObEventDeferred *d, key;
+
+    if (!deferred_set) return;
 
-    for (it = ignore_serials; it; it = next) {
-        ObSerialRange *r = it->data;
+    key.func = func;
+    key.data = data;
+    if ((d = g_hash_table_lookup(deferred_set, &key))) {
+        g_hash_table_remove(deferred_set, d);
+        /* leave it in the queue, it is skipped when it comes up */
+        d->func = NULL;
+    }
+}
+
+void event_run_deferred(void)
+{
+    if (deferred_idle_id) {
+        g_source_remove(deferred_idle_id);
+        deferred_idle_id = 0;
+    }
 
-        next = g_slist_next(it);
+    /* the calls can defer more calls, so keep going until it is empty */
+    while (!g_queue_is_empty(&deferred)) {
+        ObEventDeferred *d = g_queue_pop_head(&deferred);
 
-        if ((glong)(serial - r->end) > 0) {
-            /* past the end */
-            ignore_serials = g_slist_delete_link(ignore_serials, it);
-            g_slice_free(ObSerialRange, r);
+        if (d->func) {
+            g_hash_table_remove(deferred_set, d);
+            d->func(d->data);
+            ++deferred_run;
         }
-        else if ((glong)(serial - r->start) >= 0)
-            return TRUE;
+        g_slice_free(ObEventDeferred, d);
+    }
+
+    /* anything deferred while running is done now too */
+    if (deferred_idle_id) {
+        g_source_remove(deferred_idle_id);
+        deferred_idle_id = 0;
+    }
+}
+
+static gboolean deferred_idle_func(gpointer data)
+{
+    deferred_idle_id = 0;
+    event_run_deferred();
+    return FALSE; /* don't repeat */
+}
+
+static gboolean is_enter_focus_event_ignored(gulong serial)
+{
+    /* the events come in order, so the ranges which end before this one are
+       done with */
+    while (ignore_serials_num &&
+           (glong)(serial - IGNORE_SERIAL(0).end) > 0)
+    {
+        ignore_serials_first =
+            (ignore_serials_first + 1) % IGNORE_SERIALS_SIZE;
+        --ignore_serials_num;
     }
+
+    /* the ranges are in order, so only the first one can hold it */
+    return ignore_serials_num &&
+        (glong)(serial - IGNORE_SERIAL(0).start) >= 0;
+}
+
+/*! Like is_enter_focus_event_ignored() but for an event which is still in
+  the queue, so the ranges before it can't be thrown away yet */
+static gboolean is_queued_enter_ignored(gulong serial)
+{
+    guint i;
+
+    for (i = 0; i < ignore_serials_num; ++i)
+        if ((glong)(serial - IGNORE_SERIAL(i).start) >= 0 &&
+            (glong)(serial - IGNORE_SERIAL(i).end) <= 0)
+            return TRUE;
     return FALSE;
 }
 
+static gboolean look_for_crossing(XEvent *e, gpointer data)
+{
+    ObtXQueueWindowType *wt = data;
+
+    if (e->type != EnterNotify && e->type != LeaveNotify)
+        return FALSE;
+
+    /* stop at the next crossing event, and see if it goes back into the
+       window that was left */
+    if (e->type != EnterNotify || e->xcrossing.window != wt->window ||
+        e->xcrossing.mode != NotifyNormal ||
+        e->xcrossing.detail == NotifyInferior ||
+        is_queued_enter_ignored(e->xcrossing.serial))
+        wt->window = None;
+    return TRUE;
+}
+
+/*! When the mouse leaves a window and the next crossing event waiting in the
+  queue puts it straight back into the window, then the two cancel out.
+  This takes the EnterNotify out of the queue and returns TRUE if so. */
+static gboolean event_cancel_crossing(XEvent *e)
+{
+    ObtXQueueWindowType wt;
+    XEvent ce;
+
+    if (e->xcrossing.mode != NotifyNormal) return FALSE;
+
+    wt.window = e->xcrossing.window;
+    wt.type = EnterNotify;
+    if (!xqueue_exists_local(look_for_crossing, &wt) || wt.window == None)
+        return FALSE;
+
+    /* the first one on the window is the one that was found */
+    xqueue_remove_local(&ce, xqueue_match_window_type, &wt);
+    ++crossings_cancelled;
+    ob_debug_type(OB_DEBUG_FOCUS, "Leave and enter with serials %lu and %lu "
+                  "cancel out on 0x%lx", e->xcrossing.serial,
+                  ce.xcrossing.serial, wt.window);
+    return TRUE;
+}
+
 void event_cancel_all_key_grabs(void)
 {
     if (actions_interactive_act_running()) {
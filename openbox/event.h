@@ -88,4 +88,18 @@ void event_update_user_time(void);
 /*! Reset the timestamp for when the user has last used the focused window. */
 void event_reset_user_time(void);
 
+typedef void (*ObEventDeferFunc)(gpointer data);
+
+/*! Call @func with @data once all of the events which have already arrived
+  have been handled, instead of right away.  If the same function and data
+  are already waiting, it will still only be called once.  Use this for work
+  which is only about showing the end result, such as updating a property or
+  redrawing something, so that it is not done over for each event. */
+void event_defer(ObEventDeferFunc func, gpointer data);
+/*! Remove a call waiting from event_defer().  Use this when @data is being
+  destroyed. */
+void event_cancel_defer(ObEventDeferFunc func, gpointer data);
+/*! Make all of the calls waiting from event_defer() now */
+void event_run_deferred(void);
+
 #endif
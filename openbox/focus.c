@@ -19,6 +19,7 @@
 
 #include "debug.h"
 #include "event.h"
+#include "publish.h"
 #include "openbox.h"
 #include "grab.h"
 #include "client.h"
@@ -98,7 +99,7 @@ void focus_set_client(ObClient *client)
     /* set the NET_ACTIVE_WINDOW hint, but preserve it on shutdown */
     if (ob_state() != OB_STATE_EXITING) {
         active = client ? client->window : None;
-        OBT_PROP_SET32(obt_root(ob_screen), NET_ACTIVE_WINDOW, WINDOW, active);
+        PUBLISH_SET32(NET_ACTIVE_WINDOW, WINDOW, active);
     }
 
     /* when focus is moved to a new window, the last_user_time timestamp would
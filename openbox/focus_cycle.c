@@ -22,12 +22,14 @@
 #include "client.h"
 #include "frame.h"
 #include "focus.h"
+#include "event.h"
 #include "screen.h"
 #include "openbox.h"
 #include "debug.h"
 
 #include <X11/Xlib.h>
 #include <glib.h>
+#include <string.h>
 
 typedef enum {
     OB_CYCLE_NONE = 0,
@@ -36,6 +38,7 @@ typedef enum {
 } ObCycleType;
 
 ObClient       *focus_cycle_target = NULL;
+GPtrArray      *focus_cycle_candidates = NULL;
 static ObCycleType focus_cycle_type = OB_CYCLE_NONE;
 static gboolean focus_cycle_linear;
 static gboolean focus_cycle_iconic_windows;
@@ -43,20 +46,110 @@ static gboolean focus_cycle_all_desktops;
 static gboolean focus_cycle_nonhilite_windows;
 static gboolean focus_cycle_dock_windows;
 static gboolean focus_cycle_desktop_windows;
+/*! Where focus_cycle_target is in focus_cycle_candidates */
+static gint     cycle_pos;
 
 static ObClient *focus_find_directional(ObClient *c,
                                         ObDirection dir,
                                         gboolean dock_windows,
                                         gboolean desktop_windows);
+static void reorder(gpointer data);
 
 void focus_cycle_startup(gboolean reconfig)
 {
     if (reconfig) return;
+
+    focus_cycle_candidates = g_ptr_array_new();
 }
 
 void focus_cycle_shutdown(gboolean reconfig)
 {
     if (reconfig) return;
+
+    g_ptr_array_free(focus_cycle_candidates, TRUE);
+    focus_cycle_candidates = NULL;
+}
+
+/*! Fill focus_cycle_candidates with the clients which the cycle can go to.
+  Returns the place that @from has in the list, or the place that it would
+  have if it is not valid, and sets @found to if it is valid.  Returns -1 if
+  @from is not in the list at all. */
+static gint candidates_build(ObClient *from, gboolean *found)
+{
+    GList *it;
+    gint at = -1;
+
+    *found = FALSE;
+    g_ptr_array_set_size(focus_cycle_candidates, 0);
+    for (it = focus_cycle_linear ? client_list : focus_order; it;
+         it = g_list_next(it))
+    {
+        if (it->data == from)
+            at = focus_cycle_candidates->len;
+        if (focus_cycle_valid(it->data)) {
+            if (it->data == from) *found = TRUE;
+            g_ptr_array_add(focus_cycle_candidates, it->data);
+        }
+    }
+    return at;
+}
+
+/*! Add or remove the client in the list of candidates, if it has become
+  valid or stopped being valid.  Returns TRUE if it was changed. */
+static gboolean candidates_patch(ObClient *c)
+{
+    GPtrArray *a = focus_cycle_candidates;
+    GList *it;
+    guint i;
+    gboolean v;
+
+    for (i = 0; i < a->len; ++i)
+        if (g_ptr_array_index(a, i) == c) break;
+
+    v = focus_cycle_valid(c);
+    if (v == (i < a->len)) return FALSE;
+
+    if (!v) {
+        g_ptr_array_remove_index(a, i);
+        /* if it was the target, move to the one before it if there is one,
+           or else the one after it */
+        if ((gint)i < cycle_pos || ((gint)i == cycle_pos && i > 0))
+            --cycle_pos;
+    }
+    else {
+        /* the candidates are in the same order as the list, so count the
+           ones that come before it there */
+        i = 0;
+        for (it = focus_cycle_linear ? client_list : focus_order;
+             it && it->data != c; it = g_list_next(it))
+        {
+            if (i < a->len && g_ptr_array_index(a, i) == it->data)
+                ++i;
+        }
+        g_ptr_array_add(a, NULL);
+        memmove(a->pdata + i + 1, a->pdata + i,
+                (a->len - i - 1) * sizeof(gpointer));
+        a->pdata[i] = c;
+        if ((gint)i <= cycle_pos)
+            ++cycle_pos;
+    }
+    return TRUE;
+}
+
+/*! Show the changes in the candidates, with the target at cycle_pos */
+static void candidates_changed(void)
+{
+    if (focus_cycle_candidates->len == 0) {
+        /* there's nothing left to cycle to */
+        focus_cycle(TRUE, TRUE, TRUE, TRUE, TRUE, TRUE,
+                    TRUE, OB_FOCUS_CYCLE_POPUP_MODE_NONE,
+                    TRUE, TRUE);
+        return;
+    }
+
+    focus_cycle_target = g_ptr_array_index(focus_cycle_candidates, cycle_pos);
+    focus_cycle_popup_refresh(focus_cycle_target, TRUE);
+    focus_cycle_update_indicator(focus_cycle_target);
 }
 
 void focus_cycle_addremove(ObClient *c, gboolean redraw)
@@ -71,33 +164,44 @@ void focus_cycle_addremove(ObClient *c, gboolean redraw)
         }
     }
     else if (c && redraw) {
-        gboolean v, s;
-
-        v = focus_cycle_valid(c);
-        s = focus_cycle_popup_is_showing(c) || c == focus_cycle_target;
-
-        if (v != s)
-            focus_cycle_reorder();
+        /* only the one client changed, so just patch it in or out */
+        if (candidates_patch(c))
+            candidates_changed();
     }
     else if (redraw) {
-        focus_cycle_reorder();
+        reorder(NULL);
     }
 }
 
-void focus_cycle_reorder()
+/*! Make the candidates again and find a new target if the old one is not
+  valid anymore */
+static void reorder(gpointer data)
 {
     if (focus_cycle_type == OB_CYCLE_NORMAL) {
-        focus_cycle_target = focus_cycle_popup_refresh(focus_cycle_target,
-                                                       TRUE,
-                                                       focus_cycle_linear);
-        focus_cycle_update_indicator(focus_cycle_target);
-        if (!focus_cycle_target)
-            focus_cycle(TRUE, TRUE, TRUE, TRUE, TRUE, TRUE,
-                        TRUE, OB_FOCUS_CYCLE_POPUP_MODE_NONE,
-                        TRUE, TRUE);
+        gboolean found;
+        gint at;
+
+        at = candidates_build(focus_cycle_target, &found);
+        if (at < 0)
+            /* the target is gone, stay around the same place */
+            at = cycle_pos;
+        if (!found && at > 0)
+            /* move to the one before it if there is one, or else the one
+               after it */
+            --at;
+        cycle_pos = MIN(at, (gint)focus_cycle_candidates->len - 1);
+        candidates_changed();
     }
 }
 
+void focus_cycle_reorder()
+{
+    /* the focus order can change several times in a batch of events, and
+       the popup only needs to be redrawn for the last one */
+    if (focus_cycle_type == OB_CYCLE_NORMAL)
+        event_defer(reorder, NULL);
+}
+
 ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
                       gboolean nonhilite_windows,
                       gboolean dock_windows, gboolean desktop_windows,
@@ -105,10 +209,10 @@ ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
                       ObFocusCyclePopupMode mode,
                       gboolean done, gboolean cancel)
 {
-    static GList *order = NULL;
-    GList *it, *start, *list;
     ObClient *ft = NULL;
     ObClient *ret = NULL;
+    gboolean found;
+    gint at, n;
 
     if (cancel) {
         focus_cycle_target = NULL;
@@ -119,9 +223,6 @@ ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
     if (!focus_order)
         goto done_cycle;
 
-    if (linear) list = client_list;
-    else        list = focus_order;
-
     if (focus_cycle_target == NULL) {
         focus_cycle_linear = linear;
         focus_cycle_iconic_windows = TRUE;
@@ -129,42 +230,41 @@ ObClient* focus_cycle(gboolean forward, gboolean all_desktops,
         focus_cycle_nonhilite_windows = nonhilite_windows;
         focus_cycle_dock_windows = dock_windows;
         focus_cycle_desktop_windows = desktop_windows;
-        start = it = g_list_find(list, focus_client);
-    } else
-        start = it = g_list_find(list, focus_cycle_target);
-
-    if (!start) /* switched desktops or something? */
-        start = it = forward ? g_list_last(list) : g_list_first(list);
-    if (!start) goto done_cycle;
-
-    do {
-        if (forward) {
-            it = it->next;
-            if (it == NULL) it = g_list_first(list);
-        } else {
-            it = it->prev;
-            if (it == NULL) it = g_list_last(list);
-        }
-        ft = it->data;
-        if (focus_cycle_valid(ft)) {
-            if (ft != focus_cycle_target) { /* prevents flicker */
-                focus_cycle_target = ft;
-                focus_cycle_type = OB_CYCLE_NORMAL;
-                focus_cycle_draw_indicator(showbar ? ft : NULL);
-            }
-            /* same arguments as focus_target_valid */
-            focus_cycle_popup_show(ft, mode, focus_cycle_linear);
-            return focus_cycle_target;
-        }
-    } while (it != start);
+        /* find all the windows to cycle through once, they are kept up to
+           date from here on */
+        at = candidates_build(focus_client, &found);
+    } else {
+        at = cycle_pos;
+        found = TRUE;
+    }
+
+    n = focus_cycle_candidates->len;
+    if (!n) goto done_cycle;
+
+    if (at < 0) /* switched desktops or something? */
+        at = forward ? 0 : n - 1;
+    else if (forward)
+        at = found ? at + 1 : at;
+    else
+        at = at - 1;
+    cycle_pos = (at + n) % n;
+
+    ft = g_ptr_array_index(focus_cycle_candidates, cycle_pos);
+    if (ft != focus_cycle_target) { /* prevents flicker */
+        focus_cycle_target = ft;
+        focus_cycle_type = OB_CYCLE_NORMAL;
+        focus_cycle_draw_indicator(showbar ? ft : NULL);
+    }
+    /* same arguments as focus_target_valid */
+    focus_cycle_popup_show(ft, mode);
+    return focus_cycle_target;
 
 done_cycle:
     if (done && !cancel) ret = focus_cycle_target;
 
     focus_cycle_target = NULL;
     focus_cycle_type = OB_CYCLE_NONE;
-    g_list_free(order);
-    order = NULL;
+    g_ptr_array_set_size(focus_cycle_candidates, 0);
 
     focus_cycle_draw_indicator(NULL);
     focus_cycle_popup_hide();
@@ -172,99 +272,16 @@ done_cycle:
     return ret;
 }
 
-/* this be mostly ripped from fvwm */
 static ObClient *focus_find_directional(ObClient *c, ObDirection dir,
                                         gboolean dock_windows,
                                         gboolean desktop_windows)
 {
-    gint my_cx, my_cy, his_cx, his_cy;
-    gint offset = 0;
-    gint distance = 0;
-    gint score, best_score;
-    ObClient *best_client, *cur;
-    GList *it;
-
     if (!client_list)
         return NULL;
 
-    /* first, find the centre coords of the currently focused window */
-    my_cx = c->frame->area.x + c->frame->area.width / 2;
-    my_cy = c->frame->area.y + c->frame->area.height / 2;
-
-    best_score = -1;
-    best_client = c;
-
-    for (it = g_list_first(client_list); it; it = g_list_next(it)) {
-        cur = it->data;
-
-        /* the currently selected window isn't interesting */
-        if (cur == c)
-            continue;
-        if (!focus_cycle_valid(it->data))
-            continue;
-
-        /* find the centre coords of this window, from the
-         * currently focused window's point of view */
-        his_cx = (cur->frame->area.x - my_cx)
-            + cur->frame->area.width / 2;
-        his_cy = (cur->frame->area.y - my_cy)
-            + cur->frame->area.height / 2;
-
-        if (dir == OB_DIRECTION_NORTHEAST || dir == OB_DIRECTION_SOUTHEAST ||
-            dir == OB_DIRECTION_SOUTHWEST || dir == OB_DIRECTION_NORTHWEST)
-        {
-            gint tx;
-            /* Rotate the diagonals 45 degrees counterclockwise.
-             * To do this, multiply the matrix /+h +h\ with the
-             * vector (x y).                   \-h +h/
-             * h = sqrt(0.5). We can set h := 1 since absolute
-             * distance doesn't matter here. */
-            tx = his_cx + his_cy;
-            his_cy = -his_cx + his_cy;
-            his_cx = tx;
-        }
-
-        switch (dir) {
-        case OB_DIRECTION_NORTH:
-        case OB_DIRECTION_SOUTH:
-        case OB_DIRECTION_NORTHEAST:
-        case OB_DIRECTION_SOUTHWEST:
-            offset = (his_cx < 0) ? -his_cx : his_cx;
-            distance = ((dir == OB_DIRECTION_NORTH ||
-                         dir == OB_DIRECTION_NORTHEAST) ?
-                        -his_cy : his_cy);
-            break;
-        case OB_DIRECTION_EAST:
-        case OB_DIRECTION_WEST:
-        case OB_DIRECTION_SOUTHEAST:
-        case OB_DIRECTION_NORTHWEST:
-            offset = (his_cy < 0) ? -his_cy : his_cy;
-            distance = ((dir == OB_DIRECTION_WEST ||
-                         dir == OB_DIRECTION_NORTHWEST) ?
-                        -his_cx : his_cx);
-            break;
-        }
-
-        /* the target must be in the requested direction */
-        if (distance <= 0)
-            continue;
-
-        /* Calculate score for this window.  The smaller the better. */
-        score = distance + offset;
-
-        /* windows more than 45 degrees off the direction are
-         * heavily penalized and will only be chosen if nothing
-         * else within a million pixels */
-        if (offset > distance)
-            score += 1000000;
-
-        if (best_score == -1 || score < best_score) {
-            best_client = cur;
-            best_score = score;
-        }
-    }
-
-    return best_client;
+    /* the valid ones are all on this desktop and not iconic, which are the
+       ones in the edge indexes */
+    return client_find_directional(c, dir, focus_cycle_valid);
 }
 
 ObClient* focus_directional_cycle(ObDirection dir, gboolean dock_windows,
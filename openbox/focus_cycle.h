@@ -30,6 +30,10 @@ struct _ObClient;
 
 /*! The client which appears focused during a focus cycle operation */
 extern struct _ObClient *focus_cycle_target;
+/*! The clients that a focus cycle goes through, in the order it visits them.
+  This is found when the cycle starts and is kept up to date as the clients
+  change, so each step only moves along it. */
+extern GPtrArray *focus_cycle_candidates;
 
 void focus_cycle_startup(gboolean reconfig);
 void focus_cycle_shutdown(gboolean reconfig);
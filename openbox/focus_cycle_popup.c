@@ -102,8 +102,7 @@ static ObIconPopup *single_popup;
 static gchar   *popup_get_name (ObClient *c);
 static gboolean popup_setup    (ObFocusCyclePopup *p,
                                 gboolean create_targets,
-                                gboolean refresh_targets,
-                                gboolean linear);
+                                gboolean refresh_targets);
 static void     popup_render   (ObFocusCyclePopup *p,
                                 const ObClient *c);
 
@@ -251,10 +250,10 @@ static void popup_target_free(ObFocusCyclePopupTarget *t)
 }
 
 static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
-                            gboolean refresh_targets, gboolean linear)
+                            gboolean refresh_targets)
 {
     gint maxwidth, n;
-    GList *it;
+    guint i;
     GList *rtargets; /* old targets for refresh */
     GList *rtlast;
     gboolean change;
@@ -276,61 +275,55 @@ static gboolean popup_setup(ObFocusCyclePopup *p, gboolean create_targets,
 
     /* make its width to be the width of all the possible titles */
 
-    /* build a list of all the valid focus targets and measure their strings,
-       and count them */
+    /* build a list of all the focus targets that the cycle goes through and
+       measure their strings, and count them */
     maxwidth = 0;
     n = 0;
-    for (it = g_list_last(linear ? client_list : focus_order);
-         it;
-         it = g_list_previous(it))
-    {
-        ObClient *ft = it->data;
-
-        if (focus_cycle_valid(ft)) {
-            GList *rit;
-
-            /* reuse the target if possible during refresh */
-            for (rit = rtlast; rit; rit = g_list_previous(rit)) {
-                ObFocusCyclePopupTarget *t = rit->data;
-                if (t->client == ft) {
-                    if (rit == rtlast)
-                        rtlast = g_list_previous(rit);
-                    rtargets = g_list_remove_link(rtargets, rit);
-
-                    p->targets = g_list_concat(rit, p->targets);
-                    ++n;
-
-                    if (rit != rtlast)
-                        change = TRUE; /* order changed */
-                    break;
-                }
+    for (i = focus_cycle_candidates->len; i > 0; --i) {
+        ObClient *ft = g_ptr_array_index(focus_cycle_candidates, i - 1);
+        GList *rit;
+
+        /* reuse the target if possible during refresh */
+        for (rit = rtlast; rit; rit = g_list_previous(rit)) {
+            ObFocusCyclePopupTarget *t = rit->data;
+            if (t->client == ft) {
+                if (rit == rtlast)
+                    rtlast = g_list_previous(rit);
+                rtargets = g_list_remove_link(rtargets, rit);
+
+                p->targets = g_list_concat(rit, p->targets);
+                ++n;
+
+                if (rit != rtlast)
+                    change = TRUE; /* order changed */
+                break;
             }
+        }
 
-            if (!rit) {
-                gchar *text = popup_get_name(ft);
+        if (!rit) {
+            gchar *text = popup_get_name(ft);
 
-                /* measure */
-                p->a_text->texture[0].data.text.string = text;
-                maxwidth = MAX(maxwidth, RrMinWidth(p->a_text));
+            /* measure */
+            p->a_text->texture[0].data.text.string = text;
+            maxwidth = MAX(maxwidth, RrMinWidth(p->a_text));
 
-                if (!create_targets) {
-                    g_free(text);
-                } else {
-                    ObFocusCyclePopupTarget *t =
-                        g_slice_new(ObFocusCyclePopupTarget);
+            if (!create_targets) {
+                g_free(text);
+            } else {
+                ObFocusCyclePopupTarget *t =
+                    g_slice_new(ObFocusCyclePopupTarget);
 
-                    t->client = ft;
-                    t->text = text;
-                    t->icon = client_icon(t->client);
-                    RrImageRef(t->icon); /* own the icon so it won't go away */
-                    t->iconwin = create_window(p->bg, 0, 0, NULL);
-                    t->textwin = create_window(p->bg, 0, 0, NULL);
+                t->client = ft;
+                t->text = text;
+                t->icon = client_icon(t->client);
+                RrImageRef(t->icon); /* own the icon so it won't go away */
+                t->iconwin = create_window(p->bg, 0, 0, NULL);
+                t->textwin = create_window(p->bg, 0, 0, NULL);
 
-                    p->targets = g_list_prepend(p->targets, t);
-                    ++n;
+                p->targets = g_list_prepend(p->targets, t);
+                ++n;
 
-                    change = TRUE; /* added a window */
-                }
+                change = TRUE; /* added a window */
             }
         }
     }
@@ -704,8 +697,7 @@ static void popup_render(ObFocusCyclePopup *p, const ObClient *c)
     XFlush(obt_display);
 }
 
-void focus_cycle_popup_show(ObClient *c, ObFocusCyclePopupMode mode,
-                            gboolean linear)
+void focus_cycle_popup_show(ObClient *c, ObFocusCyclePopupMode mode)
 {
     g_assert(c != NULL);
 
@@ -716,7 +708,7 @@ void focus_cycle_popup_show(ObClient *c, ObFocusCyclePopupMode mode,
 
     /* do this stuff only when the dialog is first showing */
     if (!popup.mapped) {
-        popup_setup(&popup, TRUE, FALSE, linear);
+        popup_setup(&popup, TRUE, FALSE);
         /* this is fixed once the dialog is shown */
         popup.mode = mode;
     }
@@ -780,20 +772,6 @@ void focus_cycle_popup_single_hide(void)
     icon_popup_hide(single_popup);
 }
 
-gboolean focus_cycle_popup_is_showing(ObClient *c)
-{
-    if (popup.mapped) {
-        GList *it;
-
-        for (it = popup.targets; it; it = g_list_next(it)) {
-            ObFocusCyclePopupTarget *t = it->data;
-            if (t->client == c)
-                return TRUE;
-        }
-    }
-    return FALSE;
-}
-
 static ObClient* popup_revert(ObClient *target)
 {
     GList *it, *itt;
@@ -823,15 +801,14 @@ static ObClient* popup_revert(ObClient *target)
 }
 
 ObClient* focus_cycle_popup_refresh(ObClient *target,
-                                    gboolean redraw,
-                                    gboolean linear)
+                                    gboolean redraw)
 {
     if (!popup.mapped) return NULL;
 
     if (!focus_cycle_valid(target))
         target = popup_revert(target);
 
-    redraw = popup_setup(&popup, TRUE, TRUE, linear) && redraw;
+    redraw = popup_setup(&popup, TRUE, TRUE) && redraw;
 
     if (!target && popup.targets)
         target = ((ObFocusCyclePopupTarget*)popup.targets->data)->client;
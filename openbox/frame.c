@@ -24,10 +24,12 @@
 #include "debug.h"
 #include "config.h"
 #include "framerender.h"
+#include "event.h"
 #include "focus_cycle.h"
 #include "focus_cycle_indicator.h"
 #include "moveresize.h"
 #include "screen.h"
+#include "animate.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
@@ -41,17 +43,18 @@
                            EnterWindowMask | LeaveWindowMask)
 
 #define FRAME_ANIMATE_ICONIFY_TIME 150000 /* .15 seconds */
-#define FRAME_ANIMATE_ICONIFY_STEP_TIME (1000 / 60) /* 60 Hz */
+#define FRAME_FLASH_TIME 600 /* .6 seconds */
 
 #define FRAME_HANDLE_Y(f) (f->size.top + f->client->area.height + f->cbwidth_b)
 
 static void flash_done(gpointer data);
-static gboolean flash_timeout(gpointer data);
+static void frame_render_deferred(gpointer data);
+static gboolean flash_timeout(gint64 now, gpointer data);
 
 static void layout_title(ObFrame *self);
 static void set_theme_statics(ObFrame *self);
 static void free_theme_statics(ObFrame *self);
-static gboolean frame_animate_iconify(gpointer self);
+static gboolean frame_animate_iconify(gint64 now, gpointer self);
 static void frame_adjust_cursors(ObFrame *self);
 
 static Window createWindow(Window parent, Visual *visual,
@@ -110,6 +113,7 @@ ObFrame *frame_new(ObClient *client)
     }
     self->window = createWindow(obt_root(ob_screen), visual,
                                 mask, &attrib);
+    self->parent = obt_root(ob_screen);
 
     /* create the visible decor windows */
 
@@ -228,6 +232,7 @@ static void free_theme_statics(ObFrame *self)
 
 void frame_free(ObFrame *self)
 {
+    event_cancel_defer(frame_render_deferred, self);
     free_theme_statics(self);
 
     XDestroyWindow(obt_display, self->window);
@@ -242,20 +247,26 @@ void frame_show(ObFrame *self)
     if (!self->visible) {
         self->visible = TRUE;
         framerender_frame(self);
-        /* Grab the server to make sure that the frame window is mapped before
-           the client gets its MapNotify, i.e. to make sure the client is
-           _visible_ when it gets MapNotify. */
-        grab_server(TRUE);
-        XMapWindow(obt_display, self->client->window);
-        XMapWindow(obt_display, self->window);
-        grab_server(FALSE);
+        /* a frame that was only hidden with its desktop's container is
+           still mapped, with the client window in it */
+        if (!self->mapped) {
+            self->mapped = TRUE;
+            /* Grab the server to make sure that the frame window is mapped
+               before the client gets its MapNotify, i.e. to make sure the
+               client is _visible_ when it gets MapNotify. */
+            grab_server(TRUE);
+            XMapWindow(obt_display, self->client->window);
+            XMapWindow(obt_display, self->window);
+            grab_server(FALSE);
+        }
     }
 }
 
 void frame_hide(ObFrame *self)
 {
-    if (self->visible) {
-        self->visible = FALSE;
+    self->visible = FALSE;
+    if (self->mapped) {
+        self->mapped = FALSE;
         if (!frame_iconify_animating(self))
             XUnmapWindow(obt_display, self->window);
         /* we unmap the client itself so that we can get MapRequest
@@ -265,6 +276,35 @@ void frame_hide(ObFrame *self)
     }
 }
 
+void frame_hide_in_container(ObFrame *self)
+{
+    self->visible = FALSE;
+    /* the container isn't shown, so the windows in it can be mapped the
+       same as on the current desktop.  this is only needed for windows
+       that were never shown, or were iconified */
+    if (!self->mapped) {
+        self->mapped = TRUE;
+        XMapWindow(obt_display, self->client->window);
+        XMapWindow(obt_display, self->window);
+    }
+}
+
+gboolean frame_adjust_parent(ObFrame *self)
+{
+    Window parent;
+
+    /* windows on all desktops go in the current desktop's container */
+    parent = screen_container(self->client->desktop);
+    if (parent == self->parent) return FALSE;
+
+    /* the containers cover the screen at 0,0 so the position stays the
+       same */
+    XReparentWindow(obt_display, self->window, parent,
+                    self->area.x, self->area.y);
+    self->parent = parent;
+    return TRUE;
+}
+
 void frame_adjust_theme(ObFrame *self)
 {
     free_theme_statics(self);
@@ -885,6 +925,9 @@ void frame_adjust_area(ObFrame *self, gboolean moved,
         XResizeWindow(obt_display, self->label, self->label_width,
                       ob_rr_theme->label_height);
     }
+
+    /* the frame's edges are searched from its area */
+    client_edges_changed(self->client);
 }
 
 static void frame_adjust_cursors(ObFrame *self)
@@ -960,10 +1003,16 @@ void frame_adjust_client_area(ObFrame *self)
                       self->client->area.height);
 }
 
+static void frame_render_deferred(gpointer data)
+{
+    framerender_frame(data);
+}
+
 void frame_adjust_state(ObFrame *self)
 {
+    /* a client's state often changes a few times in a row */
     self->need_render = TRUE;
-    framerender_frame(self);
+    event_defer(frame_render_deferred, self);
 }
 
 void frame_adjust_focus(ObFrame *self, gboolean hilite)
@@ -980,13 +1029,13 @@ void frame_adjust_focus(ObFrame *self, gboolean hilite)
 void frame_adjust_title(ObFrame *self)
 {
     self->need_render = TRUE;
-    framerender_frame(self);
+    event_defer(frame_render_deferred, self);
 }
 
 void frame_adjust_icon(ObFrame *self)
 {
     self->need_render = TRUE;
-    framerender_frame(self);
+    event_defer(frame_render_deferred, self);
 }
 
 void frame_grab_client(ObFrame *self)
@@ -1074,7 +1123,7 @@ void frame_release_client(ObFrame *self)
 {
     /* if there was any animation going on, kill it */
     if (self->iconify_animation_timer)
-        g_source_remove(self->iconify_animation_timer);
+        animate_remove(self->iconify_animation_timer);
 
     /* check if the app has already reparented its window away */
     if (!xqueue_exists_local(find_reparent, self)) {
@@ -1131,7 +1180,7 @@ void frame_release_client(ObFrame *self)
     window_remove(self->rgriptop);
     window_remove(self->rgripbottom);
 
-    if (self->flash_timer) g_source_remove(self->flash_timer);
+    if (self->flash_timer) animate_remove(self->flash_timer);
 }
 
 /* is there anything present between us and the label? */
@@ -1667,15 +1716,11 @@ static void flash_done(gpointer data)
     self->flash_timer = 0;
 }
 
-static gboolean flash_timeout(gpointer data)
+static gboolean flash_timeout(gint64 now, gpointer data)
 {
     ObFrame *self = data;
-    GTimeVal now;
 
-    g_get_current_time(&now);
-    if (now.tv_sec > self->flash_end.tv_sec ||
-        (now.tv_sec == self->flash_end.tv_sec &&
-         now.tv_usec >= self->flash_end.tv_usec))
+    if (now >= self->flash_end)
         self->flashing = FALSE;
 
     if (!self->flashing) {
@@ -1699,11 +1744,9 @@ void frame_flash_start(ObFrame *self)
     self->flash_on = self->focused;
 
     if (!self->flashing)
-        self->flash_timer = g_timeout_add_full(G_PRIORITY_DEFAULT,
-                                               600, flash_timeout, self,
-                                               flash_done);
-    g_get_current_time(&self->flash_end);
-    g_time_val_add(&self->flash_end, G_USEC_PER_SEC * 5);
+        self->flash_timer = animate_add(FRAME_FLASH_TIME, flash_timeout, self,
+                                        flash_done);
+    self->flash_end = animate_time() + G_USEC_PER_SEC * 5;
 
     self->flashing = TRUE;
 }
@@ -1713,26 +1756,17 @@ void frame_flash_stop(ObFrame *self)
     self->flashing = FALSE;
 }
 
-static gulong frame_animate_iconify_time_left(ObFrame *self,
-                                              const GTimeVal *now)
+static gulong frame_animate_iconify_time_left(ObFrame *self, gint64 now)
 {
-    glong sec, usec;
-    sec = self->iconify_animation_end.tv_sec - now->tv_sec;
-    usec = self->iconify_animation_end.tv_usec - now->tv_usec;
-    if (usec < 0) {
-        usec += G_USEC_PER_SEC;
-        sec--;
-    }
     /* no negative values */
-    return MAX(sec * G_USEC_PER_SEC + usec, 0);
+    return MAX(self->iconify_animation_end - now, 0);
 }
 
-static gboolean frame_animate_iconify(gpointer p)
+static gboolean frame_animate_iconify(gint64 now, gpointer p)
 {
     ObFrame *self = p;
     gint x, y, w, h;
     gint iconx, icony, iconw;
-    GTimeVal now;
     gulong time;
     gboolean iconifying;
 
@@ -1753,8 +1787,7 @@ static gboolean frame_animate_iconify(gpointer p)
     iconifying = self->iconify_animation_going > 0;
 
     /* how far do we have left to go ? */
-    g_get_current_time(&now);
-    time = frame_animate_iconify_time_left(self, &now);
+    time = frame_animate_iconify_time_left(self, now);
 
     if ((time > 0 && iconifying) || (time == 0 && !iconifying)) {
         /* start where the frame is supposed to be */
@@ -1788,7 +1821,6 @@ static gboolean frame_animate_iconify(gpointer p)
     }
 
     XMoveResizeWindow(obt_display, self->window, x, y, w, h);
-    XFlush(obt_display);
 
     return time > 0; /* repeat until we're out of time */
 }
@@ -1799,7 +1831,7 @@ void frame_end_iconify_animation(gpointer data)
     /* see if there is an animation going */
     if (self->iconify_animation_going == 0) return;
 
-    if (!self->visible)
+    if (!self->mapped)
         XUnmapWindow(obt_display, self->window);
     else {
         /* Send a ConfigureNotify when the animation is done, this fixes
@@ -1812,7 +1844,13 @@ void frame_end_iconify_animation(gpointer data)
 
     /* we're not animating any more ! */
     self->iconify_animation_going = 0;
-    self->iconify_animation_timer = 0;
+    if (self->iconify_animation_timer) {
+        guint id = self->iconify_animation_timer;
+
+        /* if the animation was ended early, stop it from stepping again */
+        self->iconify_animation_timer = 0;
+        animate_remove(id);
+    }
 
     XMoveResizeWindow(obt_display, self->window,
                       self->area.x, self->area.y,
@@ -1827,7 +1865,7 @@ void frame_begin_iconify_animation(ObFrame *self, gboolean iconifying)
     gulong time;
     gboolean new_anim = FALSE;
     gboolean set_end = TRUE;
-    GTimeVal now;
+    gint64 now;
 
     /* if there is no titlebar, just don't animate for now
        XXX it would be nice tho.. */
@@ -1835,14 +1873,14 @@ void frame_begin_iconify_animation(ObFrame *self, gboolean iconifying)
         return;
 
     /* get the current time */
-    g_get_current_time(&now);
+    now = animate_time();
 
     /* get how long until the end */
     time = FRAME_ANIMATE_ICONIFY_TIME;
     if (self->iconify_animation_going) {
         if (!!iconifying != (self->iconify_animation_going > 0)) {
             /* animation was already going on in the opposite direction */
-            time = time - frame_animate_iconify_time_left(self, &now);
+            time = time - frame_animate_iconify_time_left(self, now);
         } else
             /* animation was already going in the same direction */
             set_end = FALSE;
@@ -1851,27 +1889,22 @@ void frame_begin_iconify_animation(ObFrame *self, gboolean iconifying)
     self->iconify_animation_going = iconifying ? 1 : -1;
 
     /* set the ending time */
-    if (set_end) {
-        self->iconify_animation_end.tv_sec = now.tv_sec;
-        self->iconify_animation_end.tv_usec = now.tv_usec;
-        g_time_val_add(&self->iconify_animation_end, time);
-    }
+    if (set_end)
+        self->iconify_animation_end = now + time;
 
     if (new_anim) {
         if (self->iconify_animation_timer)
-            g_source_remove(self->iconify_animation_timer);
+            animate_remove(self->iconify_animation_timer);
+        /* step it on every tick */
         self->iconify_animation_timer =
-            g_timeout_add_full(G_PRIORITY_DEFAULT,
-                               FRAME_ANIMATE_ICONIFY_STEP_TIME,
-                               frame_animate_iconify, self,
-                               frame_end_iconify_animation);
-                               
+            animate_add(0, frame_animate_iconify, self,
+                        frame_end_iconify_animation);
 
         /* do the first step */
-        frame_animate_iconify(self);
+        frame_animate_iconify(now, self);
 
         /* show it during the animation even if it is not "visible" */
-        if (!self->visible)
+        if (!self->mapped)
             XMapWindow(obt_display, self->window);
     }
 }
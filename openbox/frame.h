@@ -84,11 +84,18 @@ struct _ObFrame
     struct _ObClient *client;
 
     Window    window;
+    /*! The window that the frame is a child of, the root window or a
+      desktop container */
+    Window    parent;
 
     Strut     size;    /* the size of the frame */
     Strut     oldsize; /* the size of the frame last told to the client */
     Rect      area;
     gboolean  visible;
+    /*! The frame and client windows are mapped.  This differs from visible
+      when the frame is hidden in the unmapped container for its desktop,
+      where they both stay mapped. */
+    gboolean  mapped;
 
     guint     functions;
     guint     decorations;
@@ -191,7 +198,7 @@ struct _ObFrame
 
     gboolean  flashing;
     gboolean  flash_on;
-    GTimeVal  flash_end;
+    gint64    flash_end;
     guint     flash_timer;
 
     /*! Is the frame currently in an animation for iconify or restore.
@@ -200,7 +207,7 @@ struct _ObFrame
     */
     gint iconify_animation_going;
     guint iconify_animation_timer;
-    GTimeVal  iconify_animation_end;
+    gint64    iconify_animation_end;
 };
 
 ObFrame *frame_new(struct _ObClient *c);
@@ -208,6 +215,13 @@ void frame_free(ObFrame *self);
 
 void frame_show(ObFrame *self);
 void frame_hide(ObFrame *self);
+/*! Mark the frame as hidden while keeping it mapped, for when its desktop's
+  container is not shown */
+void frame_hide_in_container(ObFrame *self);
+/*! Move the frame into the container for the client's desktop, or the
+  current desktop's for windows on all desktops.  Returns TRUE if it was
+  moved, in which case the stacking order needs to be refreshed. */
+gboolean frame_adjust_parent(ObFrame *self);
 void frame_adjust_theme(ObFrame *self);
 #ifdef SHAPE
 void frame_adjust_shape_kind(ObFrame *self, int kind);
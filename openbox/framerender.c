@@ -31,6 +31,7 @@ static void framerender_iconify(ObFrame *self, RrAppearance *a);
 static void framerender_desk(ObFrame *self, RrAppearance *a);
 static void framerender_shade(ObFrame *self, RrAppearance *a);
 static void framerender_close(ObFrame *self, RrAppearance *a);
+static void framerender_button(RrAppearance *a, Window win);
 
 void framerender_frame(ObFrame *self)
 {
@@ -381,32 +382,42 @@ static void framerender_icon(ObFrame *self, RrAppearance *a)
 static void framerender_max(ObFrame *self, RrAppearance *a)
 {
     if (!self->max_on) return;
-    RrPaint(a, self->max, ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_button(a, self->max);
 }
 
 static void framerender_iconify(ObFrame *self, RrAppearance *a)
 {
     if (!self->iconify_on) return;
-    RrPaint(a, self->iconify,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_button(a, self->iconify);
 }
 
 static void framerender_desk(ObFrame *self, RrAppearance *a)
 {
     if (!self->desk_on) return;
-    RrPaint(a, self->desk, ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_button(a, self->desk);
 }
 
 static void framerender_shade(ObFrame *self, RrAppearance *a)
 {
     if (!self->shade_on) return;
-    RrPaint(a, self->shade,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_button(a, self->shade);
 }
 
 static void framerender_close(ObFrame *self, RrAppearance *a)
 {
     if (!self->close_on) return;
-    RrPaint(a, self->close,
-            ob_rr_theme->button_size, ob_rr_theme->button_size);
+    framerender_button(a, self->close);
+}
+
+static void framerender_button(RrAppearance *a, Window win)
+{
+    Pixmap p;
+
+    /* use the button that the theme drew ahead of time if it has one */
+    if ((p = RrThemeButtonPixmap(ob_rr_theme, a))) {
+        XSetWindowBackgroundPixmap(obt_display, win, p);
+        XClearWindow(obt_display, win);
+    }
+    else
+        RrPaint(a, win, ob_rr_theme->button_size, ob_rr_theme->button_size);
 }
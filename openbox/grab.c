@@ -41,6 +41,8 @@ static guint pgrabs = 0;
 static Time  grab_time = CurrentTime;
 static gint passive_count = 0;
 static ObtIC *ic = NULL;
+/*! The number of requests made to grab and ungrab keys and buttons */
+static guint grab_requests = 0;
 
 static Time ungrab_time(void)
 {
@@ -172,6 +174,18 @@ void grab_startup(gboolean reconfig)
     ic = obt_keyboard_context_new(obt_root(ob_screen), grab_window());
 }
 
+guint grab_lock_masks(void)
+{
+    /* the modifier masks all fit in a byte, and these three have each of
+       the lock masks on their own */
+    return mask_list[1] | mask_list[2] << 8 | mask_list[3] << 16;
+}
+
+guint grab_request_count(void)
+{
+    return grab_requests;
+}
+
 void grab_shutdown(gboolean reconfig)
 {
     obt_keyboard_context_unref(ic);
@@ -194,6 +208,7 @@ void grab_button_full(guint button, guint state, Window win, guint mask,
     for (i = 0; i < MASK_LIST_SIZE; ++i)
         XGrabButton(obt_display, button, state | mask_list[i], win, False,
                     mask, pointer_mode, GrabModeAsync, None, ob_cursor(cur));
+    grab_requests += MASK_LIST_SIZE;
     obt_display_ignore_errors(FALSE);
     if (obt_display_error_occured)
         ob_debug("Failed to grab button %d modifiers %d", button, state);
@@ -205,6 +220,13 @@ void ungrab_button(guint button, guint state, Window win)
 
     for (i = 0; i < MASK_LIST_SIZE; ++i)
         XUngrabButton(obt_display, button, state | mask_list[i], win);
+    grab_requests += MASK_LIST_SIZE;
+}
+
+void ungrab_all_buttons(Window win)
+{
+    XUngrabButton(obt_display, AnyButton, AnyModifier, win);
+    ++grab_requests;
 }
 
 void grab_key(guint keycode, guint state, Window win, gint keyboard_mode)
@@ -216,14 +238,25 @@ void grab_key(guint keycode, guint state, Window win, gint keyboard_mode)
     for (i = 0; i < MASK_LIST_SIZE; ++i)
         XGrabKey(obt_display, keycode, state | mask_list[i], win, FALSE,
                  GrabModeAsync, keyboard_mode);
+    grab_requests += MASK_LIST_SIZE;
     obt_display_ignore_errors(FALSE);
     if (obt_display_error_occured)
         ob_debug("Failed to grab keycode %d modifiers %d", keycode, state);
 }
 
+void ungrab_key(guint keycode, guint state, Window win)
+{
+    guint i;
+
+    for (i = 0; i < MASK_LIST_SIZE; ++i)
+        XUngrabKey(obt_display, keycode, state | mask_list[i], win);
+    grab_requests += MASK_LIST_SIZE;
+}
+
 void ungrab_all_keys(Window win)
 {
     XUngrabKey(obt_display, AnyKey, AnyModifier, win);
+    ++grab_requests;
 }
 
 void grab_key_passive_count(int change)
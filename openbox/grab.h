@@ -30,6 +30,13 @@ void grab_shutdown(gboolean reconfig);
 
 ObtIC *grab_input_context(void);
 
+/*! The lock masks (NumLock, CapsLock and ScrollLock) that every key and
+  button grab is also made with, each in its own byte.  This changes when
+  any of the masks does, even if the locks only swap their modifiers. */
+guint grab_lock_masks(void);
+/*! The number of key and button grab and ungrab requests made so far */
+guint grab_request_count(void);
+
 gboolean grab_keyboard_full(gboolean grab);
 /*! @param confine If true the pointer is confined to the screen */
 gboolean grab_pointer_full(gboolean grab, gboolean owner_events,
@@ -47,8 +54,10 @@ gboolean grab_on_pointer(void);
 void grab_button_full(guint button, guint state, Window win, guint mask,
                       gint pointer_mode, ObCursor cursor);
 void ungrab_button(guint button, guint state, Window win);
+void ungrab_all_buttons(Window win);
 
 void grab_key(guint keycode, guint state, Window win, gint keyboard_mode);
+void ungrab_key(guint keycode, guint state, Window win);
 
 void ungrab_all_keys(Window win);
 
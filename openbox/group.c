@@ -21,9 +21,6 @@
 
 static GHashTable *group_map;
 
-static guint window_hash(Window *w) { return *w; }
-static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
-
 void group_startup(gboolean reconfig)
 {
     if (reconfig) return;
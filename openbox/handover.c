@@ -0,0 +1,204 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   handover.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "handover.h"
+#include "client.h"
+#include "focus.h"
+#include "stacking.h"
+#include "window.h"
+#include "debug.h"
+#include "gettext.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+/*! The environment variable that gives the new process the file's name */
+#define HANDOVER_ENV "OPENBOX_RESTART_STATE"
+/*! The first line of the file, which changes if the format does */
+#define HANDOVER_MAGIC "openbox-restart 1"
+
+typedef struct _ObHandover ObHandover;
+
+struct _ObHandover {
+    Window window;
+    gint focus;  /* its place in the focus order, 0 is the first, and -1
+                    if it is not in the focus order */
+    Rect pre_max_area;
+    Rect pre_fullscreen_area;
+};
+
+/*! The handed over clients, from the top of the stacking order down */
+static GArray *handed = NULL;
+
+void handover_save(void)
+{
+    GString *s;
+    GHashTable *focus_pos;
+    GList *it;
+    GError *err = NULL;
+    gchar *path;
+    gint fd, i;
+
+    /* the clients' places in the focus order, plus one so that the ones
+       which aren't in it can be told apart from the first one */
+    focus_pos = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (i = 0, it = focus_order; it; ++i, it = g_list_next(it))
+        g_hash_table_insert(focus_pos, it->data, GINT_TO_POINTER(i + 1));
+
+    s = g_string_new(HANDOVER_MAGIC "\n");
+    for (it = stacking_list; it; it = g_list_next(it)) {
+        ObClient *c;
+        const Rect *m, *f;
+
+        if (!WINDOW_IS_CLIENT(it->data)) continue;
+        c = it->data;
+        m = &c->pre_max_area;
+        f = &c->pre_fullscreen_area;
+
+        g_string_append_printf(s, "%lu %d %d %d %d %d %d %d %d %d\n",
+                               c->window,
+                               GPOINTER_TO_INT(g_hash_table_lookup(focus_pos,
+                                                                   c)) - 1,
+                               m->x, m->y, m->width, m->height,
+                               f->x, f->y, f->width, f->height);
+    }
+    g_hash_table_destroy(focus_pos);
+
+    if ((fd = g_file_open_tmp("openbox-restart-XXXXXX", &path, &err)) < 0) {
+        g_message(_("Unable to save the state for restarting: %s"),
+                  err->message);
+        g_error_free(err);
+    }
+    else {
+        close(fd);
+        if (g_file_set_contents(path, s->str, s->len, &err))
+            g_setenv(HANDOVER_ENV, path, TRUE);
+        else {
+            g_message(_("Unable to save the state for restarting: %s"),
+                      err->message);
+            g_error_free(err);
+            unlink(path);
+        }
+        g_free(path);
+    }
+    g_string_free(s, TRUE);
+}
+
+void handover_load(void)
+{
+    const gchar *path;
+    gchar *contents, **lines;
+    guint i;
+
+    if (!(path = g_getenv(HANDOVER_ENV))) return;
+
+    if (g_file_get_contents(path, &contents, NULL, NULL)) {
+        lines = g_strsplit(contents, "\n", -1);
+        g_free(contents);
+
+        if (lines[0] && !strcmp(lines[0], HANDOVER_MAGIC)) {
+            handed = g_array_new(FALSE, FALSE, sizeof(ObHandover));
+            for (i = 1; lines[i]; ++i) {
+                ObHandover h;
+                gulong w;
+                Rect *m = &h.pre_max_area, *f = &h.pre_fullscreen_area;
+
+                if (sscanf(lines[i], "%lu %d %d %d %d %d %d %d %d %d",
+                           &w, &h.focus,
+                           &m->x, &m->y, &m->width, &m->height,
+                           &f->x, &f->y, &f->width, &f->height) == 10)
+                {
+                    h.window = w;
+                    g_array_append_val(handed, h);
+                }
+            }
+            ob_debug("Handed %u windows over from before restarting",
+                     handed->len);
+        }
+        g_strfreev(lines);
+    }
+
+    /* it is only used once, and not by anything that we run */
+    unlink(path);
+    g_unsetenv(HANDOVER_ENV);
+}
+
+static ObClient* handed_client(const ObHandover *h)
+{
+    ObWindow *w = window_find(h->window);
+
+    /* only the windows that are still there and were managed again */
+    return w && WINDOW_IS_CLIENT(w) ? WINDOW_AS_CLIENT(w) : NULL;
+}
+
+static gint focus_cmp(gconstpointer a, gconstpointer b, gpointer data)
+{
+    /* the clients that weren't handed over go after the ones that were */
+    gint fa = GPOINTER_TO_INT(g_hash_table_lookup(data, a)) - 1;
+    gint fb = GPOINTER_TO_INT(g_hash_table_lookup(data, b)) - 1;
+
+    if (fa < 0) fa = G_MAXINT;
+    if (fb < 0) fb = G_MAXINT;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+void handover_restore(void)
+{
+    GHashTable *focus_pos;
+    guint i, n = 0;
+
+    if (!handed) return;
+
+    focus_pos = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    /* raising them from the bottom up leaves them in the order that they
+       were in, inside of each layer */
+    for (i = handed->len; i > 0; --i) {
+        ObHandover *h = &g_array_index(handed, ObHandover, i - 1);
+        ObClient *c;
+
+        if (!(c = handed_client(h))) continue;
+        ++n;
+
+        stacking_raise(CLIENT_AS_WINDOW(c));
+        if (h->focus >= 0)
+            g_hash_table_insert(focus_pos, c, GINT_TO_POINTER(h->focus + 1));
+
+        /* managing a maximized or fullscreen window can only guess where it
+           should go back to */
+        if ((c->max_horz || c->max_vert) &&
+            h->pre_max_area.width > 0 && h->pre_max_area.height > 0)
+            c->pre_max_area = h->pre_max_area;
+        if (c->fullscreen &&
+            h->pre_fullscreen_area.width > 0 &&
+            h->pre_fullscreen_area.height > 0)
+            c->pre_fullscreen_area = h->pre_fullscreen_area;
+    }
+
+    /* the sort is stable, so anything new keeps its order at the end */
+    focus_order = g_list_sort_with_data(focus_order, focus_cmp, focus_pos);
+    g_hash_table_destroy(focus_pos);
+
+    ob_debug("Restored %u of %u windows from before restarting",
+             n, handed->len);
+
+    g_array_free(handed, TRUE);
+    handed = NULL;
+}
@@ -0,0 +1,45 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   handover.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __handover_h
+#define __handover_h
+
+#include <glib.h>
+
+/*! When openbox restarts itself, the state which isn't kept on the client
+  windows is handed to the new process in a file.  That is the stacking
+  order, the focus order, and where maximized and fullscreen windows go back
+  to.  The rest, like the desktops and the _NET_WM_STATE, the new process
+  reads from the windows as it manages them.
+
+  This does not keep the frames.  Every client is still unmanaged before the
+  restart and managed again by the new process, and only the order and the
+  saved areas are put back afterward. */
+
+/*! Write the state of the managed clients to a file for the new process.
+  Call this before the clients are unmanaged. */
+void handover_save(void);
+
+/*! Read the state that the process which restarted us handed over, if
+  there is any */
+void handover_load(void);
+
+/*! Put the clients back the way they were before the restart, after they
+  have all been managed again.  This frees the handed over state. */
+void handover_restore(void);
+
+#endif
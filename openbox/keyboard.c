@@ -33,6 +33,7 @@
 #include "moveresize.h"
 #include "popup.h"
 #include "gettext.h"
+#include "debug.h"
 #include "obt/keyboard.h"
 
 #include <glib.h>
@@ -41,26 +42,71 @@ KeyBindingTree *keyboard_firstnode = NULL;
 static ObPopup *popup = NULL;
 static KeyBindingTree *curpos;
 static guint chain_timer = 0;
+/*! The keys that are grabbed on the root window, keyed by their keycode |
+  their state << 8 */
+static GHashTable *grabbed_keys = NULL;
+/*! The lock masks that the keys were grabbed with */
+static guint grabbed_locks;
 
-static void grab_keys(gboolean grab)
+#define GRABBED_KEY(code, state) GUINT_TO_POINTER((code) | (state) << 8)
+#define GRABBED_KEY_CODE(k) (GPOINTER_TO_UINT(k) & 0xff)
+#define GRABBED_KEY_STATE(k) (GPOINTER_TO_UINT(k) >> 8)
+
+static void want_key(GHashTable *want, guint keycode, guint state)
 {
+    if (keycode) {
+        gpointer k = GRABBED_KEY(keycode, state);
+        g_hash_table_insert(want, k, k);
+    }
+}
+
+/*! Grab the keys that can be pressed next in the current chain, only
+  grabbing and ungrabbing the ones that are different from what was
+  grabbed before */
+static void grab_keys(const gchar *why)
+{
+    GHashTable *want;
+    GHashTableIter iter;
+    gpointer k;
     KeyBindingTree *p;
+    Window root = obt_root(ob_screen);
+    guint requests = grab_request_count();
+
+    want = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (p = curpos ? curpos->first_child : keyboard_firstnode; p;
+         p = p->next_sibling)
+        want_key(want, p->key, p->state);
+    if (curpos)
+        want_key(want, config_keyboard_reset_keycode,
+                 config_keyboard_reset_state);
+
+    if (grabbed_keys && grabbed_locks == grab_lock_masks()) {
+        g_hash_table_iter_init(&iter, grabbed_keys);
+        while (g_hash_table_iter_next(&iter, &k, NULL))
+            if (!g_hash_table_lookup(want, k))
+                ungrab_key(GRABBED_KEY_CODE(k), GRABBED_KEY_STATE(k), root);
+    }
+    else {
+        /* the old grabs were made with different lock masks, so they can't
+           be ungrabbed one at a time */
+        ungrab_all_keys(root);
+        if (grabbed_keys)
+            g_hash_table_remove_all(grabbed_keys);
+        grabbed_locks = grab_lock_masks();
+    }
 
-    ungrab_all_keys(obt_root(ob_screen));
+    g_hash_table_iter_init(&iter, want);
+    while (g_hash_table_iter_next(&iter, &k, NULL))
+        if (!grabbed_keys || !g_hash_table_lookup(grabbed_keys, k))
+            grab_key(GRABBED_KEY_CODE(k), GRABBED_KEY_STATE(k), root,
+                     GrabModeAsync);
 
-    if (grab) {
-        p = curpos ? curpos->first_child : keyboard_firstnode;
-        while (p) {
-            if (p->key)
-                grab_key(p->key, p->state, obt_root(ob_screen),
-                         GrabModeAsync);
-            p = p->next_sibling;
-        }
-        if (curpos)
-            grab_key(config_keyboard_reset_keycode,
-                     config_keyboard_reset_state,
-                     obt_root(ob_screen), GrabModeAsync);
-    }
+    if (grabbed_keys)
+        g_hash_table_destroy(grabbed_keys);
+    grabbed_keys = want;
+
+    ob_debug("Grabbing keys for %s used %u requests",
+             why, grab_request_count() - requests);
 }
 
 static gboolean chain_timeout(gpointer data)
@@ -78,9 +124,8 @@ static void set_curpos(KeyBindingTree *newpos)
 {
     if (curpos == newpos) return;
 
-    grab_keys(FALSE);
     curpos = newpos;
-    grab_keys(TRUE);
+    grab_keys("a key chain");
 
     if (curpos != NULL) {
         gchar *text = NULL;
@@ -318,12 +363,12 @@ void keyboard_rebind(void)
 
     tree_destroy(old);
     set_curpos(NULL);
-    grab_keys(TRUE);
+    grab_keys("rebinding");
 }
 
 void keyboard_startup(gboolean reconfig)
 {
-    grab_keys(TRUE);
+    grab_keys("the key bindings");
     popup = popup_new();
     popup_set_text_align(popup, RR_JUSTIFY_CENTER);
 }
@@ -335,6 +380,16 @@ void keyboard_shutdown(gboolean reconfig)
     keyboard_unbind_all();
     set_curpos(NULL);
 
+    /* when reconfiguring, the grabs are kept and only the ones that changed
+       are grabbed or ungrabbed at startup */
+    if (!reconfig) {
+        ungrab_all_keys(obt_root(ob_screen));
+        if (grabbed_keys) {
+            g_hash_table_destroy(grabbed_keys);
+            grabbed_keys = NULL;
+        }
+    }
+
     popup_free(popup);
     popup = NULL;
 }
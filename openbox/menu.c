@@ -37,33 +37,37 @@
 #include "obt/xml.h"
 #include "obt/paths.h"
 
+#include <string.h>
+
 typedef struct _ObMenuParseState ObMenuParseState;
 
 struct _ObMenuParseState
 {
     ObMenu *parent;
     ObMenu *pipe_creator;
+    GSList *parents; /* the parent outside of each open <menu> */
 };
 
 static GHashTable *menu_hash = NULL;
 static ObtXmlInst *menu_parse_inst;
 static ObMenuParseState menu_parse_state;
+static gboolean menu_files_loaded = FALSE;
 static gboolean menu_can_hide = FALSE;
 static guint menu_timeout_id = 0;
 
 static void menu_destroy_hash_value(ObMenu *self);
+static void menu_filter_forget(ObMenu *self);
+static void menu_load_files(void);
 static void parse_menu_item(xmlNodePtr node, gpointer data);
 static void parse_menu_separator(xmlNodePtr node, gpointer data);
-static void parse_menu(xmlNodePtr node, gpointer data);
+static gboolean parse_menu_open(xmlNodePtr node, gpointer data);
+static void parse_menu_close(xmlNodePtr node, gpointer data);
 static gunichar parse_shortcut(const gchar *label, gboolean allow_shortcut,
                                gchar **strippedlabel, guint *position,
                                gboolean *always_show);
 
 void menu_startup(gboolean reconfig)
 {
-    gboolean loaded = FALSE;
-    GSList *it;
-
     menu_hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
                                       (GDestroyNotify)menu_destroy_hash_value);
 
@@ -75,48 +79,56 @@ void menu_startup(gboolean reconfig)
 
     menu_parse_state.parent = NULL;
     menu_parse_state.pipe_creator = NULL;
-    obt_xml_register(menu_parse_inst, "menu", parse_menu, &menu_parse_state);
+    menu_parse_state.parents = NULL;
+    obt_xml_register_container(menu_parse_inst, "menu",
+                               parse_menu_open, parse_menu_close,
+                               &menu_parse_state);
     obt_xml_register(menu_parse_inst, "item", parse_menu_item,
                      &menu_parse_state);
     obt_xml_register(menu_parse_inst, "separator",
                        parse_menu_separator, &menu_parse_state);
 
+    /* the menu files are not read until a menu is shown, so that they
+       don't hold up starting openbox */
+    menu_files_loaded = FALSE;
+}
+
+/*! Read the menus from the menu files, the first time that one is needed */
+static void menu_load_files(void)
+{
+    gboolean loaded = FALSE;
+    GSList *it;
+
+    if (menu_files_loaded) return;
+    menu_files_loaded = TRUE;
+
     for (it = config_menu_files; it; it = g_slist_next(it)) {
-        if (obt_xml_load_config_file(menu_parse_inst,
-                                     "openbox",
+        /* menus are streamed, so that large generated menus are never held
+           in memory as a whole document */
+        if (obt_xml_stream_config_file(menu_parse_inst,
+                                       "openbox",
+                                       it->data,
+                                       "openbox_menu"))
+            loaded = TRUE;
+        else if (obt_xml_stream_file(menu_parse_inst,
                                      it->data,
                                      "openbox_menu"))
-        {
-            loaded = TRUE;
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        }
-        else if (obt_xml_load_file(menu_parse_inst,
-                                   it->data,
-                                   "openbox_menu"))
-        {
             loaded = TRUE;
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        }
         else
             g_message(_("Unable to find a valid menu file \"%s\""),
                       (const gchar*)it->data);
     }
     if (!loaded) {
-        if (obt_xml_load_config_file(menu_parse_inst,
-                                     "openbox",
-                                     "menu.xml",
-                                     "openbox_menu"))
-        {
-            obt_xml_tree_from_root(menu_parse_inst);
-            obt_xml_close(menu_parse_inst);
-        } else
+        if (!obt_xml_stream_config_file(menu_parse_inst,
+                                        "openbox",
+                                        "menu.xml",
+                                        "openbox_menu"))
             g_message(_("Unable to find a valid menu file \"%s\""),
                       "menu.xml");
     }
 
     g_assert(menu_parse_state.parent == NULL);
+    g_assert(menu_parse_state.parents == NULL);
 }
 
 void menu_shutdown(gboolean reconfig)
@@ -171,16 +183,15 @@ void menu_pipe_execute(ObMenu *self)
         return;
     }
 
-    if (obt_xml_load_mem(menu_parse_inst, output, strlen(output),
-                         "openbox_pipe_menu"))
+    menu_parse_state.pipe_creator = self;
+    menu_parse_state.parent = self;
+    if (!obt_xml_stream_mem(menu_parse_inst, output, strlen(output),
+                            "openbox_pipe_menu"))
     {
-        menu_parse_state.pipe_creator = self;
-        menu_parse_state.parent = self;
-        obt_xml_tree_from_root(menu_parse_inst);
-        obt_xml_close(menu_parse_inst);
-    } else {
         g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
     }
+    menu_parse_state.pipe_creator = NULL;
+    menu_parse_state.parent = NULL;
 
     g_free(output);
 }
@@ -331,13 +342,15 @@ static void parse_menu_separator(xmlNodePtr node, gpointer data)
     }
 }
 
-static void parse_menu(xmlNodePtr node, gpointer data)
+static gboolean parse_menu_open(xmlNodePtr node, gpointer data)
 {
     ObMenuParseState *state = data;
     gchar *name = NULL, *title = NULL, *script = NULL;
     ObMenu *menu;
-    ObMenuEntry *e;
-    gchar *icon;
+    gboolean children = FALSE;
+
+    /* parse_menu_close puts this back once the menu's children are done */
+    state->parents = g_slist_prepend(state->parents, state->parent);
 
     if (!obt_xml_attr_string(node, "id", &name))
         goto parse_menu_fail;
@@ -351,17 +364,33 @@ static void parse_menu(xmlNodePtr node, gpointer data)
             if (obt_xml_attr_string(node, "execute", &script)) {
                 menu->execute = obt_paths_expand_tilde(script);
             } else {
-                ObMenu *old;
-
-                old = state->parent;
                 state->parent = menu;
-                obt_xml_tree(menu_parse_inst, node->children);
-                state->parent = old;
+                children = TRUE;
             }
         }
     }
 
-    if (state->parent) {
+parse_menu_fail:
+    g_free(name);
+    g_free(title);
+    g_free(script);
+    return children;
+}
+
+static void parse_menu_close(xmlNodePtr node, gpointer data)
+{
+    ObMenuParseState *state = data;
+    gchar *name = NULL;
+    ObMenuEntry *e;
+    gchar *icon;
+
+    state->parent = state->parents->data;
+    state->parents = g_slist_delete_link(state->parents, state->parents);
+
+    /* the menu exists if it was defined here or before */
+    if (state->parent && obt_xml_attr_string(node, "id", &name) &&
+        g_hash_table_lookup(menu_hash, name))
+    {
         e = menu_add_submenu(state->parent, -1, name);
 
         if (config_menu_show_icons &&
@@ -375,11 +404,7 @@ static void parse_menu(xmlNodePtr node, gpointer data)
             g_free(icon);
         }
     }
-
-parse_menu_fail:
     g_free(name);
-    g_free(title);
-    g_free(script);
 }
 
 ObMenu* menu_new(const gchar *name, const gchar *title,
@@ -464,6 +489,8 @@ void menu_show(gchar *name, const GravityPoint *pos, gint monitor,
     ObMenu *self;
     ObMenuFrame *frame;
 
+    menu_load_files();
+
     if (!(self = menu_from_name(name)) ||
         grab_on_keyboard() || grab_on_pointer()) return;
 
@@ -602,11 +629,13 @@ void menu_clear_entries(ObMenu *self)
         self->entries = g_list_delete_link(self->entries, self->entries);
     }
     self->more_menu->entries = self->entries; /* keep it in sync */
+    menu_filter_forget(self);
 }
 
 void menu_entry_remove(ObMenuEntry *self)
 {
     self->menu->entries = g_list_remove(self->menu->entries, self);
+    menu_filter_forget(self->menu);
     menu_entry_unref(self);
 }
 
@@ -622,6 +651,7 @@ ObMenuEntry* menu_add_normal(ObMenu *self, gint id, const gchar *label,
 
     self->entries = g_list_append(self->entries, e);
     self->more_menu->entries = self->entries; /* keep it in sync */
+    menu_filter_forget(self);
     return e;
 }
 
@@ -636,6 +666,14 @@ ObMenuEntry* menu_get_more(ObMenu *self, guint show_from)
     return e;
 }
 
+ObMenuEntry* menu_get_title(ObMenu *self, const gchar *label)
+{
+    ObMenuEntry *e;
+    e = menu_entry_new(self, OB_MENU_ENTRY_TYPE_SEPARATOR, -1);
+    menu_entry_set_label(e, label, FALSE);
+    return e;
+}
+
 ObMenuEntry* menu_add_submenu(ObMenu *self, gint id, const gchar *submenu)
 {
     ObMenuEntry *e;
@@ -645,6 +683,7 @@ ObMenuEntry* menu_add_submenu(ObMenu *self, gint id, const gchar *submenu)
 
     self->entries = g_list_append(self->entries, e);
     self->more_menu->entries = self->entries; /* keep it in sync */
+    menu_filter_forget(self);
     return e;
 }
 
@@ -734,6 +773,7 @@ void menu_entry_set_label(ObMenuEntry *self, const gchar *label,
         self->data.separator.label = g_strdup(label);
         break;
     case OB_MENU_ENTRY_TYPE_NORMAL:
+        menu_filter_forget(self->menu);
         g_free(self->data.normal.label);
         g_free(self->data.normal.collate_key);
         self->data.normal.shortcut =
@@ -748,6 +788,83 @@ void menu_entry_set_label(ObMenuEntry *self, const gchar *label,
     }
 }
 
+static void menu_filter_forget(ObMenu *self)
+{
+    if (self->filter_keys) {
+        g_hash_table_destroy(self->filter_keys);
+        self->filter_keys = NULL;
+    }
+    /* the More... menu has the same entries */
+    if (self->more_menu)
+        menu_filter_forget(self->more_menu);
+}
+
+static void menu_filter_index(ObMenu *self)
+{
+    GList *it;
+
+    if (self->filter_keys) return;
+
+    self->filter_keys = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                              NULL, g_free);
+    for (it = self->entries; it; it = g_list_next(it)) {
+        ObMenuEntry *e = it->data;
+        const gchar *label = NULL;
+
+        if (e->type == OB_MENU_ENTRY_TYPE_NORMAL)
+            label = e->data.normal.label;
+        else if (e->type == OB_MENU_ENTRY_TYPE_SUBMENU &&
+                 e->data.submenu.submenu)
+            label = e->data.submenu.submenu->title;
+
+        if (label)
+            g_hash_table_insert(self->filter_keys, e,
+                                g_utf8_casefold(label, -1));
+    }
+}
+
+static void filter_entry(ObMenu *self, ObMenuEntry *e, const gchar *text,
+                         GPtrArray *found)
+{
+    const gchar *key = g_hash_table_lookup(self->filter_keys, e);
+
+    if (key && strstr(key, text)) {
+        menu_entry_ref(e);
+        g_ptr_array_add(found, e);
+    }
+}
+
+GPtrArray* menu_filter(ObMenu *self, const gchar *text, GPtrArray *within)
+{
+    GPtrArray *found;
+    gchar *folded;
+
+    menu_filter_index(self);
+
+    folded = g_utf8_casefold(text, -1);
+    found = g_ptr_array_new();
+    if (within) {
+        guint i;
+
+        for (i = 0; i < within->len; ++i)
+            filter_entry(self, g_ptr_array_index(within, i), folded, found);
+    }
+    else {
+        GList *it;
+
+        for (it = self->entries; it; it = g_list_next(it))
+            filter_entry(self, it->data, folded, found);
+    }
+    g_free(folded);
+    return found;
+}
+
+void menu_filter_free(GPtrArray *found)
+{
+    g_ptr_array_foreach(found, (GFunc)menu_entry_unref, NULL);
+    g_ptr_array_free(found, TRUE);
+}
+
 void menu_show_all_shortcuts(ObMenu *self, gboolean show)
 {
     self->show_all_shortcuts = show;
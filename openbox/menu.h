@@ -94,6 +94,11 @@ struct _ObMenu
 
     /* The menu used as the destination for the "More..." entry for this menu*/
     ObMenu *more_menu;
+
+    /* The entries' labels folded for type-ahead filtering, keyed by the
+       ObMenuEntry.  Made the first time the menu is filtered, and thrown
+       away when the entries change. */
+    GHashTable *filter_keys;
 };
 
 typedef enum
@@ -230,5 +235,19 @@ ObMenuEntry* menu_find_entry_id(ObMenu *self, gint id);
 void menu_find_submenus(ObMenu *self);
 
 ObMenuEntry* menu_get_more(ObMenu *menu, guint show_from);
+/*! Makes a labeled separator that isn't in the menu, to show as a title */
+ObMenuEntry* menu_get_title(ObMenu *menu, const gchar *label);
+
+/*! Finds the entries in the menu that can be chosen and whose labels have the
+  text in them, ignoring case, in the order they are in the menu.  If within
+  is not NULL then only the entries in it are looked at, which makes typing
+  another character only search what matched before it.
+  @return A new array of ObMenuEntry, free it with menu_filter_free().  It
+          holds a reference on each of the entries, so they stay valid if
+          the menu changes while it is being filtered.
+*/
+GPtrArray* menu_filter(ObMenu *menu, const gchar *text, GPtrArray *within);
+/*! Frees an array from menu_filter() and lets go of its entries */
+void menu_filter_free(GPtrArray *found);
 
 #endif
@@ -52,6 +52,7 @@ static ObMenuEntryFrame* menu_entry_frame_new(ObMenuEntry *entry,
                                               ObMenuFrame *frame);
 static void menu_entry_frame_free(ObMenuEntryFrame *self);
 static void menu_frame_update(ObMenuFrame *self);
+static void menu_frame_filter_free(ObMenuFrame *self);
 static gboolean submenu_show_timeout(gpointer data);
 static void menu_frame_hide(ObMenuFrame *self);
 
@@ -146,6 +147,7 @@ void menu_frame_free(ObMenuFrame *self)
             menu_entry_frame_free(self->entries->data);
             self->entries = g_list_delete_link(self->entries, self->entries);
         }
+        menu_frame_filter_free(self);
 
         stacking_remove(MENUFRAME_AS_WINDOW(self));
         window_remove(self->window);
@@ -848,12 +850,86 @@ void menu_frame_render(ObMenuFrame *self)
     XFlush(obt_display);
 }
 
+/*! Gets a frame for the menu entry, using one of the old frames if it has
+  the windows that the entry needs */
+static ObMenuEntryFrame* menu_frame_reuse_entry(ObMenuFrame *self,
+                                                GList **old,
+                                                ObMenuEntry *entry)
+{
+    ObMenuEntryFrame *f;
+    GList *it;
+
+    for (it = *old; it; it = g_list_next(it)) {
+        f = it->data;
+        if (f->entry->type == entry->type) {
+            *old = g_list_delete_link(*old, it);
+            menu_entry_ref(entry);
+            menu_entry_unref(f->entry);
+            f->entry = entry;
+            return f;
+        }
+    }
+    return menu_entry_frame_new(entry, self);
+}
+
+/*! Shows the filter text, and below it as many of the entries that match it
+  as will fit on the screen.  There is no More... entry, typing more is how
+  to get to the rest of them. */
+static void menu_frame_update_filtered(ObMenuFrame *self)
+{
+    GList *old;
+    const Rect *a;
+    gint h;
+    guint i;
+
+    a = screen_physical_area_monitor(self->monitor);
+
+    old = self->entries;
+    self->entries = NULL;
+
+    menu_entry_set_label(self->filter_title, self->filter->str, FALSE);
+    self->entries = g_list_prepend(self->entries,
+                                   menu_frame_reuse_entry(self, &old,
+                                                          self->filter_title));
+    h = menu_entry_frame_get_height(self->entries->data, TRUE, FALSE);
+    /* add the border at the top and bottom */
+    h += ob_rr_theme->mbwidth * 2;
+
+    for (i = 0; i < self->filtered->len; ++i) {
+        /* normal and submenu entries are the same height */
+        h += menu_entry_frame_get_height(NULL, FALSE, FALSE);
+        if (h > a->height && i > 0)
+            break;
+
+        self->entries =
+            g_list_prepend(self->entries,
+                           menu_frame_reuse_entry(self, &old,
+                                                  g_ptr_array_index(
+                                                      self->filtered, i)));
+    }
+    self->entries = g_list_reverse(self->entries);
+
+    while (old) {
+        menu_entry_frame_free(old->data);
+        old = g_list_delete_link(old, old);
+    }
+
+    menu_frame_render(self);
+}
+
 static void menu_frame_update(ObMenuFrame *self)
 {
     GList *mit, *fit;
     const Rect *a;
     gint h;
 
+    if (self->filter) {
+        /* the menu is already showing, so its entries are all there */
+        self->selected = NULL;
+        menu_frame_update_filtered(self);
+        return;
+    }
+
     menu_pipe_execute(self->menu);
     menu_find_submenus(self->menu);
 
@@ -1393,6 +1469,96 @@ void menu_frame_select_first(ObMenuFrame *self)
     menu_frame_select(self, it ? it->data : NULL, FALSE);
 }
 
+static void menu_frame_filter_free(ObMenuFrame *self)
+{
+    if (self->filter) {
+        g_string_free(self->filter, TRUE);
+        menu_filter_free(self->filtered);
+        menu_entry_unref(self->filter_title);
+        self->filter = NULL;
+        self->filtered = NULL;
+        self->filter_title = NULL;
+    }
+}
+
+/*! Shows the entries again after the filter changed */
+static void menu_frame_refilter(ObMenuFrame *self)
+{
+    gint dx, dy;
+
+    /* the entry frames are going to change, so let go of them first */
+    if (self->child)
+        menu_frame_hide(self->child);
+    menu_frame_select(self, NULL, TRUE);
+
+    if (!self->filter) {
+        /* the frames were made for the filtered entries, so start over */
+        while (self->entries) {
+            menu_entry_frame_free(self->entries->data);
+            self->entries = g_list_delete_link(self->entries, self->entries);
+        }
+    }
+
+    menu_frame_update(self);
+
+    /* it may be bigger now, keep it on the screen */
+    menu_frame_move_on_screen(self, self->area.x, self->area.y, &dx, &dy);
+    if (dx || dy)
+        menu_frame_move(self, self->area.x + dx, self->area.y + dy);
+
+    menu_frame_select_first(self);
+}
+
+void menu_frame_filter_add(ObMenuFrame *self, gunichar c)
+{
+    GPtrArray *found;
+
+    if (!self->filter) {
+        self->filter = g_string_new(NULL);
+        self->filter_title = menu_get_title(self->menu, NULL);
+    }
+    g_string_append_unichar(self->filter, c);
+
+    /* only what matched before can match with more typed */
+    found = menu_filter(self->menu, self->filter->str, self->filtered);
+    if (self->filtered)
+        menu_filter_free(self->filtered);
+    self->filtered = found;
+
+    menu_frame_refilter(self);
+}
+
+gboolean menu_frame_filter_back(ObMenuFrame *self)
+{
+    gchar *last;
+
+    if (!self->filter)
+        return FALSE;
+
+    last = g_utf8_prev_char(self->filter->str + self->filter->len);
+    g_string_truncate(self->filter, last - self->filter->str);
+
+    if (self->filter->len == 0)
+        menu_frame_filter_clear(self);
+    else {
+        /* less text can match more, so look through the whole menu */
+        menu_filter_free(self->filtered);
+        self->filtered = menu_filter(self->menu, self->filter->str, NULL);
+        menu_frame_refilter(self);
+    }
+    return TRUE;
+}
+
+gboolean menu_frame_filter_clear(ObMenuFrame *self)
+{
+    if (!self->filter)
+        return FALSE;
+
+    menu_frame_filter_free(self);
+    menu_frame_refilter(self);
+    return TRUE;
+}
+
 void menu_frame_select_last(ObMenuFrame *self)
 {
     GList *it = NULL;
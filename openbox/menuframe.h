@@ -59,6 +59,15 @@ struct _ObMenuFrame
     /* show entries from the menu starting at this index */
     guint show_from;
 
+    /* The text typed to filter the menu's entries, NULL when the menu isn't
+       being filtered */
+    GString *filter;
+    /* The ObMenuEntrys that match the filter, with a reference held on
+       each.  Only the ones that fit are given frames */
+    GPtrArray *filtered;
+    /* A separator that shows the filter above them */
+    struct _ObMenuEntry *filter_title;
+
     /* If the submenus are being drawn to the right or the left */
     gboolean direction_right;
 
@@ -138,6 +147,17 @@ void menu_frame_select_next(ObMenuFrame *self);
 void menu_frame_select_first(ObMenuFrame *self);
 void menu_frame_select_last(ObMenuFrame *self);
 
+/*! Adds a character to the text that the menu's entries are filtered with,
+  and shows only the ones that match */
+void menu_frame_filter_add(ObMenuFrame *self, gunichar c);
+/*! Removes the last character from the filter text, and stops filtering
+  when there is none left.
+  @return FALSE if the menu wasn't being filtered */
+gboolean menu_frame_filter_back(ObMenuFrame *self);
+/*! Stops filtering and shows all of the menu's entries again.
+  @return FALSE if the menu wasn't being filtered */
+gboolean menu_frame_filter_clear(ObMenuFrame *self);
+
 ObMenuFrame* menu_frame_under(gint x, gint y);
 ObMenuEntryFrame* menu_entry_frame_under(gint x, gint y);
 
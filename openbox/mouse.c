@@ -27,6 +27,7 @@
 #include "translate.h"
 #include "mouse.h"
 #include "gettext.h"
+#include "debug.h"
 #include "obt/display.h"
 
 #include <glib.h>
@@ -37,11 +38,22 @@ typedef struct {
     GSList *actions[OB_NUM_MOUSE_ACTIONS]; /* lists of Action pointers */
 } ObMouseBinding;
 
+typedef struct {
+    ObFrameContext context;
+    guint button;
+    guint state;
+} ObMouseGrab;
+
 /* Array of GSList*s of ObMouseBinding*s. */
 static GSList *bound_contexts[OB_FRAME_NUM_CONTEXTS];
 /* TRUE when we have a grab on the pointer and need to replay the pointer event
    to send it to other applications */
 static gboolean replay_pointer_needed;
+/* The ObMouseGrabs that every client has, from the bindings for the contexts
+   that are grabbed on the clients' windows */
+static GArray *grabbed = NULL;
+/* The lock masks that the buttons were grabbed with */
+static guint grabbed_locks;
 
 ObFrameContext mouse_button_frame_context(ObFrameContext context,
                                           guint button,
@@ -98,37 +110,40 @@ ObFrameContext mouse_button_frame_context(ObFrameContext context,
         return x;
 }
 
+static void grab_for_client(ObClient *client, const ObMouseGrab *g,
+                            gboolean grab)
+{
+    Window win;
+    gint mode;
+    guint mask;
+
+    if (FRAME_CONTEXT(g->context, client)) {
+        win = client->frame->window;
+        mode = GrabModeAsync;
+        mask = ButtonPressMask | ButtonMotionMask | ButtonReleaseMask;
+    } else if (CLIENT_CONTEXT(g->context, client)) {
+        win = client->window;
+        mode = GrabModeSync; /* this is handled in event */
+        mask = ButtonPressMask; /* can't catch more than this with Sync
+                                   mode the release event is
+                                   manufactured in event() */
+    } else return;
+
+    if (grab)
+        grab_button_full(g->button, g->state, win, mask, mode,
+                         OB_CURSOR_NONE);
+    else
+        ungrab_button(g->button, g->state, win);
+}
+
 void mouse_grab_for_client(ObClient *client, gboolean grab)
 {
-    gint i;
-    GSList *it;
+    guint i;
 
-    for (i = 0; i < OB_FRAME_NUM_CONTEXTS; ++i)
-        for (it = bound_contexts[i]; it; it = g_slist_next(it)) {
-            /* grab/ungrab the button */
-            ObMouseBinding *b = it->data;
-            Window win;
-            gint mode;
-            guint mask;
-
-            if (FRAME_CONTEXT(i, client)) {
-                win = client->frame->window;
-                mode = GrabModeAsync;
-                mask = ButtonPressMask | ButtonMotionMask | ButtonReleaseMask;
-            } else if (CLIENT_CONTEXT(i, client)) {
-                win = client->window;
-                mode = GrabModeSync; /* this is handled in event */
-                mask = ButtonPressMask; /* can't catch more than this with Sync
-                                           mode the release event is
-                                           manufactured in event() */
-            } else continue;
-
-            if (grab)
-                grab_button_full(b->button, b->state, win, mask, mode,
-                                 OB_CURSOR_NONE);
-            else
-                ungrab_button(b->button, b->state, win);
-        }
+    if (grabbed)
+        for (i = 0; i < grabbed->len; ++i)
+            grab_for_client(client, &g_array_index(grabbed, ObMouseGrab, i),
+                            grab);
 }
 
 static void grab_all_clients(gboolean grab)
@@ -139,6 +154,91 @@ static void grab_all_clients(gboolean grab)
         mouse_grab_for_client(it->data, grab);
 }
 
+/*! The grabs for the bindings in the contexts that are grabbed on the
+  clients' windows */
+static GArray* bound_grabs(void)
+{
+    static const ObFrameContext contexts[] = {
+        OB_FRAME_CONTEXT_FRAME,
+        OB_FRAME_CONTEXT_CLIENT,
+        OB_FRAME_CONTEXT_DESKTOP
+    };
+    GArray *grabs;
+    GSList *it;
+    guint i;
+
+    grabs = g_array_new(FALSE, FALSE, sizeof(ObMouseGrab));
+    for (i = 0; i < G_N_ELEMENTS(contexts); ++i)
+        for (it = bound_contexts[contexts[i]]; it; it = g_slist_next(it)) {
+            ObMouseBinding *b = it->data;
+            ObMouseGrab g;
+
+            g.context = contexts[i];
+            g.button = b->button;
+            g.state = b->state;
+            g_array_append_val(grabs, g);
+        }
+    return grabs;
+}
+
+static gboolean has_grab(GArray *grabs, const ObMouseGrab *g)
+{
+    guint i;
+
+    for (i = 0; i < grabs->len; ++i) {
+        const ObMouseGrab *o = &g_array_index(grabs, ObMouseGrab, i);
+        if (o->context == g->context && o->button == g->button &&
+            o->state == g->state)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*! Change the grabs on all the clients to the ones for the current bindings,
+  only grabbing and ungrabbing the buttons that changed */
+static void regrab_all_clients(void)
+{
+    GArray *want;
+    GList *it;
+    guint i, requests = grab_request_count();
+
+    want = bound_grabs();
+
+    if (grabbed && grabbed_locks != grab_lock_masks()) {
+        /* the old grabs were made with different lock masks, so they can't
+           be ungrabbed one at a time */
+        for (it = client_list; it; it = g_list_next(it)) {
+            ObClient *c = it->data;
+
+            ungrab_all_buttons(c->frame->window);
+            ungrab_all_buttons(c->window);
+        }
+        g_array_set_size(grabbed, 0);
+    }
+
+    for (it = client_list; it; it = g_list_next(it)) {
+        if (grabbed)
+            for (i = 0; i < grabbed->len; ++i) {
+                ObMouseGrab *g = &g_array_index(grabbed, ObMouseGrab, i);
+                if (!has_grab(want, g))
+                    grab_for_client(it->data, g, FALSE);
+            }
+        for (i = 0; i < want->len; ++i) {
+            ObMouseGrab *g = &g_array_index(want, ObMouseGrab, i);
+            if (!grabbed || !has_grab(grabbed, g))
+                grab_for_client(it->data, g, TRUE);
+        }
+    }
+
+    if (grabbed)
+        g_array_free(grabbed, TRUE);
+    grabbed = want;
+    grabbed_locks = grab_lock_masks();
+
+    ob_debug("Grabbing buttons for %u clients used %u requests",
+             g_list_length(client_list), grab_request_count() - requests);
+}
+
 void mouse_unbind_all(void)
 {
     gint i;
@@ -403,11 +503,19 @@ gboolean mouse_bind(const gchar *buttonstr, ObFrameContext context,
 
 void mouse_startup(gboolean reconfig)
 {
-    grab_all_clients(TRUE);
+    regrab_all_clients();
 }
 
 void mouse_shutdown(gboolean reconfig)
 {
-    grab_all_clients(FALSE);
+    /* when reconfiguring, the grabs are kept and only the ones that changed
+       are grabbed or ungrabbed at startup */
+    if (!reconfig) {
+        grab_all_clients(FALSE);
+        if (grabbed) {
+            g_array_free(grabbed, TRUE);
+            grabbed = NULL;
+        }
+    }
     mouse_unbind_all();
 }
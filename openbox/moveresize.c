@@ -30,6 +30,7 @@
 #include "config.h"
 #include "event.h"
 #include "debug.h"
+#include "animate.h"
 #include "obrender/render.h"
 #include "obrender/theme.h"
 #include "obt/display.h"
@@ -39,6 +40,7 @@
 
 #include <X11/Xlib.h>
 #include <glib.h>
+#include <string.h>
 
 /* how far windows move and resize with the keyboard arrows */
 #define KEY_DIST 8
@@ -70,6 +72,16 @@ static guint sync_timer = 0;
 #endif
 
 static ObPopup *popup = NULL;
+/*! The coordinates waiting to be shown in the popup on the next tick, and
+  the client they are for */
+static gchar popup_text[64];
+static ObClient *popup_client = NULL;
+static gboolean popup_waiting = FALSE;
+static guint popup_tick = 0;
+/*! How many characters the popup has been made wide enough for, and the
+  widest digit in its font */
+static gsize popup_chars = 0;
+static gchar popup_digit = '\0';
 
 static void do_move(gboolean keyboard, gint keydist);
 static void do_resize(void);
@@ -85,12 +97,17 @@ static void client_dest(ObClient *client, gpointer data)
         moveresize_end(TRUE);
     if (popup && client == popup->client)
         popup->client = NULL;
+    if (client == popup_client)
+        popup_client = NULL;
 }
 
 void moveresize_startup(gboolean reconfig)
 {
     popup = popup_new();
     popup_set_text_align(popup, RR_JUSTIFY_CENTER);
+    /* the font may have changed */
+    popup_chars = 0;
+    popup_digit = '\0';
 
     if (!reconfig)
         client_add_destroy_notify(client_dest, NULL);
@@ -108,11 +125,48 @@ void moveresize_shutdown(gboolean reconfig)
     popup = NULL;
 }
 
-static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
+/*! Make the popup wide enough for coordinates as long as the screen is big,
+  or as the text, written with the widest digit.  Then it stays the same size
+  as they change, and the text isn't measured each time it is shown. */
+static void popup_fit(const gchar *format, gint a, gint b)
+{
+    const Rect *all = screen_physical_area_all_monitors();
+    gint i, v, most;
+    gchar *wide, *p;
+
+    if (strlen(popup_text) <= popup_chars) return;
+
+    if (!popup_digit) {
+        gint w = -1;
+
+        for (i = 0; i < 10; ++i) {
+            gchar d[2] = { '0' + i, '\0' };
+
+            popup_text_width_to_string(popup, d);
+            if (popup->textw > w) {
+                w = popup->textw;
+                popup_digit = d[0];
+            }
+        }
+    }
+
+    most = MAX(MAX(RECT_RIGHT(*all), RECT_BOTTOM(*all)),
+               MAX(ABS(a), ABS(b)));
+    for (v = 9; v < most && v < G_MAXINT / 10; v = v * 10 + 9);
+
+    wide = g_strdup_printf(format, -v, -v);
+    for (p = wide; *p; ++p)
+        if (g_ascii_isdigit(*p)) *p = popup_digit;
+    popup_text_width_to_string(popup, wide);
+    popup_height_to_string(popup, wide);
+    popup_chars = strlen(wide);
+    g_free(wide);
+}
+
+static void popup_draw(void)
 {
-    gchar *text;
+    ObClient *c = popup_client;
 
-    text = g_strdup_printf(format, a, b);
     if (config_resize_popup_pos == OB_RESIZE_POS_TOP)
         popup_position(popup, SouthGravity,
                        c->frame->area.x
@@ -170,8 +224,38 @@ static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
         popup_position(popup, gravity, x, y);
     }
     popup->client = c;
-    popup_show(popup, text);
-    g_free(text);
+    popup_show(popup, popup_text);
+}
+
+static gboolean popup_tick_func(gint64 now, gpointer data)
+{
+    if (!popup_waiting) return FALSE; /* nothing changed since the last tick */
+
+    popup_waiting = FALSE;
+    if (popup_client) popup_draw();
+    return TRUE;
+}
+
+static void popup_tick_done(gpointer data)
+{
+    popup_tick = 0;
+    popup_waiting = FALSE;
+}
+
+static void popup_coords(ObClient *c, const gchar *format, gint a, gint b)
+{
+    g_snprintf(popup_text, sizeof(popup_text), format, a, b);
+    popup_client = c;
+    popup_fit(format, a, b);
+
+    /* show it now, and then at most once a tick while it keeps changing,
+       which is as often as the screen shows the window moving */
+    if (popup_tick)
+        popup_waiting = TRUE;
+    else {
+        popup_draw();
+        popup_tick = animate_add(0, popup_tick_func, NULL, popup_tick_done);
+    }
 }
 
 void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
@@ -314,8 +398,10 @@ void moveresize_end(gboolean cancel)
     ungrab_keyboard();
     ungrab_pointer();
 
+    if (popup_tick) animate_remove(popup_tick);
     popup_hide(popup);
     popup->client = NULL;
+    popup_client = NULL;
 
     if (!moving) {
 #ifdef SYNC
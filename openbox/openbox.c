@@ -22,6 +22,9 @@
 #include "session.h"
 #include "dock.h"
 #include "event.h"
+#include "animate.h"
+#include "publish.h"
+#include "handover.h"
 #include "menu.h"
 #include "client.h"
 #include "screen.h"
@@ -47,6 +50,7 @@
 #include "obrender/theme.h"
 #include "obt/display.h"
 #include "obt/xqueue.h"
+#include "obt/loop.h"
 #include "obt/signal.h"
 #include "obt/prop.h"
 #include "obt/keyboard.h"
@@ -106,6 +110,11 @@ static guint     remote_control = 0;
 static gboolean  being_replaced = FALSE;
 static gchar    *config_file = NULL;
 static gchar    *startup_cmd = NULL;
+static gint64    phase_start = 0;
+static gint64    phase_last = 0;
+static GThread  *config_thread = NULL;
+static ObtXmlInst *config_inst = NULL;
+static gboolean  config_loaded = FALSE;
 
 static void signal_handler(gint signal, gpointer data);
 static void remove_args(gint *argc, gchar **argv, gint index, gint num);
@@ -113,6 +122,10 @@ static void parse_env();
 static void parse_args(gint *argc, gchar **argv);
 static Cursor load_cursor(const gchar *name, guint fontval);
 static void run_startup_cmd(void);
+static void phase_begin(void);
+static void phase_done(const gchar *name);
+static void config_read_begin(void);
+static ObtXmlInst* config_read_finish(gboolean *loaded);
 
 gint main(gint argc, gchar **argv)
 {
@@ -123,6 +136,7 @@ gint main(gint argc, gchar **argv)
     ob_set_state(OB_STATE_STARTING);
 
     ob_debug_startup();
+    phase_begin();
 
     /* initialize the locale */
     if (!(ob_locale_msg = setlocale(LC_MESSAGES, "")))
@@ -141,6 +155,8 @@ gint main(gint argc, gchar **argv)
     parse_args(&argc, argv);
     /* parse the environment variables */
     parse_env();
+    /* and pick up anything handed over by a restart */
+    handover_load();
 
     program_name = g_path_get_basename(argv[0]);
     g_set_prgname(program_name);
@@ -150,6 +166,7 @@ gint main(gint argc, gchar **argv)
 
     if (!obt_display_open(NULL))
         ob_exit_with_error(_("Failed to open the display from the DISPLAY environment variable."));
+    phase_done("opening the display");
 
     if (remote_control) {
         /* Send client message telling the OB process to:
@@ -162,6 +179,7 @@ gint main(gint argc, gchar **argv)
     }
 
     ob_main_loop = g_main_loop_new(NULL, FALSE);
+    obt_loop_startup();
 
     /* set up signal handlers, they are called from the mainloop
        in the main program's thread */
@@ -185,6 +203,7 @@ gint main(gint argc, gchar **argv)
        and the alt-tab icon
     */
     ob_rr_icons = RrImageCacheNew(3);
+    phase_done("render setup");
 
     XSynchronize(obt_display, xsync);
 
@@ -198,6 +217,10 @@ gint main(gint argc, gchar **argv)
        display we're using, so they open in the right place. */
     g_setenv("DISPLAY", DisplayString(obt_display), TRUE);
 
+    /* reading the config file doesn't need the display, so let it happen
+       while waiting on the server for the cursors and the screen */
+    config_read_begin();
+
     /* create available cursors */
     cursors[OB_CURSOR_NONE] = None;
     cursors[OB_CURSOR_POINTER] = load_cursor("left_ptr", XC_left_ptr);
@@ -216,8 +239,10 @@ gint main(gint argc, gchar **argv)
     cursors[OB_CURSOR_WEST] = load_cursor("left_side", XC_left_side);
     cursors[OB_CURSOR_NORTHWEST] = load_cursor("top_left_corner",
                                                XC_top_left_corner);
+    phase_done("cursors");
 
     if (screen_annex()) { /* it will be ours! */
+        phase_done("taking over the screen");
 
         /* get a timestamp from after taking over as the WM.  if we use the
            old timestamp to set focus it can fail when replacing another WM. */
@@ -227,14 +252,20 @@ gint main(gint argc, gchar **argv)
             gchar *xml_error_string = NULL;
             ObPrompt *xmlprompt = NULL;
 
-            if (reconfigure) obt_keyboard_reload();
+            if (reconfigure) {
+                phase_begin();
+                config_read_begin();
+                obt_keyboard_reload();
+            }
 
             {
                 ObtXmlInst *i;
+                gboolean loaded;
 
-                /* startup the parsing so everything can register sections
-                   of the rc */
-                i = obt_xml_instance_new();
+                /* wait for the rc file to be read.  the sections of it are
+                   only handed out to the callbacks below, here in the main
+                   thread */
+                i = config_read_finish(&loaded);
 
                 /* register all the available actions */
                 actions_startup(reconfigure);
@@ -242,11 +273,7 @@ gint main(gint argc, gchar **argv)
                 config_startup(i);
 
                 /* parse/load user options */
-                if ((config_file &&
-                     obt_xml_load_file(i, config_file, "openbox_config")) ||
-                    obt_xml_load_config_file(i, "openbox", "rc.xml",
-                                             "openbox_config"))
-                {
+                if (loaded) {
                     obt_xml_tree_from_root(i);
                     obt_xml_close(i);
                 }
@@ -276,6 +303,7 @@ gint main(gint argc, gchar **argv)
                 /* we're done with parsing now, kill it */
                 obt_xml_instance_unref(i);
             }
+            phase_done("config");
 
             /* load the theme specified in the rc file */
             {
@@ -297,6 +325,7 @@ gint main(gint argc, gchar **argv)
                 OBT_PROP_SETS(obt_root(ob_screen), OB_THEME,
                               ob_rr_theme->name);
             }
+            phase_done("theme");
 
             if (reconfigure) {
                 GList *it;
@@ -307,7 +336,9 @@ gint main(gint argc, gchar **argv)
                     frame_adjust_theme(c->frame);
                 }
             }
+            publish_startup(reconfigure);
             event_startup(reconfigure);
+            animate_startup(reconfigure);
             /* focus_backup is used for stacking, so this needs to come before
                anything that calls stacking_add */
             sn_startup(reconfigure);
@@ -316,18 +347,23 @@ gint main(gint argc, gchar **argv)
             focus_cycle_startup(reconfigure);
             focus_cycle_indicator_startup(reconfigure);
             focus_cycle_popup_startup(reconfigure);
+            phase_done("focus and window setup");
             screen_startup(reconfigure);
+            phase_done("screen");
             grab_startup(reconfigure);
             group_startup(reconfigure);
             ping_startup(reconfigure);
             client_startup(reconfigure);
             dock_startup(reconfigure);
             moveresize_startup(reconfigure);
+            phase_done("clients and dock setup");
             keyboard_startup(reconfigure);
             mouse_startup(reconfigure);
+            phase_done("key and mouse bindings");
             menu_frame_startup(reconfigure);
             menu_startup(reconfigure);
             prompt_startup(reconfigure);
+            phase_done("menus");
 
             if (!reconfigure) {
                 /* do this after everything is started so no events will get
@@ -339,6 +375,8 @@ gint main(gint argc, gchar **argv)
 
                 /* get all the existing windows */
                 window_manage_all();
+                /* and put them back how they were if we restarted */
+                handover_restore();
 
                 /* focus what was focused if a wm was already running */
                 if (OBT_PROP_GET32(obt_root(ob_screen),
@@ -347,6 +385,7 @@ gint main(gint argc, gchar **argv)
                 {
                     client_focus(WINDOW_AS_CLIENT(w));
                 }
+                phase_done("managing windows");
             } else {
                 GList *it;
 
@@ -365,6 +404,9 @@ gint main(gint argc, gchar **argv)
             }
 
             ob_set_state(OB_STATE_RUNNING);
+            ob_debug("%s took %.2fms in total",
+                     reconfigure ? "Reconfiguring" : "Starting up",
+                     (phase_last - phase_start) / 1000.0);
 
             if (!reconfigure && startup_cmd) run_startup_cmd();
 
@@ -388,8 +430,19 @@ gint main(gint argc, gchar **argv)
                 xmlprompt = NULL;
             }
 
-            if (!reconfigure)
+            /* finish the work waiting for the end of the events while
+               everything it uses is still there.  this writes the root
+               window properties waiting to be published too */
+            event_run_deferred();
+
+            if (!reconfigure) {
+                /* a different window manager can't use the state */
+                if (restart && !restart_path)
+                    handover_save();
                 window_unmanage_all();
+                /* and what unmanaging the windows left waiting */
+                event_run_deferred();
+            }
 
             prompt_shutdown(reconfigure);
             menu_shutdown(reconfigure);
@@ -409,14 +462,32 @@ gint main(gint argc, gchar **argv)
             focus_shutdown(reconfigure);
             window_shutdown(reconfigure);
             sn_shutdown(reconfigure);
+            animate_shutdown(reconfigure);
             event_shutdown(reconfigure);
+            publish_shutdown(reconfigure);
             config_shutdown();
             actions_shutdown(reconfigure);
         } while (reconfigure);
     }
+    else {
+        ObtXmlInst *i;
+        gboolean loaded;
+
+        /* the config that was read won't be used */
+        i = config_read_finish(&loaded);
+        obt_xml_close(i);
+        obt_xml_instance_unref(i);
+    }
 
     XSync(obt_display, FALSE);
 
+    {
+        guint shaped, reused;
+
+        RrFontLayoutStats(&shaped, &reused);
+        ob_debug("Text layouts: %u shaped, %u reused", shaped, reused);
+    }
+
     RrThemeFree(ob_rr_theme);
     RrImageCacheUnref(ob_rr_icons);
     RrInstanceFree(ob_rr_inst);
@@ -427,6 +498,7 @@ gint main(gint argc, gchar **argv)
 
     if (restart) {
         ob_debug_shutdown();
+        obt_loop_shutdown();
         obt_signal_stop();
         if (restart_path != NULL) {
             gint argcp;
@@ -483,6 +555,7 @@ gint main(gint argc, gchar **argv)
 
     if (!restart) {
         ob_debug_shutdown();
+        obt_loop_shutdown();
         obt_signal_stop();
     }
 
@@ -564,6 +637,76 @@ static void remove_args(gint *argc, gchar **argv, gint index, gint num)
     *argc -= num;
 }
 
+/*! Start timing startup or a reconfigure */
+static void phase_begin(void)
+{
+    phase_start = phase_last = animate_time();
+}
+
+/*! Log how long it took to do the part of starting up that just finished,
+  so that it can be seen which parts of the way to a usable desktop are slow */
+static void phase_done(const gchar *name)
+{
+    gint64 now = animate_time();
+
+    ob_debug("Starting up: %s took %.2fms", name, (now - phase_last) / 1000.0);
+    phase_last = now;
+}
+
+static gpointer config_read_func(gpointer data)
+{
+    ObtXmlInst *i = data;
+
+    return GINT_TO_POINTER((config_file &&
+                            obt_xml_load_file(i, config_file,
+                                              "openbox_config")) ||
+                           obt_xml_load_config_file(i, "openbox", "rc.xml",
+                                                    "openbox_config"));
+}
+
+/*! Start reading and parsing the rc file in another thread.  This only
+  builds the document, it doesn't touch the display or call into any of the
+  other modules, so it can overlap with the setup that waits on the X
+  server. */
+static void config_read_begin(void)
+{
+    g_assert(config_inst == NULL);
+
+    /* libxml wants to be set up from the main thread */
+    xmlInitParser();
+
+    config_inst = obt_xml_instance_new();
+#if GLIB_CHECK_VERSION(2,32,0)
+    config_thread = g_thread_try_new("config", config_read_func,
+                                     config_inst, NULL);
+#else
+    /* g_thread_try_new is new in glib 2.32, and before that the thread
+       system has to be initialized by hand */
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+    config_thread = g_thread_create(config_read_func, config_inst,
+                                    TRUE, NULL);
+#endif
+    if (!config_thread)
+        config_loaded = GPOINTER_TO_INT(config_read_func(config_inst));
+}
+
+/*! Wait for the rc file to be read, and take the parser instance holding
+  it.  @loaded is set to TRUE if a config file was found and opened in it. */
+static ObtXmlInst* config_read_finish(gboolean *loaded)
+{
+    ObtXmlInst *i;
+
+    if (config_thread) {
+        config_loaded = GPOINTER_TO_INT(g_thread_join(config_thread));
+        config_thread = NULL;
+    }
+    i = config_inst;
+    config_inst = NULL;
+    *loaded = config_loaded;
+    return i;
+}
+
 static void run_startup_cmd(void)
 {
     gchar **argv = NULL;
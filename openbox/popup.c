@@ -28,6 +28,8 @@
 #include "obrender/render.h"
 #include "obrender/theme.h"
 
+#include <string.h>
+
 ObPopup *popup_new(void)
 {
     XSetWindowAttributes attrib;
@@ -70,6 +72,7 @@ void popup_free(ObPopup *self)
         XDestroyWindow(obt_display, self->text);
         RrAppearanceFree(self->a_bg);
         RrAppearanceFree(self->a_text);
+        g_free(self->drawn_text);
         window_remove(self->bg);
         stacking_remove(self);
         g_slice_free(ObPopup, self);
@@ -136,6 +139,9 @@ void popup_text_width_to_strings(ObPopup *self, gchar **strings, gint num)
 void popup_set_text_align(ObPopup *self, RrJustify align)
 {
     self->a_text->texture[0].data.text.justify = align;
+    /* draw the text again */
+    g_free(self->drawn_text);
+    self->drawn_text = NULL;
 }
 
 static gboolean popup_show_timeout(gpointer data)
@@ -162,6 +168,7 @@ void popup_delay_show(ObPopup *self, gulong msec, gchar *text)
     const Rect *area;
     Rect mon;
     gboolean hasicon = self->hasicon;
+    gboolean resized;
 
     /* when there is no icon and the text is not parent relative, then
        fill the whole dialog with the text appearance, don't use the bg at all
@@ -174,8 +181,10 @@ void popup_delay_show(ObPopup *self, gulong msec, gchar *text)
     /* set up the textures */
     self->a_text->texture[0].data.text.string = text;
 
-    /* measure the text out */
-    if (text[0] != '\0') {
+    /* measure the text out, unless the size was set already */
+    if (self->textw && self->h)
+        textw = texth = 0;
+    else if (text[0] != '\0') {
         RrMinSize(self->a_text, &textw, &texth);
     } else {
         textw = 0;
@@ -278,20 +287,38 @@ void popup_delay_show(ObPopup *self, gulong msec, gchar *text)
         y = MAX(MIN(y, area->y+area->height-h), area->y);
     }
 
+    /* while it is showing with the same size, only the text can need to be
+       drawn again, like for the coordinates when moving a window */
+    resized = (!self->mapped ||
+               self->drawn_area.width != w || self->drawn_area.height != h);
+
     /* set the windows/appearances up */
-    XMoveResizeWindow(obt_display, self->bg, x, y, w, h);
-    /* when there is no icon and the text is not parent relative, then
-       fill the whole dialog with the text appearance, don't use the bg at all
-    */
-    if (hasicon || self->a_text->surface.grad == RR_SURFACE_PARENTREL)
-        RrPaint(self->a_bg, self->bg, w, h);
+    if (resized) {
+        g_free(self->drawn_text);
+        self->drawn_text = NULL;
+
+        XMoveResizeWindow(obt_display, self->bg, x, y, w, h);
+        /* when there is no icon and the text is not parent relative, then
+           fill the whole dialog with the text appearance, don't use the bg at
+           all
+        */
+        if (hasicon || self->a_text->surface.grad == RR_SURFACE_PARENTREL)
+            RrPaint(self->a_bg, self->bg, w, h);
+    }
+    else if (self->drawn_area.x != x || self->drawn_area.y != y)
+        XMoveWindow(obt_display, self->bg, x, y);
+    RECT_SET(self->drawn_area, x, y, w, h);
 
-    if (textw) {
+    if (textw && (!self->drawn_text || strcmp(self->drawn_text, text))) {
         self->a_text->surface.parent = self->a_bg;
         self->a_text->surface.parentx = textx;
         self->a_text->surface.parenty = texty;
-        XMoveResizeWindow(obt_display, self->text, textx, texty, textw, texth);
+        if (resized)
+            XMoveResizeWindow(obt_display, self->text,
+                              textx, texty, textw, texth);
         RrPaint(self->a_text, self->text, textw, texth);
+        g_free(self->drawn_text);
+        self->drawn_text = g_strdup(text);
     }
 
     if (hasicon)
@@ -55,6 +55,11 @@ struct _ObPopup
     gboolean mapped;
     gboolean delay_mapped;
     guint delay_timer;
+    /*! Where the popup was drawn while it is showing, and the text drawn in
+      it.  When it is shown again with the same size and text, it is not
+      redrawn. */
+    Rect drawn_area;
+    gchar *drawn_text;
 
     void (*draw_icon)(gint x, gint y, gint w, gint h, gpointer data);
     gpointer draw_icon_data;
@@ -91,7 +96,8 @@ void popup_free(ObPopup *self);
 */
 void popup_position(ObPopup *self, gint gravity, gint x, gint y);
 /*! Set the sizes for the popup. When set to 0, the size will be based on
-  the text size. */
+  the text size.  When the text width and height are both set, the text is
+  not measured each time it is shown. */
 void popup_height(ObPopup *self, gint w);
 void popup_min_width(ObPopup *self, gint minw);
 void popup_max_width(ObPopup *self, gint maxw);
@@ -0,0 +1,167 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   publish.c for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "publish.h"
+#include "event.h"
+#include "openbox.h"
+#include "debug.h"
+#include "obt/display.h"
+
+#include <string.h>
+
+typedef struct _ObPublished ObPublished;
+
+struct _ObPublished {
+    ObtPropAtom type;
+    /* the value on the root window */
+    gulong *vals;
+    guint num;
+    gboolean set;
+    /* the value to write at the end of the batch */
+    gulong *next;
+    guint next_num;
+    gboolean pending;
+};
+
+static ObPublished published[OBT_PROP_NUM_ATOMS];
+static guint writes, appends, skips;
+
+static void flush_deferred(gpointer data);
+
+void publish_startup(gboolean reconfig)
+{
+    if (reconfig) return;
+
+    memset(published, 0, sizeof(published));
+    writes = appends = skips = 0;
+}
+
+void publish_shutdown(gboolean reconfig)
+{
+    ObtPropAtom i;
+
+    /* the values waiting were written before anything was shut down.  when
+       reconfiguring, the ones set while shutting down are still right */
+    if (reconfig) {
+        publish_flush();
+        return;
+    }
+
+    ob_debug("Root properties: %u written, %u appended, %u unchanged",
+             writes, appends, skips);
+
+    /* don't write values set while shutting down over what the shutdown
+       erased */
+    event_cancel_defer(flush_deferred, NULL);
+    for (i = 0; i < OBT_PROP_NUM_ATOMS; ++i) {
+        g_free(published[i].vals);
+        published[i].vals = NULL;
+        published[i].set = FALSE;
+        g_free(published[i].next);
+        published[i].next = NULL;
+        published[i].pending = FALSE;
+    }
+}
+
+void publish_set32(ObtPropAtom prop, ObtPropAtom type, gulong val)
+{
+    publish_set_array32(prop, type, &val, 1);
+}
+
+void publish_set_array32(ObtPropAtom prop, ObtPropAtom type,
+                         const gulong *vals, guint num)
+{
+    ObPublished *p = &published[prop];
+
+    g_free(p->next);
+    p->next = g_memdup(vals, num * sizeof(gulong));
+    p->next_num = num;
+    p->type = type;
+    p->pending = TRUE;
+
+    event_defer(flush_deferred, NULL);
+}
+
+void publish_erase(ObtPropAtom prop)
+{
+    ObPublished *p = &published[prop];
+
+    g_free(p->next);
+    p->next = NULL;
+    p->pending = FALSE;
+
+    g_free(p->vals);
+    p->vals = NULL;
+    p->num = 0;
+    p->set = FALSE;
+
+    obt_prop_erase(obt_root(ob_screen), obt_prop_atom(prop));
+}
+
+static void publish_write(ObtPropAtom prop, ObPublished *p)
+{
+    const Window root = obt_root(ob_screen);
+    const Atom atom = obt_prop_atom(prop);
+    const Atom type = obt_prop_atom(p->type);
+
+    p->pending = FALSE;
+
+    /* vals is NULL when the value was empty */
+    if (p->set && p->num <= p->next_num &&
+        (p->num == 0 || !memcmp(p->vals, p->next, p->num * sizeof(gulong))))
+    {
+        if (p->num == p->next_num) {
+            /* nothing changed */
+            ++skips;
+            g_free(p->next);
+            p->next = NULL;
+            return;
+        }
+
+        /* it only has more on the end, so that's all that has to be sent */
+        XChangeProperty(obt_display, root, atom, type, 32, PropModeAppend,
+                        (guchar*)(p->next + p->num), p->next_num - p->num);
+        ++appends;
+    }
+    else {
+        XChangeProperty(obt_display, root, atom, type, 32, PropModeReplace,
+                        (guchar*)p->next, p->next_num);
+        ++writes;
+    }
+
+    g_free(p->vals);
+    p->vals = p->next;
+    p->num = p->next_num;
+    p->set = TRUE;
+    p->next = NULL;
+}
+
+void publish_flush(void)
+{
+    ObtPropAtom i;
+
+    event_cancel_defer(flush_deferred, NULL);
+
+    for (i = 0; i < OBT_PROP_NUM_ATOMS; ++i)
+        if (published[i].pending)
+            publish_write(i, &published[i]);
+}
+
+static void flush_deferred(gpointer data)
+{
+    publish_flush();
+}
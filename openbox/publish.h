@@ -0,0 +1,52 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   publish.h for the Openbox window manager
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __publish_h
+#define __publish_h
+
+#include "obt/prop.h"
+
+#include <glib.h>
+#include <X11/Xlib.h>
+
+/*! Properties on the root window which only the window manager writes, like
+  the client lists, are set through here.  A new value is written at the end
+  of the current batch of events, so only the last of many changes is sent.
+  Nothing is written if the value is the same as the last one, and a list
+  which only grew at the end has just the new items appended. */
+
+void publish_startup(gboolean reconfig);
+void publish_shutdown(gboolean reconfig);
+
+void publish_set32(ObtPropAtom prop, ObtPropAtom type, gulong val);
+void publish_set_array32(ObtPropAtom prop, ObtPropAtom type,
+                         const gulong *vals, guint num);
+
+/*! Remove the property from the root window, and drop any value waiting to
+  be written */
+void publish_erase(ObtPropAtom prop);
+
+/*! Write all of the values that are waiting */
+void publish_flush(void);
+
+#define PUBLISH_SET32(prop, type, val) \
+    (publish_set32(OBT_PROP_##prop, OBT_PROP_##type, val))
+#define PUBLISH_SETA32(prop, type, vals, num) \
+    (publish_set_array32(OBT_PROP_##prop, OBT_PROP_##type, vals, num))
+#define PUBLISH_ERASE(prop) (publish_erase(OBT_PROP_##prop))
+
+#endif
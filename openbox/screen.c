@@ -29,6 +29,7 @@
 #include "session.h"
 #include "frame.h"
 #include "event.h"
+#include "publish.h"
 #include "focus.h"
 #include "focus_cycle.h"
 #include "popup.h"
@@ -56,6 +57,9 @@ static gboolean screen_validate_layout(ObDesktopLayout *l);
 static gboolean replace_wm(void);
 static void     screen_tell_ksplash(void);
 static void     screen_fallback_focus(void);
+static void     set_workarea(gpointer data);
+static void     containers_resize(guint num);
+static void     containers_switch(guint previous);
 
 guint                  screen_num_desktops;
 guint                  screen_num_monitors;
@@ -79,6 +83,13 @@ static GSList *struts_left = NULL;
 static GSList *struts_right = NULL;
 static GSList *struts_bottom = NULL;
 
+/*! When in use, a window for each desktop that its frames are children of.
+  The windows on all desktops and the dock are kept in the current desktop's
+  container */
+static Window   *containers = NULL;
+static guint     num_containers = 0;
+static gboolean  use_containers = FALSE;
+
 static ObPagerPopup *desktop_popup;
 static guint         desktop_popup_timer = 0;
 static gboolean      desktop_popup_perm;
@@ -377,6 +388,10 @@ void screen_startup(gboolean reconfig)
     /* get the initial size */
     screen_resize();
 
+    /* this can't change without restarting, since every frame would have to
+       be moved */
+    use_containers = config_desktop_containers;
+
     /* have names already been set for the desktops? */
     if (OBT_PROP_GETSS_UTF8(obt_root(ob_screen), NET_DESKTOP_NAMES, &names)) {
         g_strfreev(names);
@@ -446,8 +461,7 @@ void screen_startup(gboolean reconfig)
 
     /* don't start in showing-desktop mode */
     screen_show_desktop_mode = SCREEN_SHOW_DESKTOP_NO;
-    OBT_PROP_SET32(obt_root(ob_screen),
-                   NET_SHOWING_DESKTOP, CARDINAL, screen_showing_desktop());
+    PUBLISH_SET32(NET_SHOWING_DESKTOP, CARDINAL, screen_showing_desktop());
 
     if (session_desktop_layout_present &&
         screen_validate_layout(&session_desktop_layout))
@@ -465,6 +479,11 @@ void screen_shutdown(gboolean reconfig)
     if (reconfig)
         return;
 
+    event_cancel_defer(set_workarea, NULL);
+
+    /* all of the frames are gone by now */
+    containers_resize(0);
+
     XSelectInput(obt_display, obt_root(ob_screen), NoEventMask);
 
     /* we're not running here no more! */
@@ -472,7 +491,7 @@ void screen_shutdown(gboolean reconfig)
     /* not without us */
     OBT_PROP_ERASE(obt_root(ob_screen), NET_SUPPORTED);
     /* don't keep this mode */
-    OBT_PROP_ERASE(obt_root(ob_screen), NET_SHOWING_DESKTOP);
+    PUBLISH_ERASE(NET_SHOWING_DESKTOP);
 
     XDestroyWindow(obt_display, screen_support_win);
 
@@ -483,6 +502,7 @@ void screen_shutdown(gboolean reconfig)
 void screen_resize(void)
 {
     gint w, h;
+    guint i;
     GList *it;
     gulong geometry[2];
 
@@ -492,8 +512,10 @@ void screen_resize(void)
     /* Set the _NET_DESKTOP_GEOMETRY hint */
     screen_physical_size.width = geometry[0] = w;
     screen_physical_size.height = geometry[1] = h;
-    OBT_PROP_SETA32(obt_root(ob_screen),
-                    NET_DESKTOP_GEOMETRY, CARDINAL, geometry, 2);
+    PUBLISH_SETA32(NET_DESKTOP_GEOMETRY, CARDINAL, geometry, 2);
+
+    for (i = 0; i < num_containers; ++i)
+        XResizeWindow(obt_display, containers[i], w, h);
 
     if (ob_state() != OB_STATE_RUNNING)
         return;
@@ -507,6 +529,116 @@ void screen_resize(void)
     }
 }
 
+static Window container_new(void)
+{
+    XSetWindowAttributes attrib;
+    Window win;
+
+    /* show the root window's background through the containers */
+    attrib.background_pixmap = ParentRelative;
+    attrib.override_redirect = True;
+
+    win = XCreateWindow(obt_display, obt_root(ob_screen), 0, 0,
+                        screen_physical_size.width,
+                        screen_physical_size.height,
+                        0, CopyFromParent, InputOutput, CopyFromParent,
+                        CWBackPixmap | CWOverrideRedirect, &attrib);
+    /* keep it below the internal windows, which stay in the root */
+    XLowerWindow(obt_display, win);
+    return win;
+}
+
+static void containers_resize(guint num)
+{
+    guint i;
+
+    if (!use_containers) return;
+
+    for (i = num; i < num_containers; ++i)
+        XDestroyWindow(obt_display, containers[i]);
+
+    if (num > num_containers) {
+        containers = g_renew(Window, containers, num);
+        for (i = num_containers; i < num; ++i)
+            containers[i] = container_new();
+    }
+    else if (num == 0) {
+        g_free(containers);
+        containers = NULL;
+    }
+    num_containers = num;
+}
+
+/*! Show the current desktop's container in place of the previous one's.
+  The windows on all desktops and the dock are moved into it, between the
+  desktop's own windows where the stacking order puts them, so the stacking
+  layers hold across all of them.  Only those windows are touched, the
+  others are shown and hidden with their containers. */
+static void containers_switch(guint previous)
+{
+    GList *it;
+
+    if (!use_containers) return;
+
+    grab_server(TRUE);
+
+    /* map it under the old one, which covers it until it is unmapped */
+    if (previous < num_containers) {
+        XWindowChanges changes;
+
+        changes.sibling = containers[previous];
+        changes.stack_mode = Below;
+        XConfigureWindow(obt_display, containers[screen_desktop],
+                         CWSibling | CWStackMode, &changes);
+    }
+    XMapWindow(obt_display, containers[screen_desktop]);
+
+    /* from the top down, so each one goes below the ones above it that are
+       already there */
+    for (it = stacking_list; it; it = g_list_next(it)) {
+        gboolean moved = FALSE;
+
+        if (WINDOW_IS_CLIENT(it->data)) {
+            ObClient *c = it->data;
+            moved = c->desktop == DESKTOP_ALL && frame_adjust_parent(c->frame);
+        }
+        else if (WINDOW_IS_DOCK(it->data))
+            moved = dock_adjust_parent();
+
+        if (moved)
+            stacking_refresh(it->data);
+    }
+
+    if (previous < num_containers)
+        XUnmapWindow(obt_display, containers[previous]);
+
+    grab_server(FALSE);
+}
+
+gboolean screen_use_containers(void)
+{
+    return use_containers;
+}
+
+Window screen_container(guint desktop)
+{
+    if (!use_containers)
+        return obt_root(ob_screen);
+    if (desktop == DESKTOP_ALL)
+        desktop = screen_desktop;
+    g_assert(desktop < num_containers);
+    return containers[desktop];
+}
+
+void screen_update_background(void)
+{
+    /* the frames cover most of it, but the root's new background needs to
+       show through the rest.  the other containers will be repainted when
+       they are mapped */
+    if (use_containers && screen_desktop < num_containers)
+        XClearWindow(obt_display, containers[screen_desktop]);
+}
+
 void screen_set_num_desktops(guint num)
 {
     gulong *viewport;
@@ -516,13 +648,16 @@ void screen_set_num_desktops(guint num)
 
     if (screen_num_desktops == num) return;
 
+    /* make containers for new desktops before anything goes in them */
+    if (num > num_containers)
+        containers_resize(num);
+
     screen_num_desktops = num;
-    OBT_PROP_SET32(obt_root(ob_screen), NET_NUMBER_OF_DESKTOPS, CARDINAL, num);
+    PUBLISH_SET32(NET_NUMBER_OF_DESKTOPS, CARDINAL, num);
 
     /* set the viewport hint */
     viewport = g_new0(gulong, num * 2);
-    OBT_PROP_SETA32(obt_root(ob_screen),
-                    NET_DESKTOP_VIEWPORT, CARDINAL, viewport, num * 2);
+    PUBLISH_SETA32(NET_DESKTOP_VIEWPORT, CARDINAL, viewport, num * 2);
     g_free(viewport);
 
     /* the number of rows/columns will differ */
@@ -556,6 +691,10 @@ void screen_set_num_desktops(guint num)
     /* change our desktop if we're on one that no longer exists! */
     if (screen_desktop >= screen_num_desktops)
         screen_set_desktop(num - 1, TRUE);
+
+    /* the windows have been moved out of the containers for desktops that
+       are gone now */
+    containers_resize(num);
 }
 
 static void screen_fallback_focus(void)
@@ -611,6 +750,7 @@ void screen_set_desktop(guint num, gboolean dofocus)
     GList *it;
     guint previous;
     gulong ignore_start;
+    GTimer *timer;
 
     g_assert(num < screen_num_desktops);
 
@@ -619,7 +759,7 @@ void screen_set_desktop(guint num, gboolean dofocus)
 
     if (previous == num) return;
 
-    OBT_PROP_SET32(obt_root(ob_screen), NET_CURRENT_DESKTOP, CARDINAL, num);
+    PUBLISH_SET32(NET_CURRENT_DESKTOP, CARDINAL, num);
 
     /* This whole thing decides when/how to save the screen_last_desktop so
        that it can be restored later if you want */
@@ -697,9 +837,16 @@ void screen_set_desktop(guint num, gboolean dofocus)
     /* ignore enter events caused by the move */
     ignore_start = event_start_ignore_all_enters();
 
+    timer = g_timer_new();
+
     if (moveresize_client)
         client_set_desktop(moveresize_client, num, TRUE, FALSE);
 
+    /* with containers, the frames and client windows stay mapped and the
+       containers are what show and hide them.  the clients below only get
+       their visible flag changed */
+    containers_switch(previous);
+
     /* show windows before hiding the rest to lessen the enter/leave events */
 
     /* show windows from top to bottom */
@@ -734,6 +881,10 @@ void screen_set_desktop(guint num, gboolean dofocus)
 
     focus_cycle_addremove(NULL, TRUE);
 
+    ob_debug("Switched desktops in %.3f ms",
+             g_timer_elapsed(timer, NULL) * 1000);
+    g_timer_destroy(timer);
+
     event_end_ignore_all_enters(ignore_start);
 
     if (event_source_time() != CurrentTime)
@@ -1293,10 +1444,7 @@ void screen_show_desktop(ObScreenShowDestopMode show_mode, ObClient *show_only)
         }
     }
 
-    OBT_PROP_SET32(obt_root(ob_screen),
-                   NET_SHOWING_DESKTOP,
-                   CARDINAL,
-                   !!showing_after);
+    PUBLISH_SET32(NET_SHOWING_DESKTOP, CARDINAL, !!showing_after);
 }
 
 gboolean screen_showing_desktop()
@@ -1415,10 +1563,29 @@ static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
              (*xin_areas)[i].width, (*xin_areas)[i].height);
 }
 
-void screen_update_areas(void)
+/*! Set the legacy workarea hint to the union of all the monitors */
+static void set_workarea(gpointer data)
 {
     guint i;
     gulong *dims;
+
+    dims = g_new(gulong, 4 * screen_num_desktops);
+    for (i = 0; i < screen_num_desktops; ++i) {
+        Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
+        dims[i*4+0] = area->x;
+        dims[i*4+1] = area->y;
+        dims[i*4+2] = area->width;
+        dims[i*4+3] = area->height;
+        g_slice_free(Rect, area);
+    }
+
+    PUBLISH_SETA32(NET_WORKAREA, CARDINAL, dims, 4 * screen_num_desktops);
+
+    g_free(dims);
+}
+
+void screen_update_areas(void)
+{
     GList *it, *onscreen;
 
     /* collect the clients that are on screen */
@@ -1485,25 +1652,12 @@ void screen_update_areas(void)
     VALIDATE_STRUTS(struts_bottom, bottom,
                     monitor_area[screen_num_monitors].height / 2);
 
-    dims = g_new(gulong, 4 * screen_num_desktops);
-    for (i = 0; i < screen_num_desktops; ++i) {
-        Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
-        dims[i*4+0] = area->x;
-        dims[i*4+1] = area->y;
-        dims[i*4+2] = area->width;
-        dims[i*4+3] = area->height;
-        g_slice_free(Rect, area);
-    }
-
-    /* set the legacy workarea hint to the union of all the monitors */
-    OBT_PROP_SETA32(obt_root(ob_screen), NET_WORKAREA, CARDINAL,
-                    dims, 4 * screen_num_desktops);
+    /* the hint only needs to be set once for several strut changes */
+    event_defer(set_workarea, NULL);
 
     /* the area has changed, adjust all the windows if they need it */
     for (it = onscreen; it; it = g_list_next(it))
         client_reconfigure(it->data, FALSE);
-
-    g_free(dims);
 }
 
 #if 0
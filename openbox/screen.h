@@ -69,6 +69,17 @@ void screen_shutdown(gboolean reconfig);
 /*! Figure out the new size of the screen and adjust stuff for it */
 void screen_resize(void);
 
+/*! Returns TRUE if the windows on each desktop are kept in a container window
+  for the desktop */
+gboolean screen_use_containers(void);
+/*! Returns the window that frames on the desktop should be children of.  This
+  is the root window when containers are not in use.  For DESKTOP_ALL it is
+  the current desktop's container. */
+Window screen_container(guint desktop);
+/*! Repaint the background of the current desktop's container after the root
+  window's background changed */
+void screen_update_background(void);
+
 /*! Change the number of available desktops */
 void screen_set_num_desktops(guint num);
 /*! Change the current desktop */
@@ -25,6 +25,7 @@
 #include "frame.h"
 #include "window.h"
 #include "event.h"
+#include "publish.h"
 #include "debug.h"
 #include "dock.h"
 #include "config.h"
@@ -37,7 +38,7 @@ GList  *stacking_list_tail = NULL;
   raised during focus cycling */
 static gboolean pause_changes = FALSE;
 
-void stacking_set_list(void)
+static void stacking_set_list_now(gpointer data)
 {
     Window *windows = NULL;
     GList *it;
@@ -58,12 +59,64 @@ void stacking_set_list(void)
         }
     }
 
-    OBT_PROP_SETA32(obt_root(ob_screen), NET_CLIENT_LIST_STACKING, WINDOW,
-                    (gulong*)windows, i);
+    PUBLISH_SETA32(NET_CLIENT_LIST_STACKING, WINDOW, (gulong*)windows, i);
 
     g_free(windows);
 }
 
+void stacking_set_list(void)
+{
+    /* each restack in a batch of events would set the list again */
+    event_defer(stacking_set_list_now, NULL);
+}
+
+/*! Restack the windows in the list, which are in the stacking list starting at
+  first.  Windows can only be stacked against their siblings, so when frames
+  are in desktop containers, the windows are put below the nearest window
+  above them that has the same parent.  The other containers are left
+  alone. */
+static void restack_siblings(GList *wins, GList *first)
+{
+    Window *win, root = obt_root(ob_screen);
+    GList *it;
+    GSList *parents = NULL, *pit;
+    gint i;
+
+    /* find the windows that these are stacked in */
+    for (it = wins; it; it = g_list_next(it)) {
+        Window p = window_parent(it->data);
+        if (!g_slist_find(parents, GUINT_TO_POINTER(p)))
+            parents = g_slist_prepend(parents, GUINT_TO_POINTER(p));
+    }
+
+    win = g_new(Window, g_list_length(wins) + 1);
+    for (pit = parents; pit; pit = g_slist_next(pit)) {
+        Window p = GPOINTER_TO_UINT(pit->data);
+
+        /* find the window to put them under */
+        win[0] = p == root ? screen_support_win : None;
+        for (it = g_list_previous(first); it; it = g_list_previous(it))
+            if (window_parent(it->data) == p) {
+                win[0] = window_top(it->data);
+                break;
+            }
+
+        for (i = 1, it = wins; it; it = g_list_next(it))
+            if (window_parent(it->data) == p)
+                win[i++] = window_top(it->data);
+
+        if (win[0] != None)
+            XRestackWindows(obt_display, win, i);
+        else {
+            /* they go at the top of their container */
+            XRaiseWindow(obt_display, win[1]);
+            XRestackWindows(obt_display, win + 1, i - 1);
+        }
+    }
+    g_slist_free(parents);
+    g_free(win);
+}
+
 static void do_restack(GList *wins, GList *before)
 {
     GList *it;
@@ -109,7 +162,11 @@ static void do_restack(GList *wins, GList *before)
     }
 #endif
 
-    if (!pause_changes)
+    if (pause_changes)
+        ;
+    else if (screen_use_containers())
+        restack_siblings(wins, g_list_find(stacking_list, wins->data));
+    else
         XRestackWindows(obt_display, win, i);
     g_free(win);
 
@@ -137,7 +194,11 @@ void stacking_temp_raise(ObWindow *window)
 
     win[1] = window_top(window);
     start = event_start_ignore_all_enters();
-    XRestackWindows(obt_display, win, 2);
+    if (screen_use_containers())
+        /* the internal windows are above all of the containers already */
+        XRaiseWindow(obt_display, win[1]);
+    else
+        XRestackWindows(obt_display, win, 2);
     event_end_ignore_all_enters(start);
 
     pause_changes = TRUE;
@@ -150,18 +211,37 @@ void stacking_restore(void)
     gint i;
     gulong start;
 
-    win = g_new(Window, g_list_length(stacking_list) + 1);
-    win[0] = screen_support_win;
-    for (i = 1, it = stacking_list; it; ++i, it = g_list_next(it))
-        win[i] = window_top(it->data);
     start = event_start_ignore_all_enters();
-    XRestackWindows(obt_display, win, i);
+    if (screen_use_containers())
+        restack_siblings(stacking_list, stacking_list);
+    else {
+        win = g_new(Window, g_list_length(stacking_list) + 1);
+        win[0] = screen_support_win;
+        for (i = 1, it = stacking_list; it; ++i, it = g_list_next(it))
+            win[i] = window_top(it->data);
+        XRestackWindows(obt_display, win, i);
+        g_free(win);
+    }
     event_end_ignore_all_enters(start);
-    g_free(win);
 
     pause_changes = FALSE;
 }
 
+void stacking_refresh(ObWindow *window)
+{
+    GList *it, *wins;
+
+    if (pause_changes || !screen_use_containers()) return;
+
+    /* it is put back in its place among its new siblings, which are already
+       in order */
+    if ((it = g_list_find(stacking_list, window))) {
+        wins = g_list_append(NULL, window);
+        restack_siblings(wins, it);
+        g_list_free(wins);
+    }
+}
+
 static void do_raise(GList *wins)
 {
     GList *it;
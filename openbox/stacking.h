@@ -60,6 +60,10 @@ void stacking_temp_raise(struct _ObWindow *window);
 /*! Restores any temporarily raised windows to their correct place */
 void stacking_restore(void);
 
+/*! Put the window in its place in the stacking order after it has been moved
+  into another desktop container */
+void stacking_refresh(struct _ObWindow *window);
+
 /*! Lowers a window below all others in its stacking layer */
 void stacking_lower(struct _ObWindow *window);
 
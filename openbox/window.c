@@ -29,24 +29,109 @@
 #include "obt/prop.h"
 #include "obt/xqueue.h"
 
-static GHashTable *window_map;
+/*! The smallest number of slots in the window map, a power of two */
+#define WINDOW_MAP_MIN_BITS 8
 
-static guint window_hash(Window *w) { return *w; }
-static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
+typedef struct _ObWindowEntry ObWindowEntry;
+
+struct _ObWindowEntry {
+    Window xwin; /* None for an empty slot */
+    ObWindowClass type;
+    gpointer data;
+};
+
+/*! Every window that we own or manage, for finding what an event is for.
+  This is an open addressing table with linear probing, so a lookup for a
+  window that isn't in it, which is most events on other windows, stops at
+  the first empty slot. */
+static ObWindowEntry *window_map = NULL;
+static guint window_map_bits = 0;
+static guint window_map_count = 0;
+
+#define WINDOW_MAP_SIZE (1u << window_map_bits)
+#define WINDOW_MAP_MASK (WINDOW_MAP_SIZE - 1)
+
+guint window_hash(Window *w) { return *w; }
+gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
+
+/*! The slot to start looking for the window in.  XIDs from one client only
+  differ in their low bits, so spread them out with a multiplicative hash. */
+static inline guint window_slot(Window xwin)
+{
+    return (guint)(((guint64)xwin * G_GUINT64_CONSTANT(0x9e3779b97f4a7c15))
+                   >> (64 - window_map_bits));
+}
+
+static ObWindowEntry* window_lookup(Window xwin)
+{
+    guint i;
+
+    for (i = window_slot(xwin); window_map[i].xwin != None;
+         i = (i + 1) & WINDOW_MAP_MASK)
+    {
+        if (window_map[i].xwin == xwin)
+            return &window_map[i];
+    }
+    return NULL;
+}
+
+static void window_map_resize(guint bits)
+{
+    ObWindowEntry *old = window_map;
+    guint i, oldsize = old ? WINDOW_MAP_SIZE : 0;
+
+    window_map_bits = bits;
+    window_map = g_new0(ObWindowEntry, WINDOW_MAP_SIZE);
+
+    for (i = 0; i < oldsize; ++i)
+        if (old[i].xwin != None) {
+            guint j = window_slot(old[i].xwin);
+            while (window_map[j].xwin != None)
+                j = (j + 1) & WINDOW_MAP_MASK;
+            window_map[j] = old[i];
+        }
+    g_free(old);
+}
+
+static void window_insert(Window xwin, ObWindowClass type, gpointer data)
+{
+    ObWindowEntry *e;
+    guint i;
+
+    g_assert(xwin != None);
+
+    if ((e = window_lookup(xwin))) {
+        e->type = type;
+        e->data = data;
+        return;
+    }
+
+    /* keep it at most 3/4 full so the probes stay short */
+    if ((window_map_count + 1) * 4 > WINDOW_MAP_SIZE * 3)
+        window_map_resize(window_map_bits + 1);
+
+    for (i = window_slot(xwin); window_map[i].xwin != None;
+         i = (i + 1) & WINDOW_MAP_MASK);
+    window_map[i].xwin = xwin;
+    window_map[i].type = type;
+    window_map[i].data = data;
+    ++window_map_count;
+}
 
 void window_startup(gboolean reconfig)
 {
     if (reconfig) return;
 
-    window_map = g_hash_table_new((GHashFunc)window_hash,
-                                  (GEqualFunc)window_comp);
+    window_map_count = 0;
+    window_map_resize(WINDOW_MAP_MIN_BITS);
 }
 
 void window_shutdown(gboolean reconfig)
 {
     if (reconfig) return;
 
-    g_hash_table_destroy(window_map);
+    g_free(window_map);
+    window_map = NULL;
 }
 
 Window window_top(ObWindow *self)
@@ -62,6 +147,8 @@ Window window_top(ObWindow *self)
         return WINDOW_AS_INTERNAL(self)->window;
     case OB_WINDOW_CLASS_PROMPT:
         return WINDOW_AS_PROMPT(self)->super.window;
+    case OB_WINDOW_CLASS_DOCKAPP:
+        break;
     }
     g_assert_not_reached();
     return None;
@@ -79,6 +166,7 @@ ObStackingLayer window_layer(ObWindow *self)
         return OB_STACKING_LAYER_INTERNAL;
     case OB_WINDOW_CLASS_PROMPT:
         /* not used directly for stacking, prompts are managed as clients */
+    case OB_WINDOW_CLASS_DOCKAPP:
         g_assert_not_reached();
         break;
     }
@@ -86,22 +174,83 @@ ObStackingLayer window_layer(ObWindow *self)
     return None;
 }
 
+Window window_parent(ObWindow *self)
+{
+    switch (self->type) {
+    case OB_WINDOW_CLASS_DOCK:
+        return WINDOW_AS_DOCK(self)->parent;
+    case OB_WINDOW_CLASS_CLIENT:
+        return WINDOW_AS_CLIENT(self)->frame->parent;
+    case OB_WINDOW_CLASS_MENUFRAME:
+    case OB_WINDOW_CLASS_INTERNAL:
+    case OB_WINDOW_CLASS_PROMPT:
+        return obt_root(ob_screen);
+    case OB_WINDOW_CLASS_DOCKAPP:
+        break;
+    }
+    g_assert_not_reached();
+    return None;
+}
+
 ObWindow* window_find(Window xwin)
 {
-    return g_hash_table_lookup(window_map, &xwin);
+    ObWindowEntry *e = window_lookup(xwin);
+
+    if (e && e->type != OB_WINDOW_CLASS_DOCKAPP)
+        return e->data;
+    return NULL;
+}
+
+gpointer window_find_any(Window xwin, ObWindowClass *type)
+{
+    ObWindowEntry *e = window_lookup(xwin);
+
+    if (e) {
+        *type = e->type;
+        return e->data;
+    }
+    return NULL;
 }
 
 void window_add(Window *xwin, ObWindow *win)
 {
     g_assert(xwin != NULL);
     g_assert(win != NULL);
-    g_hash_table_insert(window_map, xwin, win);
+    window_insert(*xwin, win->type, win);
+}
+
+void window_add_dockapp(Window *xwin, struct _ObDockApp *app)
+{
+    g_assert(xwin != NULL);
+    g_assert(app != NULL);
+    window_insert(*xwin, OB_WINDOW_CLASS_DOCKAPP, app);
 }
 
 void window_remove(Window xwin)
 {
+    ObWindowEntry *e;
+    guint i, j;
+
     g_assert(xwin != None);
-    g_hash_table_remove(window_map, &xwin);
+
+    if (!(e = window_lookup(xwin))) return;
+
+    /* move later entries back into the hole if their probe sequence passes
+       through it, so that lookups never stop short of them */
+    i = e - window_map;
+    for (j = (i + 1) & WINDOW_MAP_MASK; window_map[j].xwin != None;
+         j = (j + 1) & WINDOW_MAP_MASK)
+    {
+        guint k = window_slot(window_map[j].xwin);
+
+        /* is k cyclically outside of (i, j] ? */
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+            window_map[i] = window_map[j];
+            i = j;
+        }
+    }
+    window_map[i].xwin = None;
+    --window_map_count;
 }
 
 void window_manage_all(void)
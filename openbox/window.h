@@ -32,7 +32,10 @@ typedef enum {
     OB_WINDOW_CLASS_DOCK,
     OB_WINDOW_CLASS_CLIENT,
     OB_WINDOW_CLASS_INTERNAL,
-    OB_WINDOW_CLASS_PROMPT
+    OB_WINDOW_CLASS_PROMPT,
+    /*! Dock apps are not ObWindows, they are only found with
+      window_find_any() */
+    OB_WINDOW_CLASS_DOCKAPP
 } ObWindowClass;
 
 /* In order to be an ObWindow, you need to make this struct the top of your
@@ -75,11 +78,22 @@ void window_shutdown(gboolean reconfig);
 
 Window          window_top  (ObWindow *self);
 ObStackingLayer window_layer(ObWindow *self);
+/*! The window that the top-level window is a child of */
+Window          window_parent(ObWindow *self);
 
 ObWindow* window_find  (Window xwin);
 void      window_add   (Window *xwin, ObWindow *win);
 void      window_remove(Window xwin);
 
+/*! Find what the window belongs to, of any class.  Returns NULL if the window
+  is not ours. */
+gpointer  window_find_any   (Window xwin, ObWindowClass *type);
+void      window_add_dockapp(Window *xwin, struct _ObDockApp *app);
+
+/*! Hash functions for tables keyed by a Window */
+guint     window_hash(Window *w);
+gboolean  window_comp(Window *w1, Window *w2);
+
 /* Internal openbox-owned windows like the alt-tab popup */
 struct _ObInternalWindow {
     ObWindowClass type;